@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+/**
+    @brief Helpers shared by the benchmark programs. Each
+    benchmark is its own binary, built with `make bench`.
+*/
+namespace bench {
+
+    using clock = std::chrono::steady_clock;
+
+    /**
+        @brief Runs @p body until at least @p min_time has
+        passed, after one warm-up run.
+
+        @returns The mean time of one run, in milliseconds.
+    */
+    template<class F>
+    double measure(F&& body, const std::chrono::milliseconds min_time = std::chrono::milliseconds(300)) {
+        body();
+
+        size_t runs = 0;
+        const clock::time_point start = clock::now();
+        clock::duration elapsed {};
+
+        do {
+            body();
+            runs++;
+            elapsed = clock::now() - start;
+        } while (elapsed < min_time);
+
+        return std::chrono::duration<double, std::milli>(elapsed).count() / runs;
+    }
+
+    /** Keeps the compiler from dropping work whose result is unused. */
+    template<class T>
+    void keep(const T& value) {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+}
@@ -0,0 +1,147 @@
+#include "bench.h"
+
+#include "buffers/memfd.h"
+#include "render/pixel.h"
+
+#include <utility>
+
+#include <sys/resource.h>
+
+/**
+    @brief Latency of the first frame drawn into a new
+    buffer, for each prefault and huge page mode: the time
+    to allocate the memfd, then to draw into it once, and
+    the page faults each step took. A second frame into the
+    same buffer shows the cost with every page already
+    resident. `backing` shows where the pages really came
+    from, since hugetlb falls back to normal pages when no
+    huge pages are reserved.
+*/
+
+namespace {
+    constexpr int RUNS = 20;
+
+    const char* to_str(const wl::memfd::prefault_mode mode) {
+        switch (mode) {
+            case wl::memfd::prefault_mode::none: return "none";
+            case wl::memfd::prefault_mode::map_populate: return "map_populate";
+            case wl::memfd::prefault_mode::populate_write: return "populate_write";
+            default: return "?";
+        }
+    }
+
+    const char* to_str(const wl::memfd::hugepage_mode mode) {
+        switch (mode) {
+            case wl::memfd::hugepage_mode::none: return "none";
+            case wl::memfd::hugepage_mode::transparent: return "transparent";
+            case wl::memfd::hugepage_mode::hugetlb: return "hugetlb";
+            default: return "?";
+        }
+    }
+
+    double since(const bench::clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(bench::clock::now() - start).count();
+    }
+
+    /** Minor and major page faults of the process so far. */
+    struct faults {
+        long minor = 0;
+        long major = 0;
+
+        static faults now() {
+            rusage usage {};
+            getrusage(RUSAGE_SELF, &usage);
+
+            return { .minor = usage.ru_minflt, .major = usage.ru_majflt };
+        }
+
+        faults operator-(const faults& other) const noexcept {
+            return { .minor = minor - other.minor, .major = major - other.major };
+        }
+
+        faults& operator+=(const faults& other) noexcept {
+            minor += other.minor;
+            major += other.major;
+            return *this;
+        }
+    };
+
+    void draw(const render::surface_view& view) {
+        render::fill_gradient(view, render::argb(255, 0, 0, 0), render::argb(255, 0, 0, 255), render::argb(255, 0, 255, 0));
+    }
+}
+
+int main() {
+    const std::pair<uint32_t, uint32_t> sizes[] = { { 1920, 1080 }, { 3840, 2160 } };
+
+    const wl::memfd::prefault_mode prefaults[] = {
+        wl::memfd::prefault_mode::none,
+        wl::memfd::prefault_mode::map_populate,
+        wl::memfd::prefault_mode::populate_write,
+    };
+
+    const wl::memfd::hugepage_mode hugepages[] = {
+        wl::memfd::hugepage_mode::none,
+        wl::memfd::hugepage_mode::transparent,
+        wl::memfd::hugepage_mode::hugetlb,
+    };
+
+    for (const auto& [width, height] : sizes) {
+        const size_t size = size_t(width) * height * 4;
+
+        std::printf("%ux%u, mean of %d buffers, ms and page faults (minor/major)\n", width, height, RUNS);
+        std::printf("%-15s %-12s %-8s %8s %8s %8s %8s %13s %13s\n", "prefault", "hugepages", "backing", "alloc", "first", "total", "second", "alloc faults", "first faults");
+
+        for (const wl::memfd::prefault_mode prefault : prefaults) {
+            for (const wl::memfd::hugepage_mode huge : hugepages) {
+                const wl::memfd::options options {
+                    .prefault = prefault,
+                    .hugepages = huge,
+                };
+
+                double alloc = 0;
+                double first = 0;
+                double second = 0;
+                faults alloc_faults;
+                faults first_faults;
+                int hugetlb_runs = 0;
+
+                for (int run = 0; run < RUNS; run++) {
+                    const faults before_alloc = faults::now();
+                    const bench::clock::time_point start = bench::clock::now();
+                    wl::memfd memory = wl::memfd::create(size, options);
+                    alloc += since(start);
+                    alloc_faults += faults::now() - before_alloc;
+
+                    if (memory.hugetlb()) {
+                        hugetlb_runs++;
+                    }
+
+                    const render::surface_view view { reinterpret_cast<uint32_t*>(memory.data()), width, height, width };
+
+                    const faults before_first = faults::now();
+                    const bench::clock::time_point first_start = bench::clock::now();
+                    draw(view);
+                    bench::keep(view.pixels[0]);
+                    first += since(first_start);
+                    first_faults += faults::now() - before_first;
+
+                    const bench::clock::time_point second_start = bench::clock::now();
+                    draw(view);
+                    bench::keep(view.pixels[0]);
+                    second += since(second_start);
+                }
+
+                const char* backing = hugetlb_runs == RUNS ? "hugetlb" : hugetlb_runs == 0 ? "normal" : "mixed";
+
+                std::printf("%-15s %-12s %-8s %8.3f %8.3f %8.3f %8.3f %7ld/%-5ld %7ld/%-5ld\n",
+                    to_str(prefault), to_str(huge), backing,
+                    alloc / RUNS, first / RUNS, (alloc + first) / RUNS, second / RUNS,
+                    alloc_faults.minor / RUNS, alloc_faults.major / RUNS,
+                    first_faults.minor / RUNS, first_faults.major / RUNS);
+            }
+        }
+
+        std::printf("\n");
+    }
+}
@@ -0,0 +1,122 @@
+#include "bench.h"
+
+#include "render/pixel.h"
+
+#include <cstring>
+#include <vector>
+
+/**
+    @brief Throughput of each pixel kernel at every
+    instruction set the CPU supports, next to the plain
+    loops they replaced.
+*/
+
+namespace {
+    constexpr uint32_t WIDTH = 1920;
+    constexpr uint32_t HEIGHT = 1080;
+    constexpr double PIXELS = double(WIDTH) * HEIGHT;
+
+    void report(const char* name, const char* variant, const double ms) {
+        std::printf("%-16s %-8s %8.3f ms %9.1f MPix/s\n", name, variant, ms, PIXELS / (ms * 1000.0));
+    }
+
+    /** The original framebuffer fill: column-major, float per channel. */
+    void old_gradient(uint8_t* data, const uint32_t width, const uint32_t height) {
+        for (int x = 0; x < width; x++) {
+            for (int y = 0; y < height; y++) {
+                uint8_t* pixel = data + ((y * width + x) * 4);
+                pixel[0] = ((float) x / width) * 255;
+                pixel[1] = ((float) y / height) * 255;
+                pixel[2] = 0;
+                pixel[3] = 255;
+            }
+        }
+    }
+
+    void old_fill(uint32_t* data, const size_t count, const uint32_t colour) {
+        for (size_t i = 0; i < count; i++) {
+            data[i] = colour;
+        }
+    }
+
+    void old_copy(uint32_t* dst, const uint32_t* src, const uint32_t width, const uint32_t height) {
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                dst[y * width + x] = src[y * width + x];
+            }
+        }
+    }
+
+    void old_convert(uint32_t* dst, const uint8_t* src, const size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            const uint8_t* p = src + i * 3;
+            dst[i] = render::argb(0xFF, p[2], p[1], p[0]);
+        }
+    }
+
+    void old_premultiply(uint32_t* data, const size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t a = data[i] >> 24;
+            const uint32_t r = ((data[i] >> 16) & 0xFF) * a / 255;
+            const uint32_t g = ((data[i] >> 8) & 0xFF) * a / 255;
+            const uint32_t b = (data[i] & 0xFF) * a / 255;
+            data[i] = render::argb(a, r, g, b);
+        }
+    }
+}
+
+int main() {
+    std::vector<uint32_t> dst(size_t(WIDTH) * HEIGHT);
+    std::vector<uint32_t> src(size_t(WIDTH) * HEIGHT);
+    std::vector<uint8_t> packed(size_t(WIDTH) * HEIGHT * 3);
+
+    for (size_t i = 0; i < src.size(); i++) {
+        src[i] = uint32_t(i * 2654435761u);
+    }
+
+    for (size_t i = 0; i < packed.size(); i++) {
+        packed[i] = uint8_t(i * 31);
+    }
+
+    const render::surface_view dst_view { dst.data(), WIDTH, HEIGHT, WIDTH };
+    const render::surface_view src_view { src.data(), WIDTH, HEIGHT, WIDTH };
+
+    std::printf("%ux%u, %s detected\n\n", WIDTH, HEIGHT, render::isa_to_str(render::active_isa()));
+
+    report("fill_solid", "old", bench::measure([&] { old_fill(dst.data(), dst.size(), 0xFF336699); bench::keep(dst[0]); }));
+    report("fill_gradient", "old", bench::measure([&] { old_gradient(reinterpret_cast<uint8_t*>(dst.data()), WIDTH, HEIGHT); bench::keep(dst[0]); }));
+    report("copy_rect", "old", bench::measure([&] { old_copy(dst.data(), src.data(), WIDTH, HEIGHT); bench::keep(dst[0]); }));
+    report("convert_rect_24", "old", bench::measure([&] { old_convert(dst.data(), packed.data(), dst.size()); bench::keep(dst[0]); }));
+    report("premultiply", "old", bench::measure([&] {
+        std::memcpy(dst.data(), src.data(), dst.size() * sizeof(uint32_t));
+        old_premultiply(dst.data(), dst.size());
+        bench::keep(dst[0]);
+    }));
+
+    const render::isa detected = render::active_isa();
+
+    for (const render::isa level : { render::isa::scalar, render::isa::sse2, render::isa::ssse3, render::isa::avx2 }) {
+        if (render::force_isa(level) != level) { continue; }
+
+        const char* variant = render::isa_to_str(level);
+        std::printf("\n");
+
+        report("fill_solid", variant, bench::measure([&] { render::fill_solid(dst_view, 0xFF336699); bench::keep(dst[0]); }));
+        report("fill_gradient", variant, bench::measure([&] {
+            render::fill_gradient(dst_view, render::argb(255, 0, 0, 0), render::argb(255, 0, 0, 255), render::argb(255, 0, 255, 0));
+            bench::keep(dst[0]);
+        }));
+        report("copy_rect", variant, bench::measure([&] { render::copy_rect(dst_view, src_view); bench::keep(dst[0]); }));
+        report("convert_rect_24", variant, bench::measure([&] {
+            render::convert_rect_24(dst_view, packed.data(), size_t(WIDTH) * 3, render::order24::bgr);
+            bench::keep(dst[0]);
+        }));
+        report("premultiply", variant, bench::measure([&] {
+            std::memcpy(dst.data(), src.data(), dst.size() * sizeof(uint32_t));
+            render::premultiply(dst_view);
+            bench::keep(dst[0]);
+        }));
+    }
+
+    render::force_isa(detected);
+}
@@ -0,0 +1,84 @@
+#include "bench.h"
+
+#include "render/pixel.h"
+#include "render/scale.h"
+#include "render/thread_pool.h"
+#include "render/tiles.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/**
+    @brief Time to draw a full window through the tile
+    renderer, for each render thread count. Draws what the
+    client does: a gradient with a scaled texture on top.
+*/
+
+namespace {
+    constexpr uint32_t WIDTH = 1920;
+    constexpr uint32_t HEIGHT = 1080;
+
+    constexpr uint32_t TEXTURE_WIDTH = 800;
+    constexpr uint32_t TEXTURE_HEIGHT = 600;
+}
+
+int main() {
+    std::vector<uint32_t> frame(size_t(WIDTH) * HEIGHT);
+    std::vector<uint32_t> texture(size_t(TEXTURE_WIDTH) * TEXTURE_HEIGHT);
+
+    for (size_t i = 0; i < texture.size(); i++) {
+        texture[i] = 0xFF000000 | uint32_t(i * 2654435761u);
+    }
+
+    const render::surface_view view { frame.data(), WIDTH, HEIGHT, WIDTH };
+    const render::surface_view source { texture.data(), TEXTURE_WIDTH, TEXTURE_HEIGHT, TEXTURE_WIDTH };
+
+    const render::rect target = render::fit(WIDTH, HEIGHT, TEXTURE_WIDTH, TEXTURE_HEIGHT);
+    const render::surface_view target_view = view.sub(target);
+    const render::filter filter = render::pick_filter(TEXTURE_WIDTH, TEXTURE_HEIGHT, target_view.width, target_view.height);
+
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned max_threads = std::max(4u, cores);
+
+    std::printf("%ux%u, %u tiles, %u cores\n\n", WIDTH, HEIGHT,
+        ((WIDTH + render::tile_renderer::TILE_SIZE - 1) / render::tile_renderer::TILE_SIZE) * ((HEIGHT + render::tile_renderer::TILE_SIZE - 1) / render::tile_renderer::TILE_SIZE),
+        cores);
+
+    double single = 0;
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        render::thread_pool pool(threads);
+        render::tile_renderer tiles(pool);
+        tiles.resize(WIDTH, HEIGHT);
+
+        const double ms = bench::measure([&] {
+            tiles.damage_all();
+            tiles.render(view, [&](const render::surface_view& tile, const render::rect& area) {
+                const render::rect overlap = area.intersect(target);
+
+                if (overlap != area) {
+                    render::fill_gradient(tile, area, WIDTH, HEIGHT, render::argb(255, 0, 0, 0), render::argb(255, 0, 0, 255), render::argb(255, 0, 255, 0));
+                }
+
+                if (overlap.empty()) { return; }
+
+                const render::rect clip {
+                    .x = overlap.x - target.x,
+                    .y = overlap.y - target.y,
+                    .width = overlap.width,
+                    .height = overlap.height,
+                };
+
+                render::scale(target_view, source, filter, clip);
+            });
+            bench::keep(frame[0]);
+        });
+
+        if (threads == 1) {
+            single = ms;
+        }
+
+        std::printf("%2u threads %8.3f ms/frame  %5.2fx\n", threads, ms, single / ms);
+    }
+}
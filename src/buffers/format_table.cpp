@@ -0,0 +1,69 @@
+#include "format_table.h"
+
+#include "shared_file.h"
+
+#include <stdexcept>
+#include <utility>
+
+#include <sys/mman.h>
+
+using namespace wl;
+
+format_table::format_table(const int fd, const size_t size) {
+    void* map = map_shared_file(fd, size);
+
+    if (map == MAP_FAILED) {
+        throw std::runtime_error("Failed to map dmabuf format table");
+    }
+
+    entries = static_cast<const entry*>(map);
+    length = size;
+}
+
+format_table::format_table(format_table&& other) noexcept {
+    *this = std::move(other);
+}
+
+format_table& format_table::operator=(format_table&& other) noexcept {
+    if (this == &other) { return *this; }
+
+    release();
+
+    entries = std::exchange(other.entries, nullptr);
+    length = std::exchange(other.length, 0);
+
+    return *this;
+}
+
+format_table::~format_table() {
+    release();
+}
+
+void format_table::release() noexcept {
+    if (entries) {
+        munmap(const_cast<entry*>(entries), length);
+        entries = nullptr;
+    }
+
+    length = 0;
+}
+
+size_t format_table::size() const noexcept {
+    return length / sizeof(entry);
+}
+
+bool format_table::empty() const noexcept {
+    return size() == 0;
+}
+
+const format_table::entry& format_table::operator[](const size_t index) const noexcept {
+    return entries[index];
+}
+
+const format_table::entry* format_table::begin() const noexcept {
+    return entries;
+}
+
+const format_table::entry* format_table::end() const noexcept {
+    return entries + size();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace wl {
+    /**
+        @brief The format/modifier table shared by a
+        linux-dmabuf feedback object.
+
+        The compositor sends the table as a file; it is
+        mapped read-only and read in place, never copied.
+        Tranches refer to its entries by index.
+    */
+    class format_table {
+        public:
+
+        /** One table entry, in the layout the compositor writes. */
+        struct entry {
+            uint32_t format;
+            uint32_t padding;
+            uint64_t modifier;
+        };
+
+        static_assert(sizeof(entry) == 16, "Format table entries are 16 bytes");
+
+        private:
+
+        const entry* entries = nullptr;
+        size_t length = 0;
+
+        void release() noexcept;
+
+        public:
+
+        format_table() = default;
+
+        /**
+            @brief Maps @p size bytes of @p fd. The fd is
+            closed either way; the mapping outlives it.
+
+            @throws std::runtime_error if the mapping fails.
+        */
+        format_table(int fd, size_t size);
+
+        format_table(const format_table&) = delete;
+        format_table& operator=(const format_table&) = delete;
+
+        format_table(format_table&& other) noexcept;
+        format_table& operator=(format_table&& other) noexcept;
+
+        ~format_table();
+
+        /** Number of entries. */
+        size_t size() const noexcept;
+
+        bool empty() const noexcept;
+
+        const entry& operator[](size_t index) const noexcept;
+
+        const entry* begin() const noexcept;
+        const entry* end() const noexcept;
+    };
+}
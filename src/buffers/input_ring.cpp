@@ -0,0 +1,88 @@
+#include "input_ring.h"
+
+#include <ctime>
+
+using namespace wl;
+
+int64_t input_clock::now() noexcept {
+    timespec time {};
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return int64_t(time.tv_sec) * 1'000'000'000 + time.tv_nsec;
+}
+
+int64_t input_clock::from_ms(const uint32_t time) noexcept {
+    const int64_t current = now();
+
+    // Wraps every ~49 days; the difference in 32 bits doesn't.
+    const int32_t age = static_cast<int32_t>(static_cast<uint32_t>(current / 1'000'000) - time);
+
+    if (age < 0 || age > MAX_AGE_MS) {
+        return current;
+    }
+
+    return current - int64_t(age) * 1'000'000;
+}
+
+int64_t input_clock::from_us(const uint64_t time) noexcept {
+    const int64_t current = now();
+    const int64_t age = current / 1'000 - static_cast<int64_t>(time);
+
+    if (age < 0 || age > MAX_AGE_MS * 1'000) {
+        return current;
+    }
+
+    return current - age * 1'000;
+}
+
+bool input_ring::push(const input_event& event) noexcept {
+    if (!ring.push(event)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    pushed.fetch_add(1, std::memory_order_relaxed);
+
+    // Only the producer writes it, so a plain compare is enough.
+    const size_t queued = ring.size();
+
+    if (queued > high_water.load(std::memory_order_relaxed)) {
+        high_water.store(queued, std::memory_order_relaxed);
+    }
+
+    return true;
+}
+
+bool input_ring::push(const input_event_type type, const uint32_t time, const uint32_t code, const uint8_t state, const float x, const float y) noexcept {
+    return push({
+        .time_ns = input_clock::from_ms(time),
+        .type = type,
+        .state = state,
+        .code = code,
+        .x = x,
+        .y = y,
+    });
+}
+
+bool input_ring::push_now(const input_event_type type, const uint32_t code, const uint8_t state, const float x, const float y) noexcept {
+    return push({
+        .time_ns = input_clock::now(),
+        .type = type,
+        .state = state,
+        .code = code,
+        .x = x,
+        .y = y,
+    });
+}
+
+bool input_ring::pop(input_event& event) noexcept {
+    return ring.pop(event);
+}
+
+input_ring::statistics input_ring::stats() const noexcept {
+    return {
+        .pushed = pushed.load(std::memory_order_relaxed),
+        .dropped = dropped.load(std::memory_order_relaxed),
+        .high_water = high_water.load(std::memory_order_relaxed),
+    };
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "ring.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace wl {
+
+    enum class input_event_type : uint8_t {
+        pointer_enter,
+        pointer_leave,
+        pointer_motion,
+        pointer_button,
+        /** `code` is the axis, `x` the scroll distance. */
+        pointer_axis,
+        /** Unaccelerated motion from zwp_relative_pointer_v1, in `x` and `y`. */
+        relative_motion,
+        pointer_locked,
+        pointer_unlocked,
+        pointer_confined,
+        pointer_unconfined,
+        key,
+    };
+
+    /**
+        @brief One input event, small enough that a cache line
+        holds more than two.
+    */
+    struct input_event {
+        /** CLOCK_MONOTONIC, in nanoseconds. */
+        int64_t time_ns = 0;
+        input_event_type type = input_event_type::pointer_motion;
+        /** Button or key state, as sent. */
+        uint8_t state = 0;
+        uint16_t reserved = 0;
+        /** Button, key or axis. */
+        uint32_t code = 0;
+        /** Surface position, delta or axis value. */
+        float x = 0;
+        float y = 0;
+    };
+
+    static_assert(sizeof(input_event) == 24);
+
+    /**
+        @brief Maps compositor event times onto
+        CLOCK_MONOTONIC.
+
+        Event times are milliseconds (or microseconds, for
+        relative motion) with an undefined base, which is
+        CLOCK_MONOTONIC on every compositor in practice. The
+        low bits of the current time are used to unwrap them.
+        Times more than `MAX_AGE_MS` away from now are taken
+        to be from another clock and replaced by the time of
+        receipt.
+    */
+    class input_clock {
+        public:
+
+        static constexpr int64_t MAX_AGE_MS = 10'000;
+
+        static int64_t now() noexcept;
+
+        static int64_t from_ms(uint32_t time) noexcept;
+        static int64_t from_us(uint64_t time) noexcept;
+    };
+
+    /**
+        @brief Lock-free queue of input events from the
+        protocol thread to one consumer thread.
+
+        Filled during dispatch, so consumers never call back
+        into the protocol thread. Events that don't fit are
+        dropped and counted rather than blocking dispatch.
+    */
+    class input_ring {
+        public:
+
+        static constexpr size_t CAPACITY = 1024;
+
+        struct statistics {
+            uint64_t pushed;
+            uint64_t dropped;
+            /** Most events ever queued at once. */
+            size_t high_water;
+        };
+
+        private:
+
+        spsc_ring<input_event, CAPACITY> ring;
+
+        std::atomic<uint64_t> pushed = 0;
+        std::atomic<uint64_t> dropped = 0;
+        std::atomic<size_t> high_water = 0;
+
+        public:
+
+        /** @brief Queues @p event. Protocol thread only. */
+        bool push(const input_event& event) noexcept;
+
+        /** @brief Queues an event timed in milliseconds, like most of wl_pointer and wl_keyboard. */
+        bool push(input_event_type type, uint32_t time, uint32_t code, uint8_t state, float x, float y) noexcept;
+
+        /** @brief Queues an event that carries no time of its own, timed now. */
+        bool push_now(input_event_type type, uint32_t code = 0, uint8_t state = 0, float x = 0, float y = 0) noexcept;
+
+        /** @brief Takes the oldest event. Consumer thread only. */
+        bool pop(input_event& event) noexcept;
+
+        /**
+            @brief Calls @p consume with every queued event,
+            oldest first. Consumer thread only.
+
+            @returns The number of events consumed.
+        */
+        template<class F>
+        size_t drain(F&& consume) {
+            size_t count = 0;
+            input_event event;
+
+            while (ring.pop(event)) {
+                consume(static_cast<const input_event&>(event));
+                count++;
+            }
+
+            return count;
+        }
+
+        /** Safe to call from any thread. */
+        statistics stats() const noexcept;
+    };
+}
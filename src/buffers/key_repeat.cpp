@@ -0,0 +1,92 @@
+#include "key_repeat.h"
+
+#include "input_ring.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+using namespace wl;
+
+key_repeat::key_repeat() {
+    timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    if (timer < 0) {
+        throw std::runtime_error("Failed to create key repeat timerfd");
+    }
+}
+
+key_repeat::~key_repeat() {
+    if (timer >= 0) {
+        close(timer);
+    }
+}
+
+void key_repeat::set_info(const int32_t rate, const int32_t delay) noexcept {
+    this->rate = rate > 0 ? std::min<int32_t>(rate, 1000) : 0;
+    this->delay = delay > 0 ? delay : 0;
+
+    if (this->rate == 0) {
+        cancel();
+    }
+}
+
+void key_repeat::press(const uint32_t key, const uint32_t time) noexcept {
+    if (rate == 0) { return; }
+
+    repeating = true;
+    held_key = key;
+    next_time = (uint64_t(time) + delay) * 1'000;
+
+    // Armed on the monotonic clock from the press itself, however late it was read.
+    const int64_t first = input_clock::from_ms(time) + int64_t(delay) * 1'000'000;
+    const int64_t interval = 1'000'000'000 / rate;
+
+    const itimerspec spec {
+        .it_interval = { .tv_sec = interval / 1'000'000'000, .tv_nsec = interval % 1'000'000'000 },
+        .it_value = { .tv_sec = first / 1'000'000'000, .tv_nsec = first % 1'000'000'000 },
+    };
+
+    timerfd_settime(timer, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void key_repeat::release(const uint32_t key) noexcept {
+    if (repeating && key == held_key) {
+        cancel();
+    }
+}
+
+void key_repeat::cancel() noexcept {
+    if (!repeating) { return; }
+
+    repeating = false;
+    disarm();
+}
+
+void key_repeat::disarm() noexcept {
+    const itimerspec spec {};
+    timerfd_settime(timer, 0, &spec, nullptr);
+
+    // Drops an expiration that was already pending.
+    expirations();
+}
+
+bool key_repeat::active() const noexcept {
+    return repeating;
+}
+
+int key_repeat::fd() const noexcept {
+    return timer;
+}
+
+uint64_t key_repeat::expirations() noexcept {
+    uint64_t count = 0;
+
+    if (read(timer, &count, sizeof(count)) != sizeof(count)) {
+        return 0;
+    }
+
+    return count;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+
+namespace wl {
+    /**
+        @brief Client-side key repeat, driven by a timerfd.
+
+        Wayland leaves key repeat to clients. The timer is
+        only armed while a repeating key is held, so an idle
+        keyboard costs no wakeups: wait on `fd()` next to the
+        display socket and call `dispatch()` when it is
+        readable.
+
+        Repeats are timed from the press, not from when the
+        timer fired, so a late wakeup still produces evenly
+        spaced event times.
+    */
+    class key_repeat {
+        public:
+
+        /** Used until the compositor sends repeat_info. */
+        static constexpr int32_t DEFAULT_RATE = 25;
+        static constexpr int32_t DEFAULT_DELAY = 600;
+
+        private:
+
+        int timer = -1;
+
+        int32_t rate = DEFAULT_RATE;
+        int32_t delay = DEFAULT_DELAY;
+
+        bool repeating = false;
+        uint32_t held_key = 0;
+        /** Time of the next repeat, in microseconds on the event clock. */
+        uint64_t next_time = 0;
+
+        void disarm() noexcept;
+
+        public:
+
+        /** @throws std::runtime_error if the timerfd can't be created. */
+        key_repeat();
+
+        key_repeat(const key_repeat&) = delete;
+        key_repeat& operator=(const key_repeat&) = delete;
+
+        ~key_repeat();
+
+        /**
+            @brief Applies a wl_keyboard.repeat_info event:
+            @p rate repeats per second after @p delay
+            milliseconds. A rate of 0 turns repeat off.
+        */
+        void set_info(int32_t rate, int32_t delay) noexcept;
+
+        /**
+            @brief Starts repeating @p key, pressed at event
+            time @p time, replacing any key already repeating.
+        */
+        void press(uint32_t key, uint32_t time) noexcept;
+
+        /** @brief Stops repeating if @p key is the repeating key. */
+        void release(uint32_t key) noexcept;
+
+        /** @brief Stops repeating, e.g. when focus is lost. */
+        void cancel() noexcept;
+
+        bool active() const noexcept;
+
+        int fd() const noexcept;
+
+        /**
+            @brief Calls @p emit with the key and event time
+            of every repeat that is due. Never blocks.
+
+            @returns The number of repeats emitted.
+        */
+        template<class F>
+        uint64_t dispatch(F&& emit) {
+            const uint64_t due = expirations();
+
+            for (uint64_t i = 0; i < due && repeating; i++) {
+                emit(held_key, static_cast<uint32_t>(next_time / 1'000));
+                next_time += 1'000'000 / rate;
+            }
+
+            return due;
+        }
+
+        private:
+
+        /** Reads and resets the timer's expiration count. */
+        uint64_t expirations() noexcept;
+    };
+}
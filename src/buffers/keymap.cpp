@@ -0,0 +1,1033 @@
+#include "keymap.h"
+
+#include "shared_file.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include <sys/mman.h>
+
+using namespace wl;
+
+namespace {
+
+    constexpr uint32_t REAL_MODIFIERS = 8;
+    constexpr uint32_t MAX_MODIFIERS = 32;
+
+    constexpr const char* REAL_MODIFIER_NAMES[REAL_MODIFIERS] = {
+        "Shift", "Lock", "Control", "Mod1", "Mod2", "Mod3", "Mod4", "Mod5",
+    };
+
+    /** Names of 0x20 to 0x7e; letters and digits are named after themselves. */
+    constexpr const char* ASCII_NAMES[] = {
+        "space", "exclam", "quotedbl", "numbersign", "dollar", "percent", "ampersand", "apostrophe",
+        "parenleft", "parenright", "asterisk", "plus", "comma", "minus", "period", "slash",
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        "colon", "semicolon", "less", "equal", "greater", "question", "at",
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        "bracketleft", "backslash", "bracketright", "asciicircum", "underscore", "grave",
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        "braceleft", "bar", "braceright", "asciitilde",
+    };
+
+    static_assert(std::size(ASCII_NAMES) == 0x7f - 0x20);
+
+    /** Names of 0xa0 to 0xff. */
+    constexpr const char* LATIN1_NAMES[] = {
+        "nobreakspace", "exclamdown", "cent", "sterling", "currency", "yen", "brokenbar", "section",
+        "diaeresis", "copyright", "ordfeminine", "guillemotleft", "notsign", "hyphen", "registered", "macron",
+        "degree", "plusminus", "twosuperior", "threesuperior", "acute", "mu", "paragraph", "periodcentered",
+        "cedilla", "onesuperior", "masculine", "guillemotright", "onequarter", "onehalf", "threequarters", "questiondown",
+        "Agrave", "Aacute", "Acircumflex", "Atilde", "Adiaeresis", "Aring", "AE", "Ccedilla",
+        "Egrave", "Eacute", "Ecircumflex", "Ediaeresis", "Igrave", "Iacute", "Icircumflex", "Idiaeresis",
+        "ETH", "Ntilde", "Ograve", "Oacute", "Ocircumflex", "Otilde", "Odiaeresis", "multiply",
+        "Oslash", "Ugrave", "Uacute", "Ucircumflex", "Udiaeresis", "Yacute", "THORN", "ssharp",
+        "agrave", "aacute", "acircumflex", "atilde", "adiaeresis", "aring", "ae", "ccedilla",
+        "egrave", "eacute", "ecircumflex", "ediaeresis", "igrave", "iacute", "icircumflex", "idiaeresis",
+        "eth", "ntilde", "ograve", "oacute", "ocircumflex", "otilde", "odiaeresis", "division",
+        "oslash", "ugrave", "uacute", "ucircumflex", "udiaeresis", "yacute", "thorn", "ydiaeresis",
+    };
+
+    static_assert(std::size(LATIN1_NAMES) == 0x100 - 0xa0);
+
+    struct named_keysym {
+        const char* name;
+        uint32_t keysym;
+    };
+
+    constexpr named_keysym KEYSYM_NAMES[] = {
+        { "NoSymbol", 0 }, { "VoidSymbol", 0xffffff },
+        { "quoteright", 0x27 }, { "quoteleft", 0x60 }, { "guillemetleft", 0xab }, { "guillemetright", 0xbb },
+        { "ordmasculine", 0xba }, { "Ooblique", 0xd8 }, { "oslash", 0xf8 },
+
+        { "BackSpace", 0xff08 }, { "Tab", 0xff09 }, { "Linefeed", 0xff0a }, { "Clear", 0xff0b },
+        { "Return", 0xff0d }, { "Pause", 0xff13 }, { "Scroll_Lock", 0xff14 }, { "Sys_Req", 0xff15 },
+        { "Escape", 0xff1b }, { "Multi_key", 0xff20 }, { "Delete", 0xffff },
+
+        { "Home", 0xff50 }, { "Left", 0xff51 }, { "Up", 0xff52 }, { "Right", 0xff53 }, { "Down", 0xff54 },
+        { "Prior", 0xff55 }, { "Page_Up", 0xff55 }, { "Next", 0xff56 }, { "Page_Down", 0xff56 },
+        { "End", 0xff57 }, { "Begin", 0xff58 },
+
+        { "Select", 0xff60 }, { "Print", 0xff61 }, { "Execute", 0xff62 }, { "Insert", 0xff63 },
+        { "Undo", 0xff65 }, { "Redo", 0xff66 }, { "Menu", 0xff67 }, { "Find", 0xff68 },
+        { "Cancel", 0xff69 }, { "Help", 0xff6a }, { "Break", 0xff6b }, { "Mode_switch", 0xff7e },
+        { "Num_Lock", 0xff7f },
+
+        { "KP_Space", 0xff80 }, { "KP_Tab", 0xff89 }, { "KP_Enter", 0xff8d },
+        { "KP_F1", 0xff91 }, { "KP_F2", 0xff92 }, { "KP_F3", 0xff93 }, { "KP_F4", 0xff94 },
+        { "KP_Home", 0xff95 }, { "KP_Left", 0xff96 }, { "KP_Up", 0xff97 }, { "KP_Right", 0xff98 },
+        { "KP_Down", 0xff99 }, { "KP_Prior", 0xff9a }, { "KP_Page_Up", 0xff9a }, { "KP_Next", 0xff9b },
+        { "KP_Page_Down", 0xff9b }, { "KP_End", 0xff9c }, { "KP_Begin", 0xff9d }, { "KP_Insert", 0xff9e },
+        { "KP_Delete", 0xff9f }, { "KP_Equal", 0xffbd }, { "KP_Multiply", 0xffaa }, { "KP_Add", 0xffab },
+        { "KP_Separator", 0xffac }, { "KP_Subtract", 0xffad }, { "KP_Decimal", 0xffae }, { "KP_Divide", 0xffaf },
+        { "KP_0", 0xffb0 }, { "KP_1", 0xffb1 }, { "KP_2", 0xffb2 }, { "KP_3", 0xffb3 }, { "KP_4", 0xffb4 },
+        { "KP_5", 0xffb5 }, { "KP_6", 0xffb6 }, { "KP_7", 0xffb7 }, { "KP_8", 0xffb8 }, { "KP_9", 0xffb9 },
+
+        { "Shift_L", 0xffe1 }, { "Shift_R", 0xffe2 }, { "Control_L", 0xffe3 }, { "Control_R", 0xffe4 },
+        { "Caps_Lock", 0xffe5 }, { "Shift_Lock", 0xffe6 }, { "Meta_L", 0xffe7 }, { "Meta_R", 0xffe8 },
+        { "Alt_L", 0xffe9 }, { "Alt_R", 0xffea }, { "Super_L", 0xffeb }, { "Super_R", 0xffec },
+        { "Hyper_L", 0xffed }, { "Hyper_R", 0xffee },
+
+        { "ISO_Lock", 0xfe01 }, { "ISO_Level2_Latch", 0xfe02 }, { "ISO_Level3_Shift", 0xfe03 },
+        { "ISO_Level3_Latch", 0xfe04 }, { "ISO_Level3_Lock", 0xfe05 }, { "ISO_Group_Shift", 0xff7e },
+        { "ISO_Next_Group", 0xfe08 }, { "ISO_Prev_Group", 0xfe0a }, { "ISO_First_Group", 0xfe0c },
+        { "ISO_Last_Group", 0xfe0e }, { "ISO_Level5_Shift", 0xfe11 }, { "ISO_Level5_Latch", 0xfe12 },
+        { "ISO_Level5_Lock", 0xfe13 }, { "ISO_Left_Tab", 0xfe20 },
+
+        { "dead_grave", 0xfe50 }, { "dead_acute", 0xfe51 }, { "dead_circumflex", 0xfe52 },
+        { "dead_tilde", 0xfe53 }, { "dead_macron", 0xfe54 }, { "dead_breve", 0xfe55 },
+        { "dead_abovedot", 0xfe56 }, { "dead_diaeresis", 0xfe57 }, { "dead_abovering", 0xfe58 },
+        { "dead_doubleacute", 0xfe59 }, { "dead_caron", 0xfe5a }, { "dead_cedilla", 0xfe5b },
+        { "dead_ogonek", 0xfe5c }, { "dead_iota", 0xfe5d },
+
+        { "XF86AudioLowerVolume", 0x1008ff11 }, { "XF86AudioMute", 0x1008ff12 },
+        { "XF86AudioRaiseVolume", 0x1008ff13 }, { "XF86AudioPlay", 0x1008ff14 },
+        { "XF86AudioStop", 0x1008ff15 }, { "XF86AudioPrev", 0x1008ff16 }, { "XF86AudioNext", 0x1008ff17 },
+    };
+
+    /** Keysyms that bind a virtual modifier to the real modifiers of their keys. */
+    constexpr named_keysym MODIFIER_KEYSYMS[] = {
+        { "NumLock", 0xff7f }, { "ScrollLock", 0xff14 },
+        { "Alt", 0xffe9 }, { "Alt", 0xffea }, { "Meta", 0xffe7 }, { "Meta", 0xffe8 },
+        { "Super", 0xffeb }, { "Super", 0xffec }, { "Hyper", 0xffed }, { "Hyper", 0xffee },
+        { "LevelThree", 0xfe03 }, { "LevelFive", 0xfe11 }, { "AltGr", 0xff7e },
+    };
+
+    bool equal_nocase(const std::string_view a, const std::string_view b) noexcept {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const char x, const char y) {
+            return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+        });
+    }
+
+    const std::unordered_map<std::string_view, uint32_t>& keysym_names() {
+        // Backs the names of F1 to F35.
+        static std::array<std::string, 36> function_names;
+
+        static const std::unordered_map<std::string_view, uint32_t> names = [] {
+            std::unordered_map<std::string_view, uint32_t> names;
+
+            for (uint32_t code = 0x20; code < 0x7f; code++) {
+                if (ASCII_NAMES[code - 0x20]) {
+                    names.emplace(ASCII_NAMES[code - 0x20], code);
+                }
+            }
+
+            for (uint32_t code = 0xa0; code <= 0xff; code++) {
+                names.emplace(LATIN1_NAMES[code - 0xa0], code);
+            }
+
+            for (const named_keysym& named : KEYSYM_NAMES) {
+                names.emplace(named.name, named.keysym);
+            }
+
+            for (uint32_t n = 1; n <= 35; n++) {
+                function_names[n] = "F" + std::to_string(n);
+                names.emplace(function_names[n], 0xffbd + n);
+            }
+
+            return names;
+        }();
+
+        return names;
+    }
+
+    uint32_t parse_hex(const std::string_view digits) noexcept {
+        uint32_t value = 0;
+
+        for (const char c : digits) {
+            const uint32_t digit = c >= '0' && c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+            value = value * 16 + digit;
+        }
+
+        return value;
+    }
+
+    uint32_t keysym_from_name(const std::string_view name) {
+        if (name.size() == 1 && ((name[0] >= 'a' && name[0] <= 'z') || (name[0] >= 'A' && name[0] <= 'Z'))) {
+            return static_cast<uint32_t>(name[0]);
+        }
+
+        // Unicode keysyms; Latin-1 code points are keysyms as they are.
+        if (name.size() >= 5 && name[0] == 'U' && std::all_of(name.begin() + 1, name.end(), [](const char c) { return std::isxdigit(static_cast<unsigned char>(c)); })) {
+            const uint32_t code_point = parse_hex(name.substr(1));
+            return code_point <= 0xff ? code_point : 0x01000000 | code_point;
+        }
+
+        const auto& names = keysym_names();
+        const auto found = names.find(name);
+
+        return found != names.end() ? found->second : keymap::NO_SYMBOL;
+    }
+
+    bool keypad(const uint32_t keysym) noexcept {
+        return keysym >= 0xff80 && keysym <= 0xffbd;
+    }
+
+    bool lower(const uint32_t keysym) noexcept {
+        return (keysym >= 'a' && keysym <= 'z') || (keysym >= 0xdf && keysym <= 0xff && keysym != 0xf7);
+    }
+
+    bool upper(const uint32_t keysym) noexcept {
+        return (keysym >= 'A' && keysym <= 'Z') || (keysym >= 0xc0 && keysym <= 0xde && keysym != 0xd7);
+    }
+
+    bool alphabetic(const uint32_t first, const uint32_t second) noexcept {
+        return lower(first) && upper(second);
+    }
+
+    enum class token_kind {
+        end,
+        identifier,
+        string,
+        key_name,
+        number,
+        punctuation,
+    };
+
+    struct token {
+        token_kind kind = token_kind::end;
+        std::string_view text;
+
+        bool is(const char c) const noexcept {
+            return kind == token_kind::punctuation && text[0] == c;
+        }
+
+        bool is(const std::string_view word) const noexcept {
+            return kind == token_kind::identifier && equal_nocase(text, word);
+        }
+    };
+
+    class lexer {
+        std::string_view source;
+        size_t position = 0;
+        std::optional<token> peeked;
+
+        void skip_space() noexcept {
+            while (position < source.size()) {
+                const char c = source[position];
+
+                if (c == '/' && position + 1 < source.size() && source[position + 1] == '/') {
+                    position = std::min(source.find('\n', position), source.size());
+                } else if (c == '#') {
+                    position = std::min(source.find('\n', position), source.size());
+                } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\0') {
+                    position++;
+                } else {
+                    return;
+                }
+            }
+        }
+
+        token scan() {
+            skip_space();
+
+            if (position >= source.size()) { return {}; }
+
+            const size_t start = position;
+            const char c = source[position];
+
+            const auto until = [&](const char end, const token_kind kind) {
+                while (++position < source.size() && source[position] != end) {
+                    if (source[position] == '\\') { position++; }
+                }
+
+                if (position >= source.size()) {
+                    throw std::runtime_error("Unterminated token in keymap");
+                }
+
+                position++;
+                return token { kind, source.substr(start + 1, position - start - 2) };
+            };
+
+            if (c == '"') { return until('"', token_kind::string); }
+            if (c == '<') { return until('>', token_kind::key_name); }
+
+            const auto is_word = [](const char next) {
+                return std::isalnum(static_cast<unsigned char>(next)) || next == '_';
+            };
+
+            if (is_word(c)) {
+                while (position < source.size() && is_word(source[position])) { position++; }
+
+                const std::string_view text = source.substr(start, position - start);
+                const bool number = c >= '0' && c <= '9';
+
+                return { number ? token_kind::number : token_kind::identifier, text };
+            }
+
+            position++;
+            return { token_kind::punctuation, source.substr(start, 1) };
+        }
+
+        public:
+
+        lexer(const std::string_view source) : source(source) {}
+
+        const token& peek() {
+            if (!peeked) { peeked = scan(); }
+            return *peeked;
+        }
+
+        token next() {
+            const token next = peek();
+            peeked.reset();
+            return next;
+        }
+
+        void expect(const char c) {
+            if (!next().is(c)) {
+                throw std::runtime_error(std::string("Expected '") + c + "' in keymap");
+            }
+        }
+
+        /** Skips the rest of a statement, up to and including its ';'. */
+        void skip_statement() {
+            int depth = 0;
+
+            while (peek().kind != token_kind::end) {
+                if (depth == 0 && peek().is('}')) { return; }
+
+                const token skipped = next();
+
+                if (skipped.is('{') || skipped.is('[') || skipped.is('(')) { depth++; }
+                if (skipped.is('}') || skipped.is(']') || skipped.is(')')) { depth--; }
+                if (depth == 0 && skipped.is(';')) { return; }
+            }
+        }
+
+        /** Skips one item of a list, up to but not including its ',' or closing '}'. */
+        void skip_item() {
+            int depth = 0;
+
+            while (peek().kind != token_kind::end) {
+                if (depth == 0 && (peek().is(',') || peek().is('}') || peek().is(';'))) { return; }
+
+                const token skipped = next();
+
+                if (skipped.is('{') || skipped.is('[') || skipped.is('(')) { depth++; }
+                if (skipped.is('}') || skipped.is(']') || skipped.is(')')) { depth--; }
+            }
+        }
+
+        /** Skips a braced block; the '{' must be next. */
+        void skip_block() {
+            expect('{');
+            int depth = 1;
+
+            while (depth > 0) {
+                const token skipped = next();
+
+                if (skipped.kind == token_kind::end) {
+                    throw std::runtime_error("Unterminated block in keymap");
+                }
+
+                if (skipped.is('{')) { depth++; }
+                if (skipped.is('}')) { depth--; }
+            }
+        }
+    };
+
+    uint32_t parse_number(const std::string_view text) {
+        if (text.size() > 2 && text[0] == '0' && (text[1] | 0x20) == 'x') {
+            return parse_hex(text.substr(2));
+        }
+
+        uint32_t value = 0;
+
+        for (const char c : text) {
+            if (c < '0' || c > '9') {
+                throw std::runtime_error("Invalid number in keymap");
+            }
+
+            value = value * 10 + (c - '0');
+        }
+
+        return value;
+    }
+
+    /** `Level3`, `level3` or `3`, zero-based. */
+    uint32_t parse_index(const token& token, const std::string_view prefix) {
+        std::string_view text = token.text;
+
+        if (token.kind == token_kind::identifier) {
+            if (text.size() <= prefix.size() || !equal_nocase(text.substr(0, prefix.size()), prefix)) {
+                throw std::runtime_error("Invalid index in keymap");
+            }
+
+            text = text.substr(prefix.size());
+        }
+
+        const uint32_t index = parse_number(text);
+
+        if (index == 0) {
+            throw std::runtime_error("Invalid index in keymap");
+        }
+
+        return index - 1;
+    }
+
+    /** A keymap as written, before modifiers are resolved. */
+    struct source_keymap {
+        struct type {
+            std::string_view name;
+            uint32_t modifiers = 0;
+            std::vector<std::pair<uint32_t, uint32_t>> map;
+        };
+
+        struct key {
+            uint32_t keycode = 0;
+            std::array<std::vector<uint32_t>, keymap::MAX_GROUPS> groups;
+            std::array<std::string_view, keymap::MAX_GROUPS> types;
+            /** Virtual modifiers the key binds, over `modifiers`. */
+            uint32_t virtual_modifiers = 0;
+            std::optional<bool> repeat;
+        };
+
+        /** Real modifiers first, then virtual ones in the order they appear. */
+        std::vector<std::string_view> modifiers { std::begin(REAL_MODIFIER_NAMES), std::end(REAL_MODIFIER_NAMES) };
+        std::vector<std::optional<uint8_t>> explicit_masks = std::vector<std::optional<uint8_t>>(REAL_MODIFIERS);
+
+        std::unordered_map<std::string_view, uint32_t> keycodes;
+        std::unordered_map<std::string_view, std::string_view> aliases;
+
+        std::vector<type> types;
+        std::vector<key> keys;
+
+        /** Real modifier index and key code, or keysym if `by_keysym`. */
+        struct modmap_entry {
+            uint32_t modifier;
+            uint32_t value;
+            bool by_keysym;
+        };
+
+        std::vector<modmap_entry> modmap;
+
+        uint32_t modifier_index(const std::string_view name) {
+            for (uint32_t i = 0; i < modifiers.size(); i++) {
+                if (equal_nocase(modifiers[i], name)) { return i; }
+            }
+
+            if (modifiers.size() == MAX_MODIFIERS) {
+                throw std::runtime_error("Too many modifiers in keymap");
+            }
+
+            modifiers.push_back(name);
+            explicit_masks.emplace_back();
+            return modifiers.size() - 1;
+        }
+
+        std::optional<uint32_t> keycode(std::string_view name) const {
+            for (int depth = 0; depth < 4; depth++) {
+                if (const auto found = keycodes.find(name); found != keycodes.end()) {
+                    return found->second;
+                }
+
+                const auto alias = aliases.find(name);
+
+                if (alias == aliases.end()) { break; }
+
+                name = alias->second;
+            }
+
+            return std::nullopt;
+        }
+
+        /** `Shift+LevelThree`, `None` or `all`, over `modifiers`. */
+        uint32_t parse_modifiers(lexer& lexer) {
+            uint32_t mask = 0;
+
+            while (true) {
+                const token name = lexer.next();
+
+                if (name.kind == token_kind::number) {
+                    // Only written for explicit virtual modifier mappings.
+                    mask |= parse_number(name.text);
+                } else if (name.is("none")) {
+                } else if (name.is("all")) {
+                    mask = ~0u;
+                } else if (name.kind == token_kind::identifier) {
+                    mask |= 1u << modifier_index(name.text);
+                } else {
+                    throw std::runtime_error("Invalid modifier in keymap");
+                }
+
+                if (!lexer.peek().is('+') && !lexer.peek().is('|')) { return mask; }
+
+                lexer.next();
+            }
+        }
+
+        void parse_virtual_modifiers(lexer& lexer) {
+            while (!lexer.peek().is(';')) {
+                const token name = lexer.next();
+
+                if (name.kind != token_kind::identifier) {
+                    throw std::runtime_error("Invalid virtual modifier in keymap");
+                }
+
+                const uint32_t index = modifier_index(name.text);
+
+                if (lexer.peek().is('=')) {
+                    lexer.next();
+                    explicit_masks[index] = static_cast<uint8_t>(parse_modifiers(lexer));
+                }
+
+                if (lexer.peek().is(',')) { lexer.next(); }
+            }
+
+            lexer.next();
+        }
+
+        void parse_keycodes(lexer& lexer) {
+            while (!lexer.peek().is('}')) {
+                const token first = lexer.next();
+
+                if (first.kind == token_kind::key_name && lexer.peek().is('=')) {
+                    lexer.next();
+                    keycodes[first.text] = parse_number(lexer.next().text);
+                    lexer.expect(';');
+                } else if (first.is("alias")) {
+                    const token alias = lexer.next();
+                    lexer.expect('=');
+                    aliases[alias.text] = lexer.next().text;
+                    lexer.expect(';');
+                } else if (first.kind == token_kind::end) {
+                    throw std::runtime_error("Unterminated xkb_keycodes");
+                } else {
+                    lexer.skip_statement();
+                }
+            }
+        }
+
+        void parse_types(lexer& lexer) {
+            while (!lexer.peek().is('}')) {
+                const token first = lexer.next();
+
+                if (first.is("virtual_modifiers")) {
+                    parse_virtual_modifiers(lexer);
+                } else if (first.is("type")) {
+                    type type { .name = lexer.next().text, .modifiers = 0, .map = {} };
+                    lexer.expect('{');
+
+                    while (!lexer.peek().is('}')) {
+                        const token field = lexer.next();
+
+                        if (field.is("modifiers")) {
+                            lexer.expect('=');
+                            type.modifiers = parse_modifiers(lexer);
+                            lexer.expect(';');
+                        } else if (field.is("map")) {
+                            lexer.expect('[');
+                            const uint32_t modifiers = parse_modifiers(lexer);
+                            lexer.expect(']');
+                            lexer.expect('=');
+                            type.map.emplace_back(modifiers, parse_index(lexer.next(), "level"));
+                            lexer.expect(';');
+                        } else if (field.kind == token_kind::end) {
+                            throw std::runtime_error("Unterminated key type");
+                        } else {
+                            lexer.skip_statement();
+                        }
+                    }
+
+                    lexer.expect('}');
+                    lexer.expect(';');
+                    types.push_back(std::move(type));
+                } else if (first.kind == token_kind::end) {
+                    throw std::runtime_error("Unterminated xkb_types");
+                } else {
+                    lexer.skip_statement();
+                }
+            }
+        }
+
+        std::vector<uint32_t> parse_symbol_list(lexer& lexer) {
+            std::vector<uint32_t> symbols;
+
+            lexer.expect('[');
+
+            while (!lexer.peek().is(']')) {
+                const token symbol = lexer.next();
+
+                if (symbol.is('{')) {
+                    // Several keysyms on one level; only the first is kept.
+                    const token first = lexer.next();
+                    symbols.push_back(first.kind == token_kind::number ? parse_number(first.text) : keysym_from_name(first.text));
+
+                    while (!lexer.next().is('}')) {}
+                } else if (symbol.kind == token_kind::number) {
+                    // Single digits are the digit keysyms, like xkbcomp reads them.
+                    const uint32_t value = parse_number(symbol.text);
+                    symbols.push_back(value < 10 && symbol.text.size() == 1 ? '0' + value : value);
+                } else if (symbol.kind == token_kind::identifier) {
+                    symbols.push_back(keysym_from_name(symbol.text));
+                } else {
+                    throw std::runtime_error("Invalid keysym in keymap");
+                }
+
+                if (lexer.peek().is(',')) { lexer.next(); }
+            }
+
+            lexer.expect(']');
+            return symbols;
+        }
+
+        void parse_key(lexer& lexer) {
+            const token name = lexer.next();
+            const std::optional<uint32_t> code = keycode(name.text);
+
+            key key;
+            uint32_t next_group = 0;
+
+            lexer.expect('{');
+
+            while (!lexer.peek().is('}')) {
+                if (lexer.peek().is('[')) {
+                    std::vector<uint32_t> symbols = parse_symbol_list(lexer);
+
+                    if (next_group < keymap::MAX_GROUPS) {
+                        key.groups[next_group++] = std::move(symbols);
+                    }
+                } else {
+                    const token field = lexer.next();
+
+                    std::optional<uint32_t> group;
+
+                    if ((field.is("symbols") || field.is("type")) && lexer.peek().is('[')) {
+                        lexer.next();
+                        group = parse_index(lexer.next(), "group");
+                        lexer.expect(']');
+                    }
+
+                    if (field.is("symbols")) {
+                        lexer.expect('=');
+                        std::vector<uint32_t> symbols = parse_symbol_list(lexer);
+                        const uint32_t index = group.value_or(next_group);
+
+                        if (index < keymap::MAX_GROUPS) {
+                            key.groups[index] = std::move(symbols);
+                            next_group = std::max(next_group, index + 1);
+                        }
+                    } else if (field.is("type")) {
+                        lexer.expect('=');
+                        const std::string_view type = lexer.next().text;
+
+                        if (group) {
+                            if (*group < keymap::MAX_GROUPS) { key.types[*group] = type; }
+                        } else {
+                            key.types.fill(type);
+                        }
+                    } else if (field.is("vmods") || field.is("virtualmods") || field.is("virtualmodifiers")) {
+                        lexer.expect('=');
+                        key.virtual_modifiers |= parse_modifiers(lexer);
+                    } else if (field.is("repeat") || field.is("repeats")) {
+                        lexer.expect('=');
+                        const token value = lexer.next();
+                        key.repeat = value.is("yes") || value.is("true") || value.is("on") || (value.kind == token_kind::number && value.text != "0");
+                    } else if (field.kind == token_kind::end) {
+                        throw std::runtime_error("Unterminated key in keymap");
+                    } else {
+                        lexer.skip_item();
+                    }
+                }
+
+                if (lexer.peek().is(',')) { lexer.next(); }
+            }
+
+            lexer.expect('}');
+            lexer.expect(';');
+
+            // Keys the keycodes section didn't name can't be pressed.
+            if (code) {
+                key.keycode = *code;
+                keys.push_back(std::move(key));
+            }
+        }
+
+        void parse_modifier_map(lexer& lexer) {
+            const uint32_t modifier = modifier_index(lexer.next().text);
+
+            if (modifier >= REAL_MODIFIERS) {
+                lexer.skip_statement();
+                return;
+            }
+
+            lexer.expect('{');
+
+            while (!lexer.peek().is('}')) {
+                const token entry = lexer.next();
+
+                if (entry.kind == token_kind::key_name) {
+                    if (const std::optional<uint32_t> code = keycode(entry.text)) {
+                        modmap.push_back({ modifier, *code, false });
+                    }
+                } else if (entry.kind == token_kind::identifier) {
+                    modmap.push_back({ modifier, keysym_from_name(entry.text), true });
+                } else if (entry.kind == token_kind::end) {
+                    throw std::runtime_error("Unterminated modifier_map");
+                }
+
+                if (lexer.peek().is(',')) { lexer.next(); }
+            }
+
+            lexer.expect('}');
+            lexer.expect(';');
+        }
+
+        void parse_symbols(lexer& lexer) {
+            while (!lexer.peek().is('}')) {
+                const token first = lexer.next();
+
+                if (first.is("key")) {
+                    parse_key(lexer);
+                } else if (first.is("modifier_map") || first.is("modmap") || first.is("mod_map")) {
+                    parse_modifier_map(lexer);
+                } else if (first.is("virtual_modifiers")) {
+                    parse_virtual_modifiers(lexer);
+                } else if (first.kind == token_kind::end) {
+                    throw std::runtime_error("Unterminated xkb_symbols");
+                } else {
+                    lexer.skip_statement();
+                }
+            }
+        }
+
+        void parse(const std::string_view text) {
+            lexer lexer(text);
+
+            while (lexer.peek().kind != token_kind::end) {
+                const token first = lexer.next();
+
+                if (first.is("xkb_keymap")) {
+                    if (lexer.peek().kind == token_kind::string) { lexer.next(); }
+                    lexer.expect('{');
+                    continue;
+                }
+
+                if (first.kind != token_kind::identifier) { continue; }
+
+                const bool keycodes = first.is("xkb_keycodes");
+                const bool types = first.is("xkb_types");
+                const bool symbols = first.is("xkb_symbols");
+
+                if (lexer.peek().kind == token_kind::string) { lexer.next(); }
+
+                if (!lexer.peek().is('{')) { continue; }
+
+                if (!keycodes && !types && !symbols) {
+                    // Compatibility maps and geometry don't affect keysyms.
+                    lexer.skip_block();
+                    continue;
+                }
+
+                lexer.expect('{');
+
+                if (keycodes) { parse_keycodes(lexer); }
+                if (types) { parse_types(lexer); }
+                if (symbols) { parse_symbols(lexer); }
+
+                lexer.expect('}');
+            }
+        }
+    };
+
+    /** The type xkbcomp picks for a key without one. */
+    std::string_view implicit_type(const std::vector<uint32_t>& symbols) noexcept {
+        const uint32_t first = symbols.size() > 0 ? symbols[0] : keymap::NO_SYMBOL;
+        const uint32_t second = symbols.size() > 1 ? symbols[1] : keymap::NO_SYMBOL;
+
+        if (symbols.size() <= 1) { return "ONE_LEVEL"; }
+
+        if (symbols.size() == 2) {
+            if (alphabetic(first, second)) { return "ALPHABETIC"; }
+            if (keypad(first) || keypad(second)) { return "KEYPAD"; }
+            return "TWO_LEVEL";
+        }
+
+        const uint32_t third = symbols[2];
+        const uint32_t fourth = symbols.size() > 3 ? symbols[3] : keymap::NO_SYMBOL;
+
+        if (alphabetic(first, second)) {
+            return alphabetic(third, fourth) ? "FOUR_LEVEL_ALPHABETIC" : "FOUR_LEVEL_SEMIALPHABETIC";
+        }
+
+        if (keypad(first) || keypad(second)) { return "FOUR_LEVEL_KEYPAD"; }
+
+        return "FOUR_LEVEL";
+    }
+}
+
+uint8_t keymap::key_type::level(const uint8_t state) const noexcept {
+    const uint8_t masked = state & modifiers;
+
+    for (const entry& entry : entries) {
+        if (entry.modifiers == masked) { return entry.level; }
+    }
+
+    return 0;
+}
+
+keymap::keymap(const int fd, const size_t size) {
+    void* map = map_shared_file(fd, size);
+
+    if (map == MAP_FAILED) {
+        throw std::runtime_error("Failed to map keymap");
+    }
+
+    text = static_cast<const char*>(map);
+    length = size;
+}
+
+keymap::keymap(keymap&& other) noexcept {
+    *this = std::move(other);
+}
+
+keymap& keymap::operator=(keymap&& other) noexcept {
+    if (this == &other) { return *this; }
+
+    release();
+
+    text = std::exchange(other.text, nullptr);
+    length = std::exchange(other.length, 0);
+    compiled = std::exchange(other.compiled, false);
+    keycodes = std::exchange(other.keycodes, 0);
+    symbols = std::move(other.symbols);
+    key_types = std::move(other.key_types);
+    group_counts = std::move(other.group_counts);
+    repeating_keys = std::move(other.repeating_keys);
+    types = std::move(other.types);
+    modifiers = std::move(other.modifiers);
+    type_levels = std::move(other.type_levels);
+    mod_state = other.mod_state;
+    group = other.group;
+
+    return *this;
+}
+
+keymap::~keymap() {
+    release();
+}
+
+void keymap::release() noexcept {
+    if (text) {
+        munmap(const_cast<char*>(text), length);
+        text = nullptr;
+    }
+
+    length = 0;
+}
+
+void keymap::parse() {
+    if (compiled) { return; }
+
+    if (!text) {
+        throw std::runtime_error("No keymap to parse");
+    }
+
+    // The keymap is NUL terminated; the terminator isn't text.
+    source_keymap source;
+    source.parse(std::string_view(text, strnlen(text, length)));
+
+    keycodes = 0;
+
+    for (const source_keymap::key& key : source.keys) {
+        keycodes = std::max(keycodes, key.keycode + 1);
+    }
+
+    // Real modifiers each key sets.
+    std::vector<uint8_t> modmap(keycodes, 0);
+
+    for (const source_keymap::modmap_entry& entry : source.modmap) {
+        for (const source_keymap::key& key : source.keys) {
+            const bool matches = entry.by_keysym
+                ? std::any_of(key.groups.begin(), key.groups.end(), [&](const std::vector<uint32_t>& symbols) { return !symbols.empty() && symbols[0] == entry.value; })
+                : key.keycode == entry.value;
+
+            if (matches) {
+                modmap[key.keycode] |= 1u << entry.modifier;
+            }
+        }
+    }
+
+    // Virtual modifiers map to the real modifiers of the keys bound to them,
+    // either explicitly or, as the default compatibility map does, by keysym.
+    modifiers.clear();
+
+    for (uint32_t index = 0; index < source.modifiers.size(); index++) {
+        uint8_t mask = index < REAL_MODIFIERS ? 1u << index : 0;
+
+        if (source.explicit_masks[index]) {
+            mask = *source.explicit_masks[index];
+        } else if (index >= REAL_MODIFIERS) {
+            for (const source_keymap::key& key : source.keys) {
+                if (key.virtual_modifiers & (1u << index)) {
+                    mask |= modmap[key.keycode];
+                }
+            }
+
+            if (mask == 0) {
+                for (const named_keysym& binding : MODIFIER_KEYSYMS) {
+                    if (!equal_nocase(binding.name, source.modifiers[index])) { continue; }
+
+                    for (const source_keymap::key& key : source.keys) {
+                        if (!key.groups[0].empty() && key.groups[0][0] == binding.keysym) {
+                            mask |= modmap[key.keycode];
+                        }
+                    }
+                }
+            }
+        }
+
+        modifiers.push_back({ std::string(source.modifiers[index]), mask });
+    }
+
+    const auto resolve = [&](const uint32_t mask) {
+        uint8_t real = 0;
+
+        for (uint32_t index = 0; index < modifiers.size(); index++) {
+            if (mask & (1u << index)) { real |= modifiers[index].mask; }
+        }
+
+        return real;
+    };
+
+    // Index 0 is the fallback for keys whose type is missing: always level 1.
+    types.assign(1, { .name = "", .modifiers = 0, .entries = {} });
+
+    for (const source_keymap::type& source_type : source.types) {
+        key_type type { .name = std::string(source_type.name), .modifiers = resolve(source_type.modifiers), .entries = {} };
+
+        for (const auto& [mask, level] : source_type.map) {
+            const uint8_t real = resolve(mask);
+
+            // Entries of unbound virtual modifiers can never match.
+            if (mask != 0 && real == 0) { continue; }
+            if (level >= MAX_LEVELS) { continue; }
+
+            type.entries.push_back({ real, static_cast<uint8_t>(level) });
+        }
+
+        types.push_back(std::move(type));
+    }
+
+    const auto type_index = [&](const std::string_view name) -> uint8_t {
+        for (size_t index = 1; index < types.size() && index <= UINT8_MAX; index++) {
+            if (types[index].name == name) { return index; }
+        }
+
+        return 0;
+    };
+
+    symbols.assign(size_t(keycodes) * MAX_GROUPS * MAX_LEVELS, NO_SYMBOL);
+    key_types.assign(size_t(keycodes) * MAX_GROUPS, 0);
+    group_counts.assign(keycodes, 0);
+    repeating_keys.assign(keycodes, false);
+
+    for (const source_keymap::key& key : source.keys) {
+        uint8_t groups = 0;
+
+        for (uint32_t index = 0; index < MAX_GROUPS; index++) {
+            const std::vector<uint32_t>& levels = key.groups[index];
+
+            if (levels.empty()) { continue; }
+
+            groups = index + 1;
+
+            const std::string_view type = key.types[index].empty() ? implicit_type(levels) : key.types[index];
+            key_types[size_t(key.keycode) * MAX_GROUPS + index] = type_index(type);
+
+            const size_t base = (size_t(key.keycode) * MAX_GROUPS + index) * MAX_LEVELS;
+            std::copy_n(levels.begin(), std::min<size_t>(levels.size(), MAX_LEVELS), symbols.begin() + base);
+        }
+
+        group_counts[key.keycode] = groups;
+        repeating_keys[key.keycode] = key.repeat.value_or(modmap[key.keycode] == 0);
+    }
+
+    type_levels.assign(types.size(), 0);
+    compiled = true;
+
+    set_modifiers(0, 0, 0, 0);
+
+    // Everything needed is in the tables now.
+    release();
+}
+
+bool keymap::parsed() const noexcept {
+    return compiled;
+}
+
+void keymap::set_modifiers(const uint32_t depressed, const uint32_t latched, const uint32_t locked, const uint32_t group) noexcept {
+    mod_state = static_cast<uint8_t>(depressed | latched | locked);
+    this->group = group;
+
+    for (size_t index = 0; index < types.size(); index++) {
+        type_levels[index] = types[index].level(mod_state);
+    }
+}
+
+uint32_t keymap::keysym(const uint32_t key) const noexcept {
+    const uint32_t keycode = key + EVDEV_OFFSET;
+
+    if (keycode >= keycodes || group_counts[keycode] == 0) { return NO_SYMBOL; }
+
+    // Groups past the key's last wrap around.
+    const uint32_t key_group = group % group_counts[keycode];
+    const size_t slot = size_t(keycode) * MAX_GROUPS + key_group;
+
+    return symbols[slot * MAX_LEVELS + type_levels[key_types[slot]]];
+}
+
+bool keymap::repeats(const uint32_t key) const noexcept {
+    const uint32_t keycode = key + EVDEV_OFFSET;
+
+    return keycode < keycodes && repeating_keys[keycode];
+}
+
+uint32_t keymap::keysym(const uint32_t key, const uint32_t group, const uint32_t level) const noexcept {
+    const uint32_t keycode = key + EVDEV_OFFSET;
+
+    if (keycode >= keycodes || group >= MAX_GROUPS || level >= MAX_LEVELS) { return NO_SYMBOL; }
+
+    return symbols[(size_t(keycode) * MAX_GROUPS + group) * MAX_LEVELS + level];
+}
+
+uint8_t keymap::modifier_mask(const std::string_view name) const noexcept {
+    for (const modifier& modifier : modifiers) {
+        if (equal_nocase(modifier.name, name)) { return modifier.mask; }
+    }
+
+    return 0;
+}
+
+bool keymap::active(const uint8_t mask) const noexcept {
+    return (mod_state & mask) != 0;
+}
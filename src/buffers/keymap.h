@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace wl {
+    /**
+        @brief An XKB keymap sent by wl_keyboard, compiled
+        into flat tables for translating key codes to
+        keysyms.
+
+        The compositor sends the keymap as a file. It is
+        mapped read-only and only parsed when `parse()` is
+        called, straight from the mapping. Only what
+        translation needs is parsed: key codes, key types,
+        symbols and the modifier map. Compatibility maps and
+        geometry are skipped unread.
+
+        Translation is a table lookup: `set_modifiers()`
+        works out the shift level of every key type once per
+        modifier change, so `keysym()` only indexes
+        keycode × group × level.
+
+        Keysyms are known by name for ASCII, Latin-1, and
+        the function, keypad, modifier and dead keys; other
+        names resolve to `NO_SYMBOL`. Numeric and `Uxxxx`
+        keysyms are always understood.
+    */
+    class keymap {
+        public:
+
+        static constexpr uint32_t MAX_GROUPS = 4;
+        static constexpr uint32_t MAX_LEVELS = 8;
+
+        static constexpr uint32_t NO_SYMBOL = 0;
+
+        /** XKB key codes are evdev codes offset by 8. */
+        static constexpr uint32_t EVDEV_OFFSET = 8;
+
+        /** A key type with its modifiers reduced to real modifier masks. */
+        struct key_type {
+            std::string name;
+            /** The modifiers that select a level. */
+            uint8_t modifiers = 0;
+
+            struct entry {
+                uint8_t modifiers;
+                uint8_t level;
+            };
+
+            std::vector<entry> entries;
+
+            /** Level for the real modifiers @p state. */
+            uint8_t level(uint8_t state) const noexcept;
+        };
+
+        /** A named modifier, real or virtual, and the real modifiers it maps to. */
+        struct modifier {
+            std::string name;
+            uint8_t mask = 0;
+        };
+
+        private:
+
+        const char* text = nullptr;
+        size_t length = 0;
+
+        bool compiled = false;
+
+        uint32_t keycodes = 0;
+        /** [keycode][group][level] */
+        std::vector<uint32_t> symbols;
+        /** [keycode][group] → index into `types` */
+        std::vector<uint8_t> key_types;
+        /** [keycode] */
+        std::vector<uint8_t> group_counts;
+        /** [keycode] */
+        std::vector<bool> repeating_keys;
+
+        std::vector<key_type> types;
+        std::vector<modifier> modifiers;
+
+        /** Current level of each key type. */
+        std::vector<uint8_t> type_levels;
+        uint8_t mod_state = 0;
+        uint32_t group = 0;
+
+        void release() noexcept;
+
+        public:
+
+        keymap() = default;
+
+        /**
+            @brief Maps @p size bytes of @p fd. The fd is
+            closed either way; the mapping outlives it.
+
+            @throws std::runtime_error if the mapping fails.
+        */
+        keymap(int fd, size_t size);
+
+        keymap(const keymap&) = delete;
+        keymap& operator=(const keymap&) = delete;
+
+        keymap(keymap&& other) noexcept;
+        keymap& operator=(keymap&& other) noexcept;
+
+        ~keymap();
+
+        /**
+            @brief Compiles the mapped keymap into lookup
+            tables, then unmaps it. Does nothing if already
+            parsed. Can run on any thread.
+
+            @throws std::runtime_error if the keymap is
+            malformed.
+        */
+        void parse();
+
+        /** Whether `parse()` has completed. */
+        bool parsed() const noexcept;
+
+        /**
+            @brief Applies a wl_keyboard.modifiers event.
+            Costs one pass over the key types.
+        */
+        void set_modifiers(uint32_t depressed, uint32_t latched, uint32_t locked, uint32_t group) noexcept;
+
+        /**
+            @brief Keysym of evdev key code @p key under the
+            current modifiers, or `NO_SYMBOL`.
+        */
+        uint32_t keysym(uint32_t key) const noexcept;
+
+        /**
+            @brief Whether evdev key code @p key should
+            repeat while held. Modifier keys don't, unless
+            the keymap says otherwise.
+        */
+        bool repeats(uint32_t key) const noexcept;
+
+        /** Keysym of evdev key code @p key at a given group and level. */
+        uint32_t keysym(uint32_t key, uint32_t group, uint32_t level) const noexcept;
+
+        /**
+            @brief Real modifier mask of the modifier called
+            @p name, e.g. "Control" or "Alt". 0 if it is
+            unknown or unbound.
+        */
+        uint8_t modifier_mask(std::string_view name) const noexcept;
+
+        /** Whether any modifier in @p mask is active. */
+        bool active(uint8_t mask) const noexcept;
+    };
+}
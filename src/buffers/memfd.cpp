@@ -0,0 +1,204 @@
+#include "memfd.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifndef MADV_POPULATE_READ
+#define MADV_POPULATE_READ 22
+#endif
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+using namespace wl;
+
+namespace {
+
+    /** The default hugetlb page size on x86-64 and arm64. */
+    constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    size_t round_up(const size_t size, const size_t unit) {
+        return (size + unit - 1) / unit * unit;
+    }
+
+    /**
+        @brief Creates a memfd of @p length bytes and maps
+        it.
+
+        @returns -1 if any step fails.
+    */
+    int create_file(const unsigned int flags, const size_t length, const int map_flags, void*& map) {
+        const int fd = memfd_create("buffer", flags);
+
+        if (fd < 0) { return -1; }
+
+        if (ftruncate(fd, length) < 0) {
+            close(fd);
+            return -1;
+        }
+
+        map = mmap(nullptr, length, PROT_READ | PROT_WRITE, map_flags, fd, 0);
+
+        if (map == MAP_FAILED) {
+            close(fd);
+            return -1;
+        }
+
+        return fd;
+    }
+
+    void populate_write(uint8_t* const map, const size_t length, const size_t page) {
+        if (madvise(map, length, MADV_POPULATE_WRITE) == 0) { return; }
+
+        if (errno != EINVAL) { return; }
+
+        // Before 5.14: a write per page faults them all in now.
+        for (size_t offset = 0; offset < length; offset += page) {
+            *reinterpret_cast<volatile uint8_t*>(map + offset) = 0;
+        }
+    }
+
+    /** What `MAP_POPULATE` does, for part of a mapping. */
+    void populate_read(uint8_t* const map, const size_t length, const size_t page) {
+        if (madvise(map, length, MADV_POPULATE_READ) == 0) { return; }
+
+        if (errno != EINVAL) { return; }
+
+        for (size_t offset = 0; offset < length; offset += page) {
+            (void) *reinterpret_cast<volatile uint8_t*>(map + offset);
+        }
+    }
+}
+
+memfd memfd::create(const size_t size, const options& options) {
+    const size_t page = sysconf(_SC_PAGESIZE);
+    const bool large = size >= options.hugepage_threshold;
+    const unsigned int flags = MFD_CLOEXEC | (options.seal ? MFD_ALLOW_SEALING : 0);
+
+    const size_t prefault_size = options.prefault_size > 0 ? std::min(options.prefault_size, size) : size;
+    // MAP_POPULATE can only fault in the whole mapping.
+    const bool populate_all = options.prefault == prefault_mode::map_populate && prefault_size == size;
+
+    const int map_flags = MAP_SHARED | (populate_all ? MAP_POPULATE : 0);
+
+    memfd memory;
+    memory.length = size;
+    memory.mode = options.prefault;
+
+    void* map = nullptr;
+
+    // Creating the file works without reserved huge pages; mapping it doesn't.
+    if (large && options.hugepages == hugepage_mode::hugetlb) {
+        memory.mapped_length = round_up(size, HUGE_PAGE_SIZE);
+        memory.handle = create_file(flags | MFD_HUGETLB, memory.mapped_length, map_flags, map);
+        memory.huge = memory.handle >= 0;
+    }
+
+    if (memory.handle < 0) {
+        memory.mapped_length = round_up(size, page);
+        memory.handle = create_file(flags, memory.mapped_length, map_flags, map);
+    }
+
+    if (memory.handle < 0) {
+        throw std::runtime_error("Failed to create buffer file");
+    }
+
+    memory.pixels = static_cast<uint8_t*>(map);
+
+    if (options.seal && fcntl(memory.handle, F_ADD_SEALS, F_SEAL_SHRINK) < 0) {
+        throw std::runtime_error("Failed to seal buffer file");
+    }
+
+    // Only a hint; shmem THP also depends on the system's shmem_enabled setting.
+    if (large && options.hugepages == hugepage_mode::transparent) {
+        madvise(map, memory.mapped_length, MADV_HUGEPAGE);
+    }
+
+    memory.page_size = memory.huge ? HUGE_PAGE_SIZE : page;
+
+    if (populate_all) {
+        memory.populated = memory.mapped_length;
+    } else {
+        memory.prefault(prefault_size);
+    }
+
+    return memory;
+}
+
+memfd memfd::create(const size_t size) {
+    return create(size, options {});
+}
+
+memfd::memfd(memfd&& other) noexcept {
+    *this = std::move(other);
+}
+
+memfd& memfd::operator=(memfd&& other) noexcept {
+    if (this == &other) { return *this; }
+
+    release();
+
+    handle = std::exchange(other.handle, -1);
+    pixels = std::exchange(other.pixels, nullptr);
+    length = std::exchange(other.length, 0);
+    mapped_length = std::exchange(other.mapped_length, 0);
+    huge = std::exchange(other.huge, false);
+    mode = std::exchange(other.mode, prefault_mode::none);
+    page_size = std::exchange(other.page_size, 0);
+    populated = std::exchange(other.populated, 0);
+
+    return *this;
+}
+
+memfd::~memfd() {
+    release();
+}
+
+void memfd::release() noexcept {
+    if (pixels) {
+        munmap(pixels, mapped_length);
+        pixels = nullptr;
+    }
+
+    if (handle >= 0) {
+        close(handle);
+        handle = -1;
+    }
+}
+
+int memfd::fd() const noexcept {
+    return handle;
+}
+
+uint8_t* memfd::data() const noexcept {
+    return pixels;
+}
+
+size_t memfd::size() const noexcept {
+    return length;
+}
+
+bool memfd::hugetlb() const noexcept {
+    return huge;
+}
+
+void memfd::prefault(const size_t size) noexcept {
+    const size_t end = std::min(round_up(size, page_size), mapped_length);
+
+    if (mode == prefault_mode::none || end <= populated) { return; }
+
+    if (mode == prefault_mode::populate_write) {
+        populate_write(pixels + populated, end - populated, page_size);
+    } else {
+        populate_read(pixels + populated, end - populated, page_size);
+    }
+
+    populated = end;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace wl {
+    /**
+        @brief Shared memory for wl_shm pools: a memfd,
+        mapped for writing.
+
+        Mapping a fresh memfd is lazy, so the first frame
+        drawn into it takes a page fault per page touched.
+        `prefault` moves that cost to allocation time, and
+        huge pages cut the number of faults and TLB entries
+        for large surfaces.
+
+        Sealing against shrinking spares the compositor
+        from guarding its reads against SIGBUS.
+    */
+    class memfd {
+        public:
+
+        enum class prefault_mode {
+            /** Pages are faulted in on first access. */
+            none,
+            /** `MAP_POPULATE`; may only read-fault shared mappings. */
+            map_populate,
+            /**
+                `MADV_POPULATE_WRITE`, which prepares pages for
+                writing. Falls back to touching every page on
+                kernels older than 5.14.
+            */
+            populate_write,
+        };
+
+        enum class hugepage_mode {
+            none,
+            /** Asks for transparent huge pages with `MADV_HUGEPAGE`. */
+            transparent,
+            /**
+                Allocates from the hugetlb pool with
+                `MFD_HUGETLB`, falling back to normal pages if
+                no huge pages are reserved.
+            */
+            hugetlb,
+        };
+
+        struct options {
+            prefault_mode prefault = prefault_mode::populate_write;
+            hugepage_mode hugepages = hugepage_mode::transparent;
+
+            /** Smaller buffers always use normal pages. */
+            size_t hugepage_threshold = 4 * 1024 * 1024;
+
+            /**
+                Bytes from the start to prefault, 0 for all of
+                them. The rest can be prefaulted later with
+                `prefault`, so a pool reserved for larger
+                sizes only makes what is used resident.
+            */
+            size_t prefault_size = 0;
+
+            /** Adds `F_SEAL_SHRINK`. */
+            bool seal = true;
+        };
+
+        private:
+
+        int handle = -1;
+        uint8_t* pixels = nullptr;
+        size_t length = 0;
+        size_t mapped_length = 0;
+        bool huge = false;
+
+        prefault_mode mode = prefault_mode::none;
+        /** Granularity of faults: the page or huge page size. */
+        size_t page_size = 0;
+        /** Bytes from the start already prefaulted. */
+        size_t populated = 0;
+
+        memfd() = default;
+
+        void release() noexcept;
+
+        public:
+
+        /**
+            @brief Allocates and maps at least @p size
+            bytes.
+
+            @throws std::runtime_error if the memfd can't be
+            created or mapped. Prefaulting and huge pages are
+            best effort.
+        */
+        static memfd create(size_t size, const options& options);
+
+        static memfd create(size_t size);
+
+        memfd(const memfd&) = delete;
+        memfd& operator=(const memfd&) = delete;
+
+        memfd(memfd&& other) noexcept;
+        memfd& operator=(memfd&& other) noexcept;
+
+        ~memfd();
+
+        /** The memfd, to pass to wl_shm::create_pool. */
+        int fd() const noexcept;
+
+        uint8_t* data() const noexcept;
+
+        /** The size asked for. The file may be larger. */
+        size_t size() const noexcept;
+
+        /** Whether the memory came from the hugetlb pool. */
+        bool hugetlb() const noexcept;
+
+        /**
+            @brief Prefaults the first @p size bytes with the
+            mode the memory was created with, skipping what
+            already is. Best effort, like at creation.
+        */
+        void prefault(size_t size) noexcept;
+    };
+}
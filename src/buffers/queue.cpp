@@ -3,16 +3,44 @@
 #include <stdexcept>
 #include <sys/socket.h>
 #include <limits>
+#include <unistd.h>
 
 using namespace wl;
 
 void recv_queue::Recv(const wl_fd_t socket) {
-    const ssize_t new_size = recv(socket, *buffer.get(), PAGE_SIZE, 0);
+    alignas(cmsghdr) char cmsgbuf[CMSG_SPACE(sizeof(int) * MAX_FDS)];
+
+    struct iovec vec {
+        .iov_base = *buffer.get(),
+        .iov_len = PAGE_SIZE,
+    };
+
+    struct msghdr msg {
+        .msg_iov = &vec,
+        .msg_iovlen = 1,
+        .msg_control = cmsgbuf,
+        .msg_controllen = sizeof(cmsgbuf),
+    };
+
+    const ssize_t new_size = recvmsg(socket, &msg, MSG_CMSG_CLOEXEC);
 
     if (new_size < 0) {
         throw std::runtime_error("Failed to receive data");
     }
 
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) { continue; }
+
+        const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const int* const received = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+
+        fds.insert(fds.end(), received, received + count);
+    }
+
+    if (msg.msg_flags & MSG_CTRUNC) {
+        lumber::warn("[Wayland::WARN]: Received file descriptors were truncated.");
+    }
+
     if (new_size > std::numeric_limits<size_type>::max()) {
         throw std::runtime_error("Received more data than protocol allows");
     }
@@ -24,6 +52,16 @@ void recv_queue::Recv(const wl_fd_t socket) {
     current_size = new_size;
 }
 
+int recv_queue::TakeFD() {
+    if (fds.empty()) {
+        throw std::runtime_error("Event expected a file descriptor that was not received");
+    }
+
+    const int fd = fds.front();
+    fds.pop_front();
+    return fd;
+}
+
 recv_queue::iterator recv_queue::begin() const noexcept {
     return recv_queue::iterator(*buffer.get(), current_size);
 }
@@ -33,7 +71,9 @@ recv_queue::iterator recv_queue::end() const noexcept {
 }
 
 recv_queue::~recv_queue() {
-    
+    for (const int fd : fds) {
+        close(fd);
+    }
 }
 
 recv_queue::iterator::iterator(recv_queue::value_ptr buffer, size_type size)
@@ -90,7 +130,11 @@ void send_queue::AddFD(int data) noexcept {
 }
 
 wl_uint send_queue::Send(const wl_fd_t socket) {
-    char cmsgbuf[CMSG_SPACE(sizeof(int))];
+    if (fds.size() > MAX_FDS) {
+        throw std::runtime_error("Too many file descriptors queued for one send");
+    }
+
+    alignas(cmsghdr) char cmsgbuf[CMSG_SPACE(sizeof(int) * MAX_FDS)];
 
     struct iovec vec {
         .iov_base = buffer,
@@ -100,17 +144,19 @@ wl_uint send_queue::Send(const wl_fd_t socket) {
     struct msghdr msg {
         .msg_iov = &vec,
         .msg_iovlen = 1,
-        .msg_control = cmsgbuf,
-        .msg_controllen = CMSG_SPACE(sizeof(int)),
+        .msg_control = fds.empty() ? nullptr : cmsgbuf,
+        .msg_controllen = fds.empty() ? 0 : CMSG_SPACE(sizeof(int) * fds.size()),
     };
-    
-    struct cmsghdr* cmsg;
-    cmsg = CMSG_FIRSTHDR(&msg);
-    cmsg->cmsg_level = SOL_SOCKET;
-    cmsg->cmsg_type = SCM_RIGHTS;
-    cmsg->cmsg_len = CMSG_LEN(WL_FD_SIZE * fds.size());
-
-    memcpy(CMSG_DATA(cmsg), fds.data(), WL_FD_SIZE * fds.size());
+
+    if (!fds.empty()) {
+        struct cmsghdr* cmsg;
+        cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+
+        memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+    }
 
     if (sendmsg(socket, &msg, 0) != Offset()) {
         throw std::runtime_error("Failed to send command");
@@ -2,6 +2,7 @@
 
 #include "../wl_utils/wl_event.h"
 
+#include <deque>
 #include <memory>
 #include <span>
 #include <vector>
@@ -27,19 +28,35 @@ namespace wl {
 
         static constexpr size_type PAGE_SIZE = 4096;
 
+        /** Most file descriptors one receive can carry, as in libwayland. */
+        static constexpr size_t MAX_FDS = 28;
+
         const std::unique_ptr<value_ptr> buffer = std::make_unique<value_ptr>(static_cast<value_ptr>(malloc(PAGE_SIZE)));
         size_type current_size = 0;
+        std::deque<int> fds;
 
         public:
 
         /**
-            @brief Receive data.
+            @brief Receive data, along with any file
+            descriptors sent with it.
 
             Calling `Recv` invalidates any iterators pointing
             to this queue.
         */
         void Recv(const wl_fd_t socket);
 
+        /**
+            @brief Takes the oldest received file descriptor.
+
+            Descriptors arrive in the order of the events that
+            carry them, so each `fd` argument claims the next
+            one. The caller owns it.
+
+            @throws std::runtime_error if none was received.
+        */
+        int TakeFD();
+
         iterator begin() const noexcept;
         iterator end() const noexcept;
 
@@ -80,6 +97,9 @@ namespace wl {
 
         static constexpr size_type PAGE_SIZE = 4096;
 
+        /** Most file descriptors one send can carry, as in libwayland. */
+        static constexpr size_t MAX_FDS = 28;
+
         value_ptr buffer = static_cast<value_ptr>(malloc(PAGE_SIZE));
         size_type current_size = 0;
         value_ptr access_ptr = buffer;
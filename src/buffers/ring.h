@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace wl {
+    /**
+        @brief Lock-free ring buffer for handing values from
+        exactly one producer thread to exactly one consumer
+        thread.
+
+        Neither side ever blocks or takes a lock: `push` fails
+        when the ring is full and `pop` fails when it is empty.
+
+        @tparam Capacity Number of slots. Must be a power of
+        two.
+    */
+    template<class T, size_t Capacity>
+    class spsc_ring {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+        static constexpr size_t CACHE_LINE = 64;
+
+        std::array<T, Capacity> slots {};
+
+        /** Next slot to read. Written only by the consumer. */
+        alignas(CACHE_LINE) std::atomic<size_t> head = 0;
+        /** Next slot to write. Written only by the producer. */
+        alignas(CACHE_LINE) std::atomic<size_t> tail = 0;
+
+        public:
+
+        /**
+            @brief Appends @p value. Producer thread only.
+
+            @returns `false` if the ring is full.
+        */
+        bool push(const T& value) noexcept {
+            const size_t write = tail.load(std::memory_order_relaxed);
+
+            if (write - head.load(std::memory_order_acquire) == Capacity) {
+                return false;
+            }
+
+            slots[write & (Capacity - 1)] = value;
+            tail.store(write + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+            @brief Removes the oldest value into @p value.
+            Consumer thread only.
+
+            @returns `false` if the ring is empty.
+        */
+        bool pop(T& value) noexcept {
+            const size_t read = head.load(std::memory_order_relaxed);
+
+            if (read == tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+
+            value = slots[read & (Capacity - 1)];
+            head.store(read + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+            @brief Returns the number of queued values. Only
+            exact when called from one of the two threads
+            while the other is idle.
+        */
+        size_t size() const noexcept {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        }
+
+        bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        static constexpr size_t capacity() noexcept {
+            return Capacity;
+        }
+    };
+}
@@ -0,0 +1,12 @@
+#include "shared_file.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+void* wl::map_shared_file(const int fd, const size_t size) noexcept {
+    // MAP_PRIVATE is required since wl_keyboard version 7: the compositor may share one file with every client.
+    void* map = size ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+    close(fd);
+
+    return map;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+
+namespace wl {
+    /**
+        @brief Maps @p size bytes of a file the compositor
+        sent, such as a keymap or a format table, read-only.
+        @p fd is closed either way; the mapping outlives it.
+
+        @returns `nullptr` if @p size is 0, `MAP_FAILED` if
+        the mapping fails. Unmap with `munmap`.
+    */
+    void* map_shared_file(int fd, size_t size) noexcept;
+}
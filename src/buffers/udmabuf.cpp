@@ -0,0 +1,148 @@
+#include "udmabuf.h"
+
+#include <cerrno>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <linux/dma-buf.h>
+#include <linux/udmabuf.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace wl;
+
+namespace {
+
+    constexpr const char* UDMABUF_DEVICE = "/dev/udmabuf";
+
+    void sync(const int fd, const uint64_t flags) {
+        dma_buf_sync sync { .flags = flags };
+
+        while (ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync) < 0) {
+            if (errno != EINTR && errno != EAGAIN) {
+                throw std::runtime_error("Failed to sync dmabuf");
+            }
+        }
+    }
+}
+
+bool udmabuf::available() {
+    const int device = open(UDMABUF_DEVICE, O_RDWR | O_CLOEXEC);
+
+    if (device < 0) { return false; }
+
+    close(device);
+    return true;
+}
+
+udmabuf udmabuf::create(const size_t size) {
+    const size_t page = sysconf(_SC_PAGESIZE);
+
+    udmabuf buffer;
+    buffer.length = (size + page - 1) / page * page;
+
+    buffer.memfd = memfd_create("udmabuf", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+
+    if (buffer.memfd < 0) {
+        throw std::runtime_error("Failed to create udmabuf memfd");
+    }
+
+    if (ftruncate(buffer.memfd, buffer.length) < 0) {
+        throw std::runtime_error("Failed to size udmabuf memfd");
+    }
+
+    // udmabuf refuses memfds that could shrink under the device.
+    if (fcntl(buffer.memfd, F_ADD_SEALS, F_SEAL_SHRINK) < 0) {
+        throw std::runtime_error("Failed to seal udmabuf memfd");
+    }
+
+    const int device = open(UDMABUF_DEVICE, O_RDWR | O_CLOEXEC);
+
+    if (device < 0) {
+        throw std::runtime_error("Failed to open /dev/udmabuf");
+    }
+
+    udmabuf_create create {
+        .memfd = static_cast<uint32_t>(buffer.memfd),
+        .flags = UDMABUF_FLAGS_CLOEXEC,
+        .offset = 0,
+        .size = buffer.length,
+    };
+
+    buffer.dmabuf_fd = ioctl(device, UDMABUF_CREATE, &create);
+    close(device);
+
+    if (buffer.dmabuf_fd < 0) {
+        throw std::runtime_error("Failed to create udmabuf");
+    }
+
+    void* map = mmap(nullptr, buffer.length, PROT_READ | PROT_WRITE, MAP_SHARED, buffer.memfd, 0);
+
+    if (map == MAP_FAILED) {
+        throw std::runtime_error("Failed to map udmabuf memfd");
+    }
+
+    buffer.pixels = static_cast<uint8_t*>(map);
+
+    return buffer;
+}
+
+udmabuf::udmabuf(udmabuf&& other) noexcept {
+    *this = std::move(other);
+}
+
+udmabuf& udmabuf::operator=(udmabuf&& other) noexcept {
+    if (this == &other) { return *this; }
+
+    release();
+
+    memfd = std::exchange(other.memfd, -1);
+    dmabuf_fd = std::exchange(other.dmabuf_fd, -1);
+    pixels = std::exchange(other.pixels, nullptr);
+    length = std::exchange(other.length, 0);
+
+    return *this;
+}
+
+udmabuf::~udmabuf() {
+    release();
+}
+
+void udmabuf::release() noexcept {
+    if (pixels) {
+        munmap(pixels, length);
+        pixels = nullptr;
+    }
+
+    if (dmabuf_fd >= 0) {
+        close(dmabuf_fd);
+        dmabuf_fd = -1;
+    }
+
+    if (memfd >= 0) {
+        close(memfd);
+        memfd = -1;
+    }
+}
+
+int udmabuf::fd() const noexcept {
+    return dmabuf_fd;
+}
+
+uint8_t* udmabuf::data() const noexcept {
+    return pixels;
+}
+
+size_t udmabuf::size() const noexcept {
+    return length;
+}
+
+void udmabuf::begin_cpu_access() const {
+    sync(dmabuf_fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_WRITE);
+}
+
+void udmabuf::end_cpu_access() const {
+    sync(dmabuf_fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_WRITE);
+}
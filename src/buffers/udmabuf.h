@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace wl {
+    /**
+        @brief CPU-written pixel memory shared with the
+        compositor as a dmabuf.
+
+        The pixels live in a sealed memfd, which
+        `/dev/udmabuf` wraps into a dmabuf. The compositor
+        can then import the frame directly, e.g. as a GPU
+        texture, instead of copying it out of an shm pool.
+
+        Writes must be bracketed by `begin_cpu_access()` and
+        `end_cpu_access()` so the memory is coherent for the
+        device reading it.
+    */
+    class udmabuf {
+        int memfd = -1;
+        int dmabuf_fd = -1;
+
+        uint8_t* pixels = nullptr;
+        size_t length = 0;
+
+        udmabuf() = default;
+
+        void release() noexcept;
+
+        public:
+
+        /**
+            @brief Returns `true` if `/dev/udmabuf` can be
+            opened by this process.
+        */
+        static bool available();
+
+        /**
+            @brief Allocates at least @p size bytes, rounded
+            up to whole pages, and exports them as a dmabuf.
+
+            @throws std::runtime_error if any step fails.
+        */
+        static udmabuf create(size_t size);
+
+        udmabuf(const udmabuf&) = delete;
+        udmabuf& operator=(const udmabuf&) = delete;
+
+        udmabuf(udmabuf&& other) noexcept;
+        udmabuf& operator=(udmabuf&& other) noexcept;
+
+        ~udmabuf();
+
+        /** The dmabuf file descriptor, to pass to zwp::linux_dmabuf::params::add. */
+        int fd() const noexcept;
+
+        uint8_t* data() const noexcept;
+
+        size_t size() const noexcept;
+
+        /**
+            @brief Starts a CPU write; waits for the device
+            to finish reading the buffer.
+        */
+        void begin_cpu_access() const;
+
+        /**
+            @brief Ends a CPU write; flushes it for the
+            device.
+        */
+        void end_cpu_access() const;
+    };
+}
@@ -1,21 +1,33 @@
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <optional>
 
 #include <stdexcept>
 #include <sys/syscall.h>
 #include <thread>
 #include <unistd.h>
+#include <vector>
 #include <syscall.h>
 #include <sys/mman.h>
 #include <sys/un.h>
 #include <fcntl.h>
+#include <poll.h>
 
 #include "objects/buffer.h"
 #include "objects/linux-dma-buf.h"
 #include "objects/output.h"
+#include "objects/presentation.h"
+#include "objects/single_pixel_buffer.h"
+#include "objects/subsurface.h"
+#include "objects/viewporter.h"
+#include "objects/fractional_scale.h"
+#include "objects/pointer_constraints.h"
+#include "objects/relative_pointer.h"
 #include "objects/surface.h"
 #include "wl_utils/wl_array.h"
 #include "wl_utils/wl_enums.h"
@@ -31,206 +43,1126 @@
 #include "objects/compositor.h"
 #include "objects/shm.h"
 
-struct BMPImage {
+#include "buffers/input_ring.h"
+#include "buffers/memfd.h"
+#include "buffers/udmabuf.h"
+
+#include "render/bmp.h"
+#include "render/convert.h"
+#include "render/frame_clock.h"
+#include "render/frame_scheduler.h"
+#include "render/latency.h"
+#include "render/pipeline.h"
+#include "render/pixel.h"
+#include "render/region.h"
+#include "render/scale.h"
+#include "render/surface_hints.h"
+#include "render/thread_pool.h"
+#include "render/tiles.h"
 
-    const uint32_t width;
-    const uint32_t height;
-    uint8_t* data;
+/**
+    Use-case example
+*/
 
-    static BMPImage load(const std::string& path) {
-        const int file = open(path.c_str(), 0);
+render::bmp_image tex = render::bmp_image::load("linus.bmp");
 
-        if (file < 0) {
-            throw std::runtime_error("Failed to open file");
-        }
+render::thread_pool render_pool;
+render::tile_renderer tiles(render_pool);
 
-        lseek(file, 18, SEEK_SET);
-        char dimensions_data[2 * sizeof(uint32_t)];
-        read(file, dimensions_data, sizeof(dimensions_data));
+/**
+    Decoded copy of `tex`, only built once the window needs
+    the texture at a size other than its own.
+*/
+std::vector<uint32_t> tex_pixels;
 
-        const uint32_t width = *reinterpret_cast<uint32_t*>(dimensions_data);
-        const uint32_t height = *reinterpret_cast<uint32_t*>(dimensions_data + sizeof(uint32_t));
+/**
+    Returns the decoded copy of `tex`, decoding it on first
+    use. Called before tiles are scheduled, never from them.
+*/
+render::surface_view texture_pixels() {
+    const bool decoded = !tex_pixels.empty();
 
-        std::cout << "Width: " << width << '\n';
-        std::cout << "Height: " << height << '\n';
+    if (!decoded) {
+        tex_pixels.resize(static_cast<size_t>(tex.width()) * tex.height());
+    }
 
-        lseek(file, 54, SEEK_SET);
+    const render::surface_view source {
+        .pixels = tex_pixels.data(),
+        .width = tex.width(),
+        .height = tex.height(),
+        .stride = tex.width(),
+    };
 
-        const size_t bitmap_size = width * height * 3;
+    if (!decoded) {
+        tex.decode(source);
+    }
 
-        uint8_t* data = static_cast<uint8_t*>(malloc(bitmap_size));
+    return source;
+}
 
-        if (read(file, data, bitmap_size) != bitmap_size) {
-            throw std::runtime_error("Failed to read bitmap data");
+/**
+    Draws the damaged tiles of the window: a gradient with
+    the texture fitted on top. At 1:1 the texture is decoded
+    straight into each tile, otherwise it is scaled from the
+    decoded copy.
+*/
+void draw_frame(const render::surface_view& view) {
+    const render::rect target = render::fit(view.width, view.height, tex.width(), tex.height());
+    const render::surface_view target_view = view.sub(target);
+    const bool unscaled = target_view.width == tex.width() && target_view.height == tex.height();
+    const render::surface_view source = unscaled ? render::surface_view {} : texture_pixels();
+    const render::filter filter = render::pick_filter(tex.width(), tex.height(), target_view.width, target_view.height);
+
+    tiles.render(view, [&](const render::surface_view& tile, const render::rect& area) {
+        const render::rect overlap = area.intersect(target);
+
+        if (overlap != area) {
+            render::fill_gradient(tile, area, view.width, view.height, render::argb(255, 0, 0, 0), render::argb(255, 0, 0, 255), render::argb(255, 0, 255, 0));
         }
 
-        return {
-            .width = width,
-            .height = height,
-            .data = data,
-        };
-    }
-};
+        if (overlap.empty()) { return; }
 
-/**
-    Use-case example
-*/
+        const render::rect clip {
+            .x = overlap.x - target.x,
+            .y = overlap.y - target.y,
+            .width = overlap.width,
+            .height = overlap.height,
+        };
 
-BMPImage tex = BMPImage::load("linus.bmp");
+        if (unscaled) {
+            tex.decode(target_view, clip);
+        } else {
+            render::scale(target_view, source, filter, clip);
+        }
+    });
+}
 
 wl_display display;
 wl_surface* surface;
 wl_shm* shm;
+zwp::linux_dmabuf::dmabuf* dmabuf = nullptr;
+wl_uint dmabuf_version = 0;
 wl_seat* seat;
 wl_pointer* mouse;
 wl_keyboard* keyboard;
+wl_touch* touch = nullptr;
 
 wl_uint pointer_serial = -1;
 
 int resizes = 0;
 
-wl_buffer* create_buffer(wl_shm_pool& pool, wl_int width, wl_int height) {
-    wl_buffer* buffer = pool.create_buffer(display.socket, 0, width, height, width * 4, Format::ARGB8888);
+wl_buffer* create_buffer(wl_shm_pool& pool, wl_int width, wl_int height, wl_int stride, Format format = Format::ARGB8888) {
+    wl_buffer* buffer = pool.create_buffer(display.socket, 0, width, height, stride, format);
     wl_id_map.create(*buffer);
-    surface->commit(display.socket);
     return buffer;
 }
 
-void destroy_shared_memory_fd(const int fd) {
-    if (fd != -1) {
-        close(fd);
-    }
+/**
+    How window and layer buffers are allocated. Prefaulting
+    keeps the page faults of a new buffer out of the first
+    frame drawn after a resize; huge pages help fullscreen
+    windows.
+*/
+const wl::memfd::options framebuffer_memory {
+    .prefault = wl::memfd::prefault_mode::populate_write,
+    .hugepages = wl::memfd::hugepage_mode::transparent,
+    .hugepage_threshold = 4 * 1024 * 1024,
+    .seal = true,
+};
+
+/**
+    Set to draw frames on a dedicated render thread,
+    pipelined with event dispatch. Otherwise frames are drawn
+    inline, inside the configure listener.
+*/
+const bool threaded_rendering = true;
+
+/**
+    Opts the window into async (tearing) presentation, for
+    latency-critical content. Frames are then drawn and
+    committed right away instead of waiting for the
+    compositor's frame callbacks.
+*/
+const bool allow_tearing = false;
+
+/**
+    Content type hint for the window, so the compositor can
+    tune e.g. scaling or latency for it.
+*/
+const wp::content_type::type window_content_type = wp::content_type::type::none;
+
+wp::tearing_control_manager* tearing_control_manager = nullptr;
+wp::content_type_manager* content_type_manager = nullptr;
+
+std::unique_ptr<render::surface_hints> hints;
+
+/**
+    Paces threaded rendering to the compositor's frame
+    callbacks. Only used with `threaded_rendering`.
+*/
+std::unique_ptr<render::frame_scheduler> scheduler;
+
+wl_int screen_width = 200;
+wl_int screen_height = 200;
+
+/**
+    Buffer size as a fraction of the window size. Below 1,
+    frames are drawn small and the compositor scales them up,
+    cutting buffer memory and fill cost quadratically. Needs
+    wp_viewporter; without it buffers match the window.
+*/
+const float render_scale = 1.0f;
+
+wp::viewporter* viewporter = nullptr;
+wp::viewport* viewport = nullptr;
+
+/** Surface size last sent to the viewport. */
+wl_int viewport_width = 0;
+wl_int viewport_height = 0;
+
+wp::fractional_scale_manager* fractional_scale_manager = nullptr;
+
+/** Preferred scale from wp_fractional_scale_v1, over 120. 0 until received. */
+wl_uint fractional_scale = 0;
+/** Preferred scale from wl_surface.preferred_buffer_scale. */
+wl_int integer_scale = 1;
+/**
+    Size of a buffer drawn for a window dimension of @p size,
+    in the device pixels the compositor will scan out.
+*/
+uint32_t buffer_size(const wl_int size) {
+    if (!viewport) { return size * integer_scale; }
+
+    // Fractional scales round half away from zero, like the compositor.
+    const double scale = fractional_scale > 0 ? fractional_scale / double(wp::fractional_scale::DENOMINATOR) : integer_scale;
+    return std::max(1L, std::lround(size * scale * render_scale));
 }
 
-int create_shared_memory_fd(const size_t size) {
-    const int fd = syscall(SYS_memfd_create, "buffer", 0);
+/**
+    wl_surface buffer scale for buffers from `buffer_size()`.
+    With a viewport, the destination size does the scaling.
+*/
+wl_int buffer_scale() {
+    return viewport ? 1 : integer_scale;
+}
+
+/**
+    Scales buffers to the window size on the next commit,
+    if the window was resized since.
+*/
+void update_viewport() {
+    if (!viewport) { return; }
+    if (viewport_width == screen_width && viewport_height == screen_height) { return; }
+
+    viewport->set_destination(screen_width, screen_height);
+    surface->mark_dirty();
+    viewport_width = screen_width;
+    viewport_height = screen_height;
+}
+
+/**
+    Set to back window frames with dmabufs made from memfds
+    through /dev/udmabuf, when the compositor supports
+    linux-dmabuf. It can then import frames directly instead
+    of copying them out of an shm pool.
+
+    The compositor samples a dmabuf until it sends release,
+    and DMA_BUF_SYNC_START doesn't wait for that, so this
+    relies on frames only being drawn into released buffers
+    (see `acquire_framebuffer`).
+*/
+const bool dmabuf_framebuffers = true;
 
-    if (fd < 0) {
-        throw std::runtime_error("Failed to create buffer file");
+/**
+    Format window frames are sent in over shm. RGB565,
+    XRGB4444 or RGB332 cut the memory and upload bandwidth
+    of each frame to a half or a quarter, at the cost of
+    colour depth and translucency. Frames are still drawn
+    in ARGB8888 and converted as they're presented. Falls
+    back to ARGB8888 if the compositor lacks the format.
+*/
+const Format window_shm_format = Format::ARGB8888;
+
+Format shm_format() {
+    if (!render::can_convert(window_shm_format) || !shm->supports(window_shm_format)) {
+        return Format::ARGB8888;
     }
 
-    ftruncate(fd, size);
-    return fd;
+    return window_shm_format;
 }
 
+/** Set once a dmabuf couldn't be created or imported; later buffers use shm. */
+bool dmabuf_rejected = false;
+
+/** Frames are drawn by the CPU, so only linear layouts can be written. */
+const uint32_t DMABUF_FORMAT = DRM_FORMAT_ARGB8888;
+const uint64_t DMABUF_MODIFIER = DRM_FORMAT_MOD_LINEAR;
+
+zwp::linux_dmabuf::feedback* dmabuf_feedback = nullptr;
+
+/** Set when a pre-feedback linux-dmabuf advertises `DMABUF_FORMAT` with `DMABUF_MODIFIER`. */
+bool dmabuf_modifier_advertised = false;
+
+struct zwp::linux_dmabuf::dmabuf::listener dmabuf_listener {
+    .format = [](zwp::linux_dmabuf::dmabuf& dmabuf, const wl_uint format) {},
+    .modifier = [](zwp::linux_dmabuf::dmabuf& dmabuf, const wl_uint format, const uint64_t modifier) {
+        if (format == DMABUF_FORMAT && modifier == DMABUF_MODIFIER) {
+            dmabuf_modifier_advertised = true;
+        }
+    },
+};
+
+/**
+    Whether window frames can be sent as dmabufs. Needs
+    `create_immed`, and for the compositor to import linear
+    ARGB8888: from version 4, feedback vetoes it if not;
+    version 3 lists it in the modifier events. Version 2
+    only lists formats, whose implicit modifier may not be
+    linear, so it sticks to shm.
+*/
+bool dmabuf_usable() {
+    if (!dmabuf_framebuffers || !dmabuf || dmabuf_rejected) { return false; }
+
+    if (dmabuf_version >= zwp::linux_dmabuf::dmabuf::FEEDBACK_VERSION) { return true; }
+
+    return dmabuf_version >= zwp::linux_dmabuf::dmabuf::MODIFIER_VERSION && dmabuf_modifier_advertised;
+}
+
+void redraw();
+
+struct zwp::linux_dmabuf::feedback::listener dmabuf_feedback_listener {
+    .done = [](zwp::linux_dmabuf::feedback& feedback) {
+        const std::optional<zwp::linux_dmabuf::feedback::choice> best = feedback.best_format([](const wl_uint format, const uint64_t modifier) {
+            return format == DMABUF_FORMAT && modifier == DMABUF_MODIFIER;
+        });
+
+        if (!best) {
+            if (!dmabuf_rejected) {
+                lumber::warn("[Wayland::WARN]: Compositor can't import linear ARGB8888 dmabufs for the window, falling back to shm.");
+                dmabuf_rejected = true;
+                redraw();
+            }
+
+            return;
+        }
+
+        if (best->source->scanout()) {
+            std::cout << "Window dmabufs can be scanned out directly.\n";
+        }
+    },
+};
+
+struct zwp::linux_dmabuf::params::listener dmabuf_params_listener {
+    .created = [](zwp::linux_dmabuf::params& params, wl_buffer& buffer) {},
+    .failed = [](zwp::linux_dmabuf::params& params) {
+        lumber::warn("[Wayland::WARN]: Compositor rejected the udmabuf framebuffer, falling back to shm.");
+        dmabuf_rejected = true;
+        redraw();
+    },
+};
+
+void buffer_released();
+
+struct wl_buffer::listener framebuffer_listener {
+    .release = [](wl_buffer& buffer) {
+        buffer_released();
+    },
+};
+
 struct Framebuffer {
-    uint8_t* data;
-    int shared_memory_fd;
-    wl_shm_pool* pool;
-    wl_buffer* buffer;
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    std::optional<wl::memfd> memory;
+    wl_shm_pool* pool = nullptr;
+    std::optional<wl::udmabuf> dma;
+    zwp::linux_dmabuf::params* dma_params = nullptr;
+    wl_buffer* buffer = nullptr;
+    render::surface_view view;
+    wl_int scale = 1;
+
+    /** Format of the shared buffer; `view` is always ARGB8888. */
+    Format format = Format::ARGB8888;
+    size_t stride = 0;
+
+    /** Where frames are drawn when the shared buffer is in a compact format. */
+    std::vector<uint32_t> staging;
+
+    /** Parts of the buffer that don't show the newest frame yet, in buffer coordinates. */
+    render::rect damage;
+
+    /**
+        Bytes to allocate for the shm pool up front, so it
+        can be reused by every smaller size, e.g. while the
+        window is drag-resized.
+    */
+    size_t reserve = 0;
+
+    /** Whether the buffer may be a udmabuf rather than shm. */
+    bool dmabuf_allowed = true;
+
+    /** Told when the compositor releases the buffer; may be null. */
+    struct wl_buffer::listener* release_listener = &framebuffer_listener;
 
     Framebuffer() {}
 
-    void Create(const uint32_t width, const uint32_t height) {
-        const size_t stride = width * 4;
-        const size_t size = stride * height;
+    /**
+        @p format only applies to shm buffers; dmabufs are
+        always ARGB8888, since they're imported without
+        a copy anyway.
+    */
+    void Create(const uint32_t width, const uint32_t height, const wl_int scale = 1, const Format format = Format::ARGB8888) {
+        this->scale = scale;
+        this->format = Format::ARGB8888;
+
+        stride = width * 4;
+        size = stride * height;
+
+        if (!dmabuf_allowed || !CreateDmabuf(width, height, stride)) {
+            this->format = format;
+            stride = format_stride(format, width);
+            size = stride * height;
+
+            // Buffers of any size that fits are cut from the same pool.
+            if (!memory || memory->size() < size) {
+                ReleaseShm();
+
+                const size_t capacity = std::max(size, reserve);
+
+                // The reserve is only address space until a size uses it.
+                wl::memfd::options options = framebuffer_memory;
+                options.prefault_size = size;
+
+                memory = wl::memfd::create(capacity, options);
+                pool = shm->create_pool(display.socket, memory->fd(), capacity);
+            } else {
+                memory->prefault(size);
+            }
+
+            data = memory->data();
+            buffer = create_buffer(*pool, width, height, stride, format);
+        }
 
-        shared_memory_fd = create_shared_memory_fd(size);
-        data = static_cast<uint8_t*>(mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, shared_memory_fd, 0));
+        uint32_t* pixels = reinterpret_cast<uint32_t*>(data);
 
-        for (int x = 0; x < width; x++) {
-            for (int y = 0; y < height; y++) {
-                uint8_t* pixel = data + ((y * width + x) * 4);
-                pixel[0] = ((float) x / width) * 255;
-                pixel[1] = ((float) y / height) * 255;
-                pixel[2] = 0;
-                pixel[3] = 255;
-            }
+        if (Compact()) {
+            staging.assign(static_cast<size_t>(width) * height, 0);
+            pixels = staging.data();
+        } else {
+            staging = {};
         }
 
-        pool = shm->create_pool(display.socket, shared_memory_fd, size);
-        buffer = create_buffer(*pool, width, height);
+        view = {
+            .pixels = pixels,
+            .width = width,
+            .height = height,
+            .stride = width,
+        };
+
+        buffer->listener = release_listener;
+
+        // A new buffer starts out blank.
+        damage = { .x = 0, .y = 0, .width = (int32_t)width, .height = (int32_t)height };
     }
 
-    Framebuffer(const uint32_t width, const uint32_t height) {
-        Create(width, height);
+    /** Whether the compositor may still be reading the buffer. */
+    bool Busy() const noexcept {
+        return buffer && buffer->is_busy;
+    }
+
+    void ReleaseShm() {
+        if (pool) {
+            pool->destroy();
+            pool = nullptr;
+        }
+
+        memory.reset();
+    }
+
+    /** Whether frames are converted into the shared buffer, rather than drawn in it. */
+    bool Compact() const noexcept {
+        return format != Format::ARGB8888 && format != Format::XRGB8888;
+    }
+
+    /**
+        Allocates the buffer as a udmabuf, if enabled and
+        supported. Returns `false` to fall back to shm.
+    */
+    bool CreateDmabuf(const uint32_t width, const uint32_t height, const size_t stride) {
+        if (!dmabuf_usable()) { return false; }
+
+        try {
+            dma = wl::udmabuf::create(size);
+        } catch (const std::runtime_error& error) {
+            lumber::warn(("[Wayland::WARN]: udmabuf unavailable, using shm: " + std::string(error.what())).c_str());
+            dmabuf_rejected = true;
+            return false;
+        }
+
+        data = dma->data();
+        ReleaseShm();
+
+        // Kept until the buffer is replaced, so a `failed` event has somewhere to go.
+        dma_params = &dmabuf->create_params();
+        dma_params->listener = &dmabuf_params_listener;
+        dma_params->add(dma->fd(), 0, 0, stride, DMABUF_MODIFIER);
+        buffer = &dma_params->create_immed(width, height, DMABUF_FORMAT, 0);
+
+        return true;
+    }
+
+    /**
+        Brackets CPU drawing into the buffer. Only needed to
+        keep CPU caches coherent for dmabufs; free for shm.
+        Doesn't wait for the compositor to stop reading.
+    */
+    void BeginWrite() const {
+        if (dma) {
+            dma->begin_cpu_access();
+        }
+    }
+
+    void EndWrite() const {
+        if (dma) {
+            dma->end_cpu_access();
+        }
+    }
+
+    Framebuffer(const uint32_t width, const uint32_t height, const wl_int scale = 1, const Format format = Format::ARGB8888) {
+        Create(width, height, scale, format);
+    }
+
+    /**
+        Shows the buffer on @p target with the next commit,
+        re-uploading only @p damage (buffer coordinates).
+    */
+    void Present(wl_surface& target, const render::rect& damage) {
+        if (!buffer) { return; }
+
+        target.attach(display.socket, *buffer, 0, 0);
+        target.damage_buffer(damage.x, damage.y, damage.width, damage.height);
+        target.commit(display.socket);
+    }
+
+    /**
+        Shows the buffer in the window, along with the state
+        that has to be committed with it.
+    */
+    void Attach(const render::rect& damage) {
+        if (!buffer) { return; }
+
+        if (Compact()) {
+            render::convert(view, format, data, stride, damage);
+        }
+
+        if (scheduler) {
+            scheduler->arm();
+        }
+
+        update_viewport();
+
+        // Must arrive with the buffer it matches; only sent if it changed.
+        surface->set_buffer_scale(scale);
+
+        Present(*surface, damage);
     }
 
     void Attach() {
-        surface->attach(display.socket, *buffer, 0, 0);
-        surface->commit(display.socket);
+        Attach({ .x = 0, .y = 0, .width = (int32_t)view.width, .height = (int32_t)view.height });
     }
 
-    void Resize(const uint32_t width, const uint32_t height) {
+    void Resize(const uint32_t width, const uint32_t height, const wl_int scale = 1, const Format format = Format::ARGB8888) {
         if (buffer) {
             buffer->destroy();
             buffer = nullptr;
         }
 
-        if (pool) {
-            pool->destroy();
-            pool = nullptr;
+        if (dma_params) {
+            dma_params->destroy();
+            dma_params = nullptr;
         }
 
-        destroy_shared_memory_fd(shared_memory_fd);
+        // The shm pool is kept if the new size fits in it.
+        dma.reset();
+        data = nullptr;
 
-        Create(width, height);
+        Create(width, height, scale, format);
 
         display.dispatch_pending();
     }
 };
 
-Framebuffer framebuffer;
+/**
+    The window's buffers. Frames are only drawn into one the
+    compositor has released, so the frame on screen is never
+    written to while it is read.
+*/
+Framebuffer framebuffers[2];
+/** The buffer holding the newest frame, shown or about to be. */
+Framebuffer* front = nullptr;
+/** The buffer the in-flight frame is drawn into. */
+Framebuffer* back = nullptr;
+
+/**
+    Returns a buffer the next frame can be drawn into, or
+    `nullptr` if the compositor holds all of them.
+*/
+Framebuffer* acquire_framebuffer() {
+    // Already holds the newest frame, so only its damage needs redrawing.
+    if (front && !front->Busy()) { return front; }
+
+    for (Framebuffer& buffer : framebuffers) {
+        if (&buffer != back && !buffer.Busy()) {
+            return &buffer;
+        }
+    }
+
+    return nullptr;
+}
 
 bool should_close = false;
 
-wl_int screen_width = 200;
-wl_int screen_height = 200;
+/**
+    Threaded rendering state. Only touched by the protocol
+    thread; the render thread only sees frame requests.
+*/
+std::unique_ptr<render::pipeline> render_pipeline;
+render::input_state input;
+uint64_t frame_serial = 0;
+bool frame_in_flight = false;
+bool surface_configured = false;
 
-struct xdg_surface::listener xdg_surface_listener {
-    .configure = [](xdg_surface& surface, int serial) {
-        surface.ack_configure(serial);
-        framebuffer.Attach();
+/**
+    Parts of the window the attached frame draws fully
+    opaque: everything but a texture with an alpha channel.
+*/
+render::region opaque_area(const Framebuffer& framebuffer) {
+    const render::surface_view& view = framebuffer.view;
+
+    if (view.width == 0 || view.height == 0) { return {}; }
+
+    // Size of the surface the buffer is shown at.
+    const int32_t width = viewport ? screen_width : view.width / framebuffer.scale;
+    const int32_t height = viewport ? screen_height : view.height / framebuffer.scale;
+
+    render::region opaque;
+    opaque.add({ .x = 0, .y = 0, .width = width, .height = height });
+
+    if (!tex.opaque()) {
+        const render::rect texture = render::fit(view.width, view.height, tex.width(), tex.height());
+
+        // Round outwards, so partly covered pixels aren't claimed opaque.
+        const int32_t left = int64_t(texture.x) * width / view.width;
+        const int32_t top = int64_t(texture.y) * height / view.height;
+        const int32_t right = (int64_t(texture.x + texture.width) * width + view.width - 1) / view.width;
+        const int32_t bottom = (int64_t(texture.y + texture.height) * height + view.height - 1) / view.height;
+
+        opaque.subtract({ .x = left, .y = top, .width = right - left, .height = bottom - top });
+    }
+
+    return opaque;
+}
+
+/**
+    Predicts refreshes and decides when to start drawing, so
+    frames are drawn as late as possible.
+*/
+render::frame_clock frame_clock;
+
+/** Every output the compositor advertised. */
+std::vector<wl::output*> outputs;
+/** Outputs the window is on, from wl_surface enter and leave. */
+std::vector<wl_object> entered_outputs;
+
+/**
+    Gives the frame clock the fastest refresh rate of the
+    outputs the window is on, which is what the compositor
+    usually repaints it at. Presentation feedback, once it
+    arrives, overrides this.
+*/
+void update_refresh() {
+    wl_int refresh = 0;
+
+    for (const wl::output* output : outputs) {
+        if (std::find(entered_outputs.begin(), entered_outputs.end(), output->ID()) == entered_outputs.end()) { continue; }
+
+        refresh = std::max(refresh, output->current_mode().refresh);
+    }
+
+    frame_clock.set_refresh(refresh);
+}
+
+std::unique_ptr<render::opaque_region_sync> opaque_region;
+
+wp::presentation* presentation = nullptr;
+
+/** Presentation latency of the window, if the compositor supports presentation-time. */
+std::unique_ptr<render::latency_tracker> latency;
+
+/** Time of the newest input event no frame has been started for yet. */
+std::optional<wl_uint> input_time;
+/** Time of the newest input event the in-flight frame reflects. */
+std::optional<wl_uint> frame_input_time;
+
+/** When the next frame should start drawing, if one is scheduled. */
+std::optional<render::frame_clock::clock::time_point> frame_wake;
+/** Commit deadline of the scheduled or in-flight frame. */
+render::frame_clock::clock::time_point frame_deadline;
+
+/**
+    Draws a frame at the latest configured size with the
+    latest input. Sizes configured in the meantime collapse
+    into one frame at the newest size.
+*/
+void start_frame() {
+    frame_wake.reset();
+
+    Framebuffer* target = acquire_framebuffer();
+
+    // Started again by the next release.
+    if (!target) { return; }
+
+    // Neither the render thread nor the compositor uses the buffer, so it can be unmapped.
+    const uint32_t width = buffer_size(screen_width);
+    const uint32_t height = buffer_size(screen_height);
+
+    // A rejected dmabuf is replaced by an shm buffer.
+    const bool rejected = target->dma && dmabuf_rejected;
+
+    if (rejected || target->view.width != width || target->view.height != height || target->scale != buffer_scale()) {
+        target->Resize(width, height, buffer_scale(), shm_format());
+    }
+
+    const render::frame_request request {
+        .serial = ++frame_serial,
+        .target = target->view,
+        .damage = target->damage,
+        .input = input,
+    };
+
+    target->BeginWrite();
+    frame_in_flight = render_pipeline->submit(request);
+
+    if (frame_in_flight) {
+        scheduler->begin_frame();
+        back = target;
+        target->damage = {};
+        frame_input_time = input_time;
+        input_time.reset();
+    } else {
+        target->EndWrite();
     }
+}
+
+/**
+    Schedules a frame if the render thread is idle and the
+    compositor is ready for one. Drawing starts just early
+    enough to make the next reachable refresh.
+*/
+void request_frame() {
+    if (frame_in_flight || frame_wake || !scheduler->ready() || !acquire_framebuffer()) { return; }
+
+    const auto now = render::frame_clock::clock::now();
+    frame_deadline = frame_clock.deadline(now);
+    frame_wake = frame_clock.wake_time(now);
+
+    // Torn frames are shown once committed, without waiting for a refresh.
+    if (scheduler->is_async() || *frame_wake <= now) {
+        start_frame();
+    }
+}
+
+void on_frame_done(const render::frame_result& result) {
+    frame_in_flight = false;
+    back->EndWrite();
+    frame_clock.render_time(result.render_time);
+
+    front = back;
+    back = nullptr;
+
+    if (surface_configured) {
+        if (latency) {
+            latency->commit(frame_input_time);
+        }
+
+        opaque_region->update(opaque_area(*front));
+
+        front->Attach(result.damage);
+
+        if (frame_clock.frame_committed(frame_deadline, render::frame_clock::clock::now())) {
+            lumber::warn(("[Render::WARN]: Frame " + std::to_string(result.serial) + " missed its deadline.").c_str());
+        }
+    }
+
+    request_frame();
+}
+
+struct render::frame_scheduler::listener scheduler_listener {
+    .redraw = [](render::frame_scheduler& scheduler) {
+        // Sent when the compositor starts a repaint, close to a refresh.
+        // Only a fallback; presentation timestamps are exact.
+        if (!latency) {
+            frame_clock.vblank(scheduler.last_frame().received);
+        }
+
+        request_frame();
+    },
 };
 
-struct xdg_toplevel::listener xdg_toplevel_listener {
-    .configure = [](const wl_int x, const wl_int y) {
-        if ((wl_uint)x == 0 || (wl_uint)y == 0) { return; }
+struct render::latency_tracker::listener latency_listener {
+    .presented = [](render::latency_tracker& tracker, const wp::presentation_feedback::presented_info& info) {
+        // steady_clock is CLOCK_MONOTONIC, so the timestamps can be used as is.
+        if (presentation->clock_id() == CLOCK_MONOTONIC) {
+            frame_clock.presented(render::frame_clock::clock::time_point(std::chrono::nanoseconds(info.time)), std::chrono::nanoseconds(info.refresh));
+        }
+    },
+};
+
+/**
+    Draws a frame into @p target on the calling thread,
+    making it the front buffer, and shows it once the
+    window is configured. Only used without
+    `threaded_rendering`.
+*/
+void draw_inline(Framebuffer& target) {
+    // Always a freshly created buffer.
+    tiles.resize(target.view.width, target.view.height);
+    tiles.damage_all();
+
+    target.BeginWrite();
+    draw_frame(target.view);
+    target.EndWrite();
+
+    target.damage = {};
+    front = &target;
+
+    // Before that, the first configure attaches it.
+    if (surface_configured) {
+        target.Attach();
+    }
+}
+
+/** Set when a redraw without the render thread found no free buffer. */
+bool inline_redraw_pending = false;
+
+/**
+    Draws the window again after its size or scale changed.
+    Without the render thread, the new frame is shown on the
+    next configure.
+*/
+void redraw() {
+    if (threaded_rendering) {
+        // The first frame, requested at startup, picks up the change.
+        if (!scheduler) { return; }
+
+        scheduler->request_redraw();
+        request_frame();
+    } else {
+        Framebuffer* target = acquire_framebuffer();
+        inline_redraw_pending = target == nullptr;
+
+        if (!target) { return; }
+
+        target->Resize(buffer_size(screen_width), buffer_size(screen_height), buffer_scale(), shm_format());
+        draw_inline(*target);
+    }
+}
+
+/**
+    Frames that found every buffer busy go ahead once the
+    compositor hands one back.
+*/
+void buffer_released() {
+    if (threaded_rendering) {
+        if (scheduler) {
+            request_frame();
+        }
+    } else if (inline_redraw_pending) {
+        redraw();
+    }
+}
+
+struct wl_surface::listener surface_listener {
+    .enter = [](wl_surface& surface, wl_object output) {
+        entered_outputs.push_back(output);
+        update_refresh();
+    },
+    .leave = [](wl_surface& surface, wl_object output) {
+        entered_outputs.erase(std::remove(entered_outputs.begin(), entered_outputs.end(), output), entered_outputs.end());
+        update_refresh();
+    },
+    .preferred_buffer_scale = [](wl_surface& surface, const wl_int factor) {
+        if (factor < 1 || factor == integer_scale) { return; }
+
+        integer_scale = factor;
+        redraw();
+    },
+    .preferred_buffer_transform = [](wl_surface& surface, wl_surface::transform transform) {
+        // Content is only drawn upright, so buffers stay untransformed.
+    },
+};
 
-        screen_width = x;
-        screen_height = y;
+struct wp::fractional_scale::listener fractional_scale_listener {
+    .preferred_scale = [](wp::fractional_scale& fractional_scale, const wl_uint scale) {
+        if (scale == ::fractional_scale) { return; }
 
-        framebuffer.Resize(x, y);
+        ::fractional_scale = scale;
+        redraw();
     },
+};
+
+struct xdg_surface::listener xdg_surface_listener {
+    .configure = [](xdg_surface& surface, const xdg_toplevel::configure& configure, const wl_uint coalesced) {
+        if (configure.bounds) {
+            // Sized for the largest the window is expected to get, in the current buffer format.
+            for (Framebuffer& framebuffer : framebuffers) {
+                framebuffer.reserve = format_stride(shm_format(), buffer_size(configure.bounds->width)) * buffer_size(configure.bounds->height);
+            }
+        }
+
+        const bool first = !surface_configured;
+        surface_configured = true;
+
+        // State-only configures (focus, activation) resend the current size.
+        const bool resized = configure.width != 0 && configure.height != 0 && (configure.width != screen_width || configure.height != screen_height);
+
+        if (resized) {
+            screen_width = configure.width;
+            screen_height = configure.height;
+
+            redraw();
+        }
+
+        // A frame that is drawn, scheduled or in flight carries the ack with it.
+        if (frame_in_flight || frame_wake || inline_redraw_pending || (resized && !threaded_rendering)) { return; }
+
+        // Drawn before the window was configured, so never shown.
+        if (first && front) {
+            front->Attach();
+            return;
+        }
+
+        // Nothing to redraw: commit only to apply the ack.
+        ::surface->mark_dirty();
+        ::surface->commit(display.socket);
+    }
+};
+
+struct xdg_toplevel::listener xdg_toplevel_listener {
     .close = []() {
         std::cout << "Close" << '\n';
         should_close = true;
     },
-    .configure_bounds = [](int x, int y) {
-        std::cout << "Configure bounds: " << x << ", " << y << '\n';
-    },
     .wm_capabilities = []() {
         std::cout << "Capabilities" << '\n';
     },
 };
 
-struct wl_seat::listener wl_seat_listener {
-    
-};
 
 wl_compositor compositor(0);
+wl_subcompositor* subcompositor = nullptr;
+wp::single_pixel_buffer_manager* single_pixel_buffer_manager = nullptr;
+
+/**
+    Creates a 1x1 buffer of one premultiplied ARGB8888
+    colour, to be stretched with a viewport. Uses a
+    single-pixel buffer when the compositor supports them,
+    and a 1x1 shm buffer otherwise.
+*/
+wl_buffer* create_solid_buffer(const uint32_t colour) {
+    if (single_pixel_buffer_manager) {
+        return &single_pixel_buffer_manager->create_buffer(colour);
+    }
+
+    const wl::memfd memory = wl::memfd::create(sizeof(colour), { .prefault = wl::memfd::prefault_mode::none });
+    memcpy(memory.data(), &colour, sizeof(colour));
+
+    wl_shm_pool* pool = shm->create_pool(display.socket, memory.fd(), sizeof(colour));
+
+    // Sends the fd, so it can be closed on return.
+    display.dispatch_pending();
+
+    // The buffer keeps the memory alive after the pool and fd are gone.
+    wl_buffer* buffer = pool->create_buffer(display.socket, 0, 1, 1, sizeof(colour), Format::ARGB8888);
+    wl_id_map.create(*buffer);
+
+    pool->destroy();
+
+    return buffer;
+}
+
+/**
+    A subsurface with its own buffer, for content that
+    changes independently of the rest of the window. It can
+    be redrawn or moved without touching the window buffer.
+
+    Layer buffers are small and rarely redrawn, so they stay
+    on shm: a dmabuf import failure or release is handled
+    for the window's buffers only.
+*/
+struct Layer {
+    wl_surface* surface = nullptr;
+    wl_subsurface* subsurface = nullptr;
+    Framebuffer framebuffer;
+
+    /** Solid colour content used instead of `framebuffer`, stretched by `solid_viewport`. */
+    wl_buffer* solid = nullptr;
+    wp::viewport* solid_viewport = nullptr;
+
+    void Create(wl_surface& parent, const uint32_t width, const uint32_t height) {
+        CreateSurface(parent);
+        CreateFramebuffer(width, height);
+    }
+
+    /**
+        Creates a layer of one premultiplied colour. With a
+        viewport it is backed by a single pixel at any size;
+        without one it falls back to a full framebuffer.
+    */
+    void CreateSolid(wl_surface& parent, const uint32_t colour, const uint32_t width, const uint32_t height) {
+        CreateSurface(parent);
+
+        if (!viewporter) {
+            CreateFramebuffer(width, height);
+
+            framebuffer.BeginWrite();
+            render::fill_solid(framebuffer.view, colour);
+            framebuffer.EndWrite();
+            return;
+        }
+
+        solid = create_solid_buffer(colour);
+        solid_viewport = &viewporter->get_viewport(*surface);
+        solid_viewport->set_destination(width, height);
+    }
+
+    void CreateFramebuffer(const uint32_t width, const uint32_t height) {
+        framebuffer.dmabuf_allowed = false;
+        // Releases don't affect when the window draws.
+        framebuffer.release_listener = nullptr;
+        framebuffer.Create(width, height);
+    }
+
+    void CreateSurface(wl_surface& parent) {
+        surface = compositor.create_surface(display.socket);
+        subsurface = &subcompositor->get_subsurface(*surface, parent);
+
+        // Apply our own commits right away instead of with the parent's.
+        subsurface->set_desync();
+
+        // Let input fall through to the parent.
+        wl_region* empty = compositor.create_region(display.socket);
+        surface->set_input_region(empty);
+        empty->destroy();
+        delete empty;
+    }
+
+    /**
+        Moves the layer on the parent's next commit.
+    */
+    void Move(const wl_int x, const wl_int y) {
+        subsurface->set_position(x, y);
+    }
+
+    void Present(const render::rect& damage) {
+        framebuffer.Present(*surface, damage);
+    }
+
+    void Present() {
+        if (solid) {
+            surface->attach(display.socket, *solid, 0, 0);
+            surface->damage_buffer(0, 0, 1, 1);
+            surface->commit(display.socket);
+            return;
+        }
+
+        Present({ .x = 0, .y = 0, .width = (int32_t)framebuffer.view.width, .height = (int32_t)framebuffer.view.height });
+    }
+
+    void Hide() {
+        surface->detach(display.socket);
+        surface->commit(display.socket);
+    }
+};
+
+/**
+    Marks the pointer position. Drawn once, then only moved,
+    so pointer motion never redraws the window buffer.
+*/
+Layer pointer_marker;
+bool pointer_marker_moved = false;
+
+constexpr uint32_t POINTER_MARKER_SIZE = 12;
+
+void move_pointer_marker() {
+    if (!pointer_marker.surface) { return; }
+
+    const wl_int x = static_cast<wl_int>(input.pointer_x) - POINTER_MARKER_SIZE / 2;
+    const wl_int y = static_cast<wl_int>(input.pointer_y) - POINTER_MARKER_SIZE / 2;
+
+    pointer_marker.Move(x, y);
+    pointer_marker_moved = true;
+}
+
+/** Set to get one pointer callback per wl_pointer.frame, instead of one per event. */
+const bool accumulate_pointer_frames = true;
+
+void press_button(const wl_uint button, const wl_pointer::button_state state) {
+    // Linux button codes start at BTN_LEFT (0x110).
+    const wl_uint bit = 1u << ((button - 0x110) & 31);
+    input.buttons = state == wl_pointer::button_state::pressed ? input.buttons | bit : input.buttons & ~bit;
+}
+
+/** One parent commit per pointer frame applies the new marker position. */
+void commit_pointer_marker() {
+    if (!pointer_marker_moved) { return; }
+
+    // Subsurface positions are parent state. The commit carries no
+    // buffer, so the window isn't redrawn or re-uploaded.
+    surface->mark_dirty();
+    surface->commit(display.socket);
+    pointer_marker_moved = false;
+}
 
 struct wl_pointer::listener wl_mouse_listener {
     .enter = [](wl_uint serial, wl_object surface, wl_fixed surface_x, wl_fixed surface_y) {
         std::cout << "Mouse entered: " << "surface_x: " << surface_x << ", " << "surface_y: " << surface_y << '\n';
 
-        
+        input.pointer_inside = true;
+        input.pointer_x = surface_x;
+        input.pointer_y = surface_y;
+
+        if (pointer_marker.surface) {
+            move_pointer_marker();
+            pointer_marker.Present();
+        }
     },
     .leave = [](wl_uint serial, wl_object surface) {
         std::cout << "Mouse left" << '\n';
+        input.pointer_inside = false;
+
+        if (pointer_marker.surface) {
+            pointer_marker.Hide();
+        }
     },
-    .motion = [](wl_uint serial, wl_fixed surface_x, wl_fixed surface_y) {
+    .motion = [](wl_uint time, wl_fixed surface_x, wl_fixed surface_y) {
+        input.pointer_x = surface_x;
+        input.pointer_y = surface_y;
+        input_time = time;
+        move_pointer_marker();
         //std::cout << "Mouse moved: " << "surface_x: " << surface_x << ", " << "surface_y: " << surface_y << '\n';
     },
     .button = [](wl_uint serial, wl_uint time, wl_uint button, enum wl_pointer::button_state state) {
         std::cout << "Mouse clicked: " << "button: " << button << ", " << "state: " << (wl_uint)state << '\n';
+
+        press_button(button, state);
+        input_time = time;
     },
     .axis = [](wl_uint time, enum wl_pointer::axis axis, wl_fixed value) {
         std::cout << "Mouse axis: " << "axis: " << (wl_uint)axis << ", " << "value: " << value << '\n';
     },
     .frame = []() {
         //std::cout << "Mouse frame" << '\n';
+        commit_pointer_marker();
     },
     .axis_source = [](enum wl_pointer::axis_source source) {
         //std::cout << "Mouse axis source" << '\n';
@@ -244,25 +1176,135 @@ struct wl_pointer::listener wl_mouse_listener {
     .axis_relative_direction = [](enum wl_pointer::axis axis, enum wl_pointer::axis_relative_direction relative_direction) {
         //std::cout << "Mouse axis relative direction: " << (wl_uint)relative_direction << '\n';
     },
+    .accumulated_frame = [](wl_pointer& pointer, const wl_pointer::pointer_frame& frame) {
+        // A leave comes before an enter in the same frame.
+        if (frame.left) {
+            input.pointer_inside = false;
+
+            if (pointer_marker.surface && !frame.entered) {
+                pointer_marker.Hide();
+            }
+        }
+
+        if (frame.entered) {
+            input.pointer_inside = true;
+        }
+
+        if (frame.moved) {
+            input.pointer_x = frame.surface_x;
+            input.pointer_y = frame.surface_y;
+            move_pointer_marker();
+        }
+
+        if (frame.motion_count > 0) {
+            input_time = frame.time;
+        }
+
+        if (frame.entered && pointer_marker.surface) {
+            pointer_marker.Present();
+        }
+
+        for (const wl_pointer::button_event& button : frame.buttons) {
+            press_button(button.button, button.state);
+            input_time = button.time;
+        }
+
+        commit_pointer_marker();
+    },
 };
 
+/**
+    Input events for the render thread, which takes them
+    straight from dispatch instead of through frame requests.
+    Only filled with `threaded_rendering`. New events wake
+    the render thread, which drains them without drawing:
+    nothing on screen follows the input yet, so no event is
+    worth a frame.
+*/
+wl::input_ring input_events;
+/** `input_events.stats().pushed` when the render thread was last woken for input. */
+uint64_t input_events_woken = 0;
+
+/** How old input events are when the render thread picks them up. */
+render::histogram input_age;
+
+zwp::relative_pointer_manager* relative_pointer_manager = nullptr;
+zwp::pointer_constraints* pointer_constraints = nullptr;
+
+/**
+    Set to lock the pointer while it is over the window, so
+    only relative motion arrives, e.g. for mouse look.
+*/
+const bool lock_pointer = false;
+
 struct wl_keyboard::listener wl_keyboard_listener {
     .key = [](wl_uint serial, wl_uint time, wl_uint key, wl_keyboard::key_state state) {
         //std::cout << "KEY\n";
         //std::cout << key << '\n';
-    }
+    },
+    .modifiers = nullptr,
+};
+
+struct wl_touch::listener wl_touch_listener {
+    .frame = [](wl_touch& touch, const wl_touch::touch_frame& frame) {
+        // A whole gesture is one update: the marker follows the centre of all fingers.
+        float x = 0;
+        float y = 0;
+        size_t held = 0;
+
+        for (const wl_touch::touch_point& point : frame.points) {
+            if (!point.active || point.up) { continue; }
+
+            x += point.x;
+            y += point.y;
+            held++;
+        }
+
+        if (held == 0) { return; }
+
+        input.pointer_x = x / held;
+        input.pointer_y = y / held;
+        input_time = frame.time;
+
+        move_pointer_marker();
+        commit_pointer_marker();
+    },
+    .cancel = [](wl_touch& touch) {},
+};
+
+struct wl_seat::listener wl_seat_listener {
+    .capabilities = [](wl_seat& seat, const wl_uint capabilities) {
+        if (seat.has(wl_seat::capability::touch) && !touch) {
+            touch = seat.get_touch();
+            touch->listener = &wl_touch_listener;
+        } else if (!seat.has(wl_seat::capability::touch) && touch) {
+            // Without `release` (before version 3) the compositor
+            // keeps its end; drop ours either way.
+            if (touch->version >= wl_touch::RELEASE_VERSION) {
+                touch->release();
+            }
+
+            wl_id_map.destroy(touch->ID());
+            delete touch;
+            touch = nullptr;
+        }
+    },
+    .name = [](wl_seat& seat, const wl_string& name) {},
 };
 
 xdg_wm_base* wm_base;
-zwp::linux_dmabuf::dmabuf* dmabuf;
-wl::output* output;
+struct wl::output::listener output_listener {
+    .mode = [](wl::output& output, const wl::output::mode& mode) {
+        update_refresh();
+    },
+};
 
 void on_global_registered(wl_registry& registry, const wl_uint name, const wl_string& interface, const wl_uint version) {
     
 	if (interface.compare("wl_compositor") == 0) {
         const wl_new_id id = wl_id_assigner.request_id();
         registry.bind(name, interface, version, id);
-        compositor = wl_compositor(id);
+        compositor = wl_compositor(id, version);
     } else if (interface.compare("wl_shm") == 0) {
         const wl_new_id id = wl_id_assigner.request_id();
         registry.bind(name, interface, version, id);
@@ -276,7 +1318,9 @@ void on_global_registered(wl_registry& registry, const wl_uint name, const wl_st
     } else if (interface.compare("wl_seat") == 0) {
         const wl_new_id id = wl_id_assigner.request_id();
         registry.bind(name, interface, version, id);
-        seat = new wl_seat(id);
+        seat = new wl_seat(id, version);
+        // Set right away, so the first capabilities event isn't missed.
+        seat->listener = &wl_seat_listener;
         wl_id_map.create(*seat);
     } else if (interface.compare("xdg_toplvel_icon_manager_v1") == 0) {
         
@@ -284,12 +1328,62 @@ void on_global_registered(wl_registry& registry, const wl_uint name, const wl_st
 		const wl_new_id id = wl_id_assigner.request_id();
 		registry.bind(name, interface, version, id);
 		dmabuf = new zwp::linux_dmabuf::dmabuf(id);
+		dmabuf_version = version;
+		// Formats are sent right after the bind.
+		dmabuf->listener = &dmabuf_listener;
 		wl_id_map.create(*dmabuf);
 	} else if (interface.compare("wl_output") == 0) {
 		const wl_new_id id = wl_id_assigner.request_id();
 		registry.bind(name, interface, version, id);
-		output = new wl::output(id);
+		wl::output* output = new wl::output(id);
+		output->listener = &output_listener;
 		wl_id_map.create(*output);
+		outputs.push_back(output);
+	} else if (interface.compare("wp_presentation") == 0) {
+		const wl_new_id id = wl_id_assigner.request_id();
+		registry.bind(name, interface, version, id);
+		presentation = new wp::presentation(id);
+		wl_id_map.create(*presentation);
+	} else if (interface.compare("wp_viewporter") == 0) {
+		const wl_new_id id = wl_id_assigner.request_id();
+		registry.bind(name, interface, version, id);
+		viewporter = new wp::viewporter(id);
+		wl_id_map.create(*viewporter);
+	} else if (interface.compare("wp_fractional_scale_manager_v1") == 0) {
+		const wl_new_id id = wl_id_assigner.request_id();
+		registry.bind(name, interface, version, id);
+		fractional_scale_manager = new wp::fractional_scale_manager(id);
+		wl_id_map.create(*fractional_scale_manager);
+	} else if (interface.compare("wl_subcompositor") == 0) {
+		const wl_new_id id = wl_id_assigner.request_id();
+		registry.bind(name, interface, version, id);
+		subcompositor = new wl_subcompositor(id);
+		wl_id_map.create(*subcompositor);
+	} else if (interface.compare("wp_single_pixel_buffer_manager_v1") == 0) {
+		const wl_new_id id = wl_id_assigner.request_id();
+		registry.bind(name, interface, version, id);
+		single_pixel_buffer_manager = new wp::single_pixel_buffer_manager(id);
+		wl_id_map.create(*single_pixel_buffer_manager);
+	} else if (interface.compare("wp_tearing_control_manager_v1") == 0) {
+		const wl_new_id id = wl_id_assigner.request_id();
+		registry.bind(name, interface, version, id);
+		tearing_control_manager = new wp::tearing_control_manager(id);
+		wl_id_map.create(*tearing_control_manager);
+	} else if (interface.compare("wp_content_type_manager_v1") == 0) {
+		const wl_new_id id = wl_id_assigner.request_id();
+		registry.bind(name, interface, version, id);
+		content_type_manager = new wp::content_type_manager(id);
+		wl_id_map.create(*content_type_manager);
+	} else if (interface.compare("zwp_relative_pointer_manager_v1") == 0) {
+		const wl_new_id id = wl_id_assigner.request_id();
+		registry.bind(name, interface, version, id);
+		relative_pointer_manager = new zwp::relative_pointer_manager(id);
+		wl_id_map.create(*relative_pointer_manager);
+	} else if (interface.compare("zwp_pointer_constraints_v1") == 0) {
+		const wl_new_id id = wl_id_assigner.request_id();
+		registry.bind(name, interface, version, id);
+		pointer_constraints = new zwp::pointer_constraints(id);
+		wl_id_map.create(*pointer_constraints);
 	}
 }
 
@@ -313,9 +1407,35 @@ int main() {
     display.roundtrip();
 
     shm->listener = &wl_shm_listener;
-    seat->listener = &wl_seat_listener;
 
     surface = compositor.create_surface(display.socket);
+
+    surface->listener = &surface_listener;
+
+    hints = std::make_unique<render::surface_hints>(*surface, tearing_control_manager, content_type_manager);
+    hints->set_content_type(window_content_type);
+    hints->set_async(allow_tearing);
+
+    // Fractional scales can only be honoured through a viewport.
+    if (viewporter && (render_scale != 1.0f || fractional_scale_manager)) {
+        viewport = &viewporter->get_viewport(*surface);
+    }
+
+    // Lets the compositor veto linear dmabufs before the first one is made.
+    if (dmabuf_framebuffers && dmabuf && dmabuf_version >= zwp::linux_dmabuf::dmabuf::FEEDBACK_VERSION) {
+        dmabuf_feedback = &dmabuf->get_surface_feedback(*surface);
+        dmabuf_feedback->listener = &dmabuf_feedback_listener;
+    }
+
+    if (subcompositor) {
+        // Premultiplied, translucent white.
+        pointer_marker.CreateSolid(*surface, render::argb(160, 160, 160, 160), POINTER_MARKER_SIZE, POINTER_MARKER_SIZE);
+    }
+
+    if (viewport && fractional_scale_manager) {
+        wp::fractional_scale& scale = fractional_scale_manager->get_fractional_scale(*surface);
+        scale.listener = &fractional_scale_listener;
+    }
     
     xdg_surface& xdg_surface = wm_base->get_xdg_surface(display.socket, *surface);
     xdg_surface.listener = &xdg_surface_listener;
@@ -325,18 +1445,132 @@ int main() {
 
     toplevel.set_title("Test Application");
 
+    // The initial, bufferless commit, answered by the first configure.
+    surface->commit(display.socket);
+
     display.dispatch_pending();
 
     mouse = seat->get_mouse();
     mouse->listener = &wl_mouse_listener;
+    mouse->set_accumulate(accumulate_pointer_frames);
 
     keyboard = seat->get_keyboard();
     keyboard->listener = &wl_keyboard_listener;
     
-    framebuffer = Framebuffer(200, 200);
+    if (!threaded_rendering) {
+        framebuffers[0].Create(buffer_size(screen_width), buffer_size(screen_height), buffer_scale(), shm_format());
+        draw_inline(framebuffers[0]);
+
+        while (!should_close) {
+            display.roundtrip();
+            xdg_surface.apply_configure();
+        }
+
+        return 0;
+    }
+
+    render_pipeline = std::make_unique<render::pipeline>([](const render::frame_request& request) {
+        tiles.resize(request.target.width, request.target.height);
+        tiles.damage(request.damage);
+        draw_frame(request.target);
+    }, [] {
+        const int64_t now = wl::input_clock::now();
+
+        input_events.drain([now](const wl::input_event& event) {
+            input_age.record(std::chrono::nanoseconds(now - event.time_ns));
+        });
+    });
+
+    mouse->ring = &input_events;
+    keyboard->ring = &input_events;
+
+    if (relative_pointer_manager) {
+        zwp::relative_pointer& relative = relative_pointer_manager->get_relative_pointer(*mouse);
+        relative.ring = &input_events;
+    }
+
+    if (lock_pointer && pointer_constraints) {
+        zwp::locked_pointer& locked = pointer_constraints->lock_pointer(*surface, *mouse, nullptr, zwp::pointer_constraints::lifetime::persistent);
+        locked.ring = &input_events;
+    }
+
+    scheduler = std::make_unique<render::frame_scheduler>(*surface);
+    scheduler->listener = &scheduler_listener;
+    scheduler->set_async(hints->allows_tearing());
+    scheduler->request_redraw();
+
+    opaque_region = std::make_unique<render::opaque_region_sync>(display.socket, compositor, *surface);
+
+    if (presentation) {
+        latency = std::make_unique<render::latency_tracker>(*presentation, *surface);
+        latency->listener = &latency_listener;
+    }
+
+    request_frame();
 
     while (!should_close) {
-		display.roundtrip();
+        display.dispatch_pending();
+
+        pollfd fds[] = {
+            { .fd = static_cast<int>(display.socket), .events = POLLIN, .revents = 0 },
+            { .fd = render_pipeline->fd(), .events = POLLIN, .revents = 0 },
+            // Only armed while a key repeats, so idle typing costs no wakeups.
+            { .fd = keyboard->repeat_fd(), .events = POLLIN, .revents = 0 },
+        };
+
+        int timeout = -1;
+
+        if (frame_wake) {
+            const auto until = std::chrono::ceil<std::chrono::milliseconds>(*frame_wake - render::frame_clock::clock::now());
+            timeout = std::max<int>(0, until.count());
+        }
+
+        if (poll(fds, std::size(fds), timeout) < 0) { continue; }
+
+        if (frame_wake && render::frame_clock::clock::now() >= *frame_wake) {
+            start_frame();
+        }
+
+        if (fds[0].revents & POLLIN) {
+            display.read_queues();
+
+            // Once per batch, so a configure storm costs one resize.
+            xdg_surface.apply_configure();
+        }
+
+        if (fds[2].revents & POLLIN) {
+            keyboard->dispatch_repeat();
+        }
+
+        while (const std::optional<render::frame_result> result = render_pipeline->poll()) {
+            on_frame_done(*result);
+        }
+
+        // Once per pass, so a burst of motion costs one wakeup.
+        const uint64_t pushed = input_events.stats().pushed;
+
+        if (pushed != input_events_woken) {
+            input_events_woken = pushed;
+            render_pipeline->wake();
+        }
+    }
+
+    std::cout << "Frames: " << frame_clock.frames_committed() << ", missed deadlines: " << frame_clock.missed_deadlines() << '\n';
+
+    if (latency) {
+        latency->report(std::cout);
+    }
+
+    const wl::input_ring::statistics events = input_events.stats();
+
+    std::cout << "Input events: " << events.pushed << ", dropped: " << events.dropped << ", most queued: " << events.high_water << '\n';
+
+    if (input_age.count() > 0) {
+        const auto ms = [](const std::chrono::nanoseconds time) { return std::chrono::duration<double, std::milli>(time).count(); };
+
+        std::cout << "Input age at render: " << input_age.count() << " samples"
+                  << ", mean " << ms(input_age.mean()) << " ms"
+                  << ", p99 " << ms(input_age.percentile(0.99)) << " ms\n";
     }
 
     return 0;
@@ -3,16 +3,40 @@
 #include "../wl_utils/wl_types.h"
 #include "../wl_utils/wl_state.h"
 
+/**
+    @brief Content for a surface, backed by shm or dmabuf
+    memory the client shares with the compositor.
+
+    Once committed, the compositor may read the memory until
+    it sends `release`, so writing to it in between can show
+    a torn frame. Clients that draw every frame should keep
+    more than one buffer and only draw into released ones.
+*/
 class wl_buffer : public wl_obj {
     wl_object id;
     bool is_invalid = false;
 
     static constexpr wl_uint DESTROY_OPCODE = 0;
 
+    static constexpr wl_uint EV_RELEASE_OPCODE = 0;
+
     public:
 
+    struct listener {
+        /** The compositor no longer reads the buffer. */
+        void (*release)(wl_buffer& buffer);
+    };
+
+    listener* listener = nullptr;
+
+    /**
+        Set by the commit that attaches the buffer, cleared
+        by `release`.
+    */
+    bool is_busy = false;
+
     wl_buffer(const wl_new_id id) : id(id) {
-        
+
     }
 
     wl_object ID() const noexcept override {
@@ -26,6 +50,14 @@ class wl_buffer : public wl_obj {
     }
 
     void handle_event(uint16_t opcode, wl_message::reader reader) override {
-        
+        if (opcode == EV_RELEASE_OPCODE) {
+            is_busy = false;
+
+            if (listener) {
+                listener->release(*this);
+            }
+        } else {
+            lumber::warn("[Wayland::WARN]: Unimplemented event opcode for wl_buffer.");
+        }
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../wl_utils/wl_types.h"
+#include "../wl_utils/wl_state.h"
+
+/**
+    @brief Callback object, fired once when a related
+    request completes.
+
+    The compositor destroys the object after `done`, so it
+    must not be used afterwards. The creator owns the
+    client-side object and deletes it once `done` has been
+    handled.
+*/
+class wl_callback : public wl_obj {
+    const wl_object id;
+
+    static constexpr wl_uint EV_DONE_OPCODE = 0;
+
+    public:
+
+    struct listener {
+        /**
+            Called once, with data that depends on the request
+            that created the callback. For frame callbacks it
+            is a timestamp in milliseconds.
+        */
+        void (*done)(wl_callback& callback, wl_uint callback_data);
+    };
+
+    listener* listener = nullptr;
+
+    /** Free slot for the listener to find its owner. */
+    void* user_data = nullptr;
+
+    wl_callback(const wl_new_id id) : id(id) {}
+
+    wl_object ID() const noexcept override {
+        return id;
+    }
+
+    void handle_event(uint16_t opcode, wl_message::reader reader) override {
+        if (opcode == EV_DONE_OPCODE) {
+            const wl_uint callback_data = reader.read_uint();
+
+            if (listener) {
+                listener->done(*this, callback_data);
+            }
+        } else {
+            lumber::warn("[Wayland::WARN]: Unimplemented event opcode for wl_callback.");
+        }
+    }
+};
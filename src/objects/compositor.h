@@ -3,23 +3,28 @@
 #include "../wl_utils/wl_types.h"
 #include "../wl_utils/wl_state.h"
 
+#include "region.h"
 #include "surface.h"
 
 class wl_compositor {
 
     wl_new_id id;
+    wl_uint version;
+
+    static constexpr wl_uint CREATE_SURFACE_OPCODE = 0;
+    static constexpr wl_uint CREATE_REGION_OPCODE = 1;
 
     public:
 
-    wl_compositor(const wl_new_id id) : id(id) {
+    wl_compositor(const wl_new_id id, const wl_uint version = 1) : id(id), version(version) {
 
     }
 
     wl_surface* create_surface(const wl_fd_t socket) {
-        wl_surface* surface = new wl_surface(wl_id_assigner.request_id());
+        wl_surface* surface = new wl_surface(wl_id_assigner.request_id(), version);
         wl_id_map.create(*surface);
 
-        wl_message client_msg(id, 0, 1);
+        wl_message client_msg(id, CREATE_SURFACE_OPCODE, 1);
         wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
 
         writer.write(surface->id);
@@ -27,7 +32,15 @@ class wl_compositor {
         return surface;
     }
 
-    void create_region(const wl_fd_t socket) {
+    wl_region* create_region(const wl_fd_t socket) {
+        wl_region* region = new wl_region(wl_id_assigner.request_id());
+        wl_id_map.create(*region);
+
+        wl_message client_msg(id, CREATE_REGION_OPCODE, 1);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+        writer.write(region->ID());
 
+        return region;
     }
 };
\ No newline at end of file
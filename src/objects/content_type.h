@@ -0,0 +1,102 @@
+#pragma once
+
+#include "../wl_utils/wl_types.h"
+#include "../wl_utils/wl_state.h"
+
+#include "surface.h"
+
+/**
+    @brief Content type: tells the compositor what kind of
+    content a surface shows, so it can tune for it.
+*/
+namespace wp {
+
+    /**
+        @brief Content type of one surface.
+    */
+    class content_type : public wl_obj {
+        const wl_object id;
+
+        static constexpr wl_uint DESTROY_OPCODE = 0;
+        static constexpr wl_uint SET_CONTENT_TYPE_OPCODE = 1;
+
+        public:
+
+        enum class type : wl_uint {
+            none = 0,
+            photo = 1,
+            video = 2,
+            game = 3,
+        };
+
+        content_type(const wl_new_id id) : id(id) {}
+
+        wl_object ID() const noexcept override {
+            return id;
+        }
+
+        /**
+            @brief Sets the type. Takes effect on the next
+            commit.
+        */
+        void set_content_type(type type) {
+            wl_message client_msg(id, SET_CONTENT_TYPE_OPCODE, 1);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(static_cast<wl_uint>(type));
+        }
+
+        void destroy() {
+            wl_message client_msg(id, DESTROY_OPCODE, 0);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+        }
+
+        void handle_event(uint16_t opcode, wl_message::reader reader) override {
+            lumber::warn("[Wayland::WARN]: wp::content_type has no events.");
+        }
+    };
+
+    /**
+        @brief Global for creating content_type objects.
+    */
+    class content_type_manager : public wl_obj {
+        const wl_object id;
+
+        static constexpr wl_uint DESTROY_OPCODE = 0;
+        static constexpr wl_uint GET_SURFACE_CONTENT_TYPE_OPCODE = 1;
+
+        public:
+
+        content_type_manager(const wl_new_id id) : id(id) {}
+
+        wl_object ID() const noexcept override {
+            return id;
+        }
+
+        /**
+            @brief Creates the content_type object of
+            @p surface. A surface can have at most one.
+        */
+        content_type& get_surface_content_type(const wl_surface& surface) {
+            content_type* type = new content_type(wl_id_assigner.request_id());
+            wl_id_map.create(*type);
+
+            wl_message client_msg(id, GET_SURFACE_CONTENT_TYPE_OPCODE, 2);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(type->ID());
+            writer.write(surface.ID());
+
+            return *type;
+        }
+
+        void destroy() {
+            wl_message client_msg(id, DESTROY_OPCODE, 0);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+        }
+
+        void handle_event(uint16_t opcode, wl_message::reader reader) override {
+            lumber::warn("[Wayland::WARN]: wp::content_type_manager has no events.");
+        }
+    };
+}
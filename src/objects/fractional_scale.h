@@ -0,0 +1,103 @@
+#pragma once
+
+#include "../wl_utils/wl_types.h"
+#include "../wl_utils/wl_state.h"
+
+#include "surface.h"
+
+/**
+    @brief Fractional scale: preferred non-integer scales
+    for surfaces, to be used together with wp_viewporter.
+*/
+namespace wp {
+
+    /**
+        @brief Reports the preferred scale of one surface.
+    */
+    class fractional_scale : public wl_obj {
+        const wl_object id;
+
+        static constexpr wl_uint DESTROY_OPCODE = 0;
+
+        static constexpr wl_uint EV_PREFERRED_SCALE_OPCODE = 0;
+
+        public:
+
+        /** Scales are sent as a numerator over this denominator. */
+        static constexpr wl_uint DENOMINATOR = 120;
+
+        struct listener {
+            /** @p scale is a numerator over `DENOMINATOR`. */
+            void (*preferred_scale)(fractional_scale& fractional_scale, wl_uint scale);
+        };
+
+        listener* listener = nullptr;
+
+        fractional_scale(const wl_new_id id) : id(id) {}
+
+        wl_object ID() const noexcept override {
+            return id;
+        }
+
+        void destroy() {
+            wl_message client_msg(id, DESTROY_OPCODE, 0);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+        }
+
+        void handle_event(uint16_t opcode, wl_message::reader reader) override {
+            if (opcode == EV_PREFERRED_SCALE_OPCODE) {
+                const wl_uint scale = reader.read_uint();
+
+                if (listener) {
+                    listener->preferred_scale(*this, scale);
+                }
+            } else {
+                lumber::warn("[Wayland::WARN]: Unimplemented event opcode for wp::fractional_scale.");
+            }
+        }
+    };
+
+    /**
+        @brief Global for creating fractional_scale objects.
+    */
+    class fractional_scale_manager : public wl_obj {
+        const wl_object id;
+
+        static constexpr wl_uint DESTROY_OPCODE = 0;
+        static constexpr wl_uint GET_FRACTIONAL_SCALE_OPCODE = 1;
+
+        public:
+
+        fractional_scale_manager(const wl_new_id id) : id(id) {}
+
+        wl_object ID() const noexcept override {
+            return id;
+        }
+
+        /**
+            @brief Creates the fractional_scale object of
+            @p surface. A surface can have at most one.
+        */
+        fractional_scale& get_fractional_scale(const wl_surface& surface) {
+            fractional_scale* scale = new fractional_scale(wl_id_assigner.request_id());
+            wl_id_map.create(*scale);
+
+            wl_message client_msg(id, GET_FRACTIONAL_SCALE_OPCODE, 2);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(scale->ID());
+            writer.write(surface.ID());
+
+            return *scale;
+        }
+
+        void destroy() {
+            wl_message client_msg(id, DESTROY_OPCODE, 0);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+        }
+
+        void handle_event(uint16_t opcode, wl_message::reader reader) override {
+            lumber::warn("[Wayland::WARN]: wp::fractional_scale_manager has no events.");
+        }
+    };
+}
@@ -2,8 +2,23 @@
 
 #include "../wl_utils/wl_types.h"
 #include "../wl_utils/wl_state.h"
+#include "../buffers/input_ring.h"
+#include "../buffers/key_repeat.h"
+#include "../buffers/keymap.h"
 #include "surface.h"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
 /**
     @brief Keyboard
 */
@@ -35,18 +50,82 @@ class wl_keyboard : public wl_obj {
     struct listener {
         
         void (*key)(wl_uint serial, wl_uint time, wl_uint key, key_state state);
+        /** Optional. `keysym()` already reflects the new modifiers. */
+        void (*modifiers)(wl_uint serial, wl_uint depressed, wl_uint latched, wl_uint locked, wl_uint group);
     };
 
     listener* listener = nullptr;
 
+    /** Also gets every key event, for a consumer on another thread. */
+    wl::input_ring* ring = nullptr;
+
     wl_keyboard(const wl_new_id id) : id(id) {
 
     }
 
+    wl_keyboard(const wl_keyboard&) = delete;
+    wl_keyboard& operator=(const wl_keyboard&) = delete;
+
+    /** Waits for a keymap that is being parsed. */
+    ~wl_keyboard() {
+        {
+            std::lock_guard lock(keymap_mutex);
+            stopping = true;
+
+            if (queued_keymap) {
+                close(queued_keymap->fd);
+            }
+        }
+
+        keymap_queued.notify_one();
+
+        if (keymap_worker.joinable()) {
+            keymap_worker.join();
+        }
+    }
+
     wl_object ID() const noexcept override {
         return id;
     }
 
+    /**
+        @brief Keysym of evdev key code @p key under the
+        current modifiers, or `wl::keymap::NO_SYMBOL` if no
+        keymap has been parsed yet.
+    */
+    wl_uint keysym(const wl_uint key) const noexcept {
+        return current_keymap ? current_keymap->keysym(key) : wl::keymap::NO_SYMBOL;
+    }
+
+    /** The keymap in use, if any. */
+    const wl::keymap* keymap() const noexcept {
+        return current_keymap.get();
+    }
+
+    /**
+        @brief Readable when key repeats are due; then call
+        `dispatch_repeat()`. Only armed while a key repeats.
+    */
+    int repeat_fd() const noexcept {
+        return repeat.fd();
+    }
+
+    /**
+        @brief Sends the due repeats of the held key to the
+        listener as `key_state::repeated` key events.
+    */
+    void dispatch_repeat() {
+        repeat.dispatch([this](const wl_uint key, const wl_uint time) {
+            if (ring) {
+                ring->push(wl::input_event_type::key, time, key, static_cast<uint8_t>(key_state::repeated), 0, 0);
+            }
+
+            if (listener) {
+                listener->key(repeat_serial, time, key, key_state::repeated);
+            }
+        });
+    }
+
     void handle_event(uint16_t opcode, wl_message::reader reader) override {
         if (!listener) {
             throw std::runtime_error("No listener supplied for wl_keybard.");
@@ -55,39 +134,169 @@ class wl_keyboard : public wl_obj {
         if (opcode == EV_KEYMAP_OPCODE) {
             
 			const keymap_format format = static_cast<keymap_format>(reader.read_uint());
+			const wl_fd_t fd = reader.read_fd();
 			const wl_uint size = reader.read_uint();
 
 			if (format == keymap_format::no_keymap) {
-				std::cout << "keymap_format::no_keymap\n";
+				close(fd);
+				current_keymap.reset();
+				pending_keymap = {};
 			} else if (format == keymap_format::xkb_v1) {
-				std::cout << "keymap_format::xkb_v1\n";
+				// Mapped and parsed off this thread; keys keep using
+				// the old keymap until the new one is ready.
+				std::promise<std::unique_ptr<wl::keymap>> result;
+				pending_keymap = result.get_future();
+				queue_keymap({ static_cast<int>(fd), size, std::move(result) });
 			} else {
 				lumber::err("[Wayland::ERR]: Invalid keymap format\n");
 				exit(1);
 			}
 
-			std::cout << "wl::keyboard::keymap::fd: " << 0 << '\n'; 
-			std::cout << "wl::keyboard::keymap::size: " << size << '\n'; 
-
         } else if (opcode == EV_ENTER_OPCODE) {
             //std::cout << "ENTER\n";
         } else if (opcode == EV_LEAVE_OPCODE) {
-            //std::cout << "LEAVE\n";
+            // Keys still held when focus left are never released to us.
+            repeat.cancel();
         } else if (opcode == EV_KEY_OPCODE) {
             const wl_uint serial = reader.read_uint();
             const wl_uint time = reader.read_uint();
             const wl_uint key = reader.read_uint();
             const key_state state = static_cast<key_state>(reader.read_uint());
 
+            adopt_keymap();
+
+            if (state == key_state::pressed) {
+                if (!current_keymap || current_keymap->repeats(key)) {
+                    repeat.press(key, time);
+                    repeat_serial = serial;
+                }
+            } else if (state == key_state::released) {
+                repeat.release(key);
+            }
+
+            if (ring) {
+                ring->push(wl::input_event_type::key, time, key, static_cast<uint8_t>(state), 0, 0);
+            }
+
             listener->key(serial, time, key, state);
         } else if (opcode == EV_MODIFIERS_OPCODE) {
-            //std::cout << "MOD\n";
+            const wl_uint serial = reader.read_uint();
+            mods_depressed = reader.read_uint();
+            mods_latched = reader.read_uint();
+            mods_locked = reader.read_uint();
+            group = reader.read_uint();
+
+            adopt_keymap();
+
+            if (current_keymap) {
+                current_keymap->set_modifiers(mods_depressed, mods_latched, mods_locked, group);
+            }
+
+            if (listener->modifiers) {
+                listener->modifiers(serial, mods_depressed, mods_latched, mods_locked, group);
+            }
         } else if (opcode == EV_REPEAT_INFO_OPCODE) {
-            //std::cout << "REPEAT\n";
+            const wl_int rate = reader.read_int();
+            const wl_int delay = reader.read_int();
+
+            repeat.set_info(rate, delay);
         } else {
 			lumber::warn("[Wayland::WARN]: Unimplemented event opcode for wl::keyboard.");
 		}
     }
+
+    private:
+
+    std::unique_ptr<wl::keymap> current_keymap;
+    std::future<std::unique_ptr<wl::keymap>> pending_keymap;
+
+    struct keymap_load {
+        int fd;
+        wl_uint size;
+        std::promise<std::unique_ptr<wl::keymap>> result;
+    };
+
+    /**
+        One worker parses keymaps, started with the first
+        one. Only the newest keymap waits for it; one that is
+        replaced before its parse starts is dropped.
+    */
+    std::thread keymap_worker;
+    std::mutex keymap_mutex;
+    std::condition_variable keymap_queued;
+    std::optional<keymap_load> queued_keymap;
+    bool stopping = false;
+
+    void queue_keymap(keymap_load load) {
+        {
+            std::lock_guard lock(keymap_mutex);
+
+            if (queued_keymap) {
+                close(queued_keymap->fd);
+            }
+
+            queued_keymap = std::move(load);
+        }
+
+        keymap_queued.notify_one();
+
+        if (!keymap_worker.joinable()) {
+            keymap_worker = std::thread(&wl_keyboard::load_keymaps, this);
+        }
+    }
+
+    void load_keymaps() {
+        std::unique_lock lock(keymap_mutex);
+
+        while (true) {
+            keymap_queued.wait(lock, [this] { return stopping || queued_keymap; });
+
+            if (stopping) { return; }
+
+            keymap_load load = std::move(*queued_keymap);
+            queued_keymap.reset();
+            lock.unlock();
+
+            try {
+                std::unique_ptr<wl::keymap> keymap = std::make_unique<wl::keymap>(load.fd, load.size);
+                keymap->parse();
+                load.result.set_value(std::move(keymap));
+            } catch (...) {
+                load.result.set_exception(std::current_exception());
+            }
+
+            lock.lock();
+        }
+    }
+
+    wl::key_repeat repeat;
+    /** Serial of the press being repeated. */
+    wl_uint repeat_serial = 0;
+
+    wl_uint mods_depressed = 0;
+    wl_uint mods_latched = 0;
+    wl_uint mods_locked = 0;
+    wl_uint group = 0;
+
+    /**
+        Switches to a keymap parsed in the background. Only
+        the first keymap is waited for; a replacement is
+        picked up once it's ready, so it never stalls keys.
+    */
+    void adopt_keymap() {
+        if (!pending_keymap.valid()) { return; }
+
+        if (current_keymap && pending_keymap.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
+
+        try {
+            current_keymap = pending_keymap.get();
+            current_keymap->set_modifiers(mods_depressed, mods_latched, mods_locked, group);
+        } catch (const std::runtime_error& error) {
+            lumber::warn(("[Wayland::WARN]: Failed to load keymap: " + std::string(error.what())).c_str());
+        }
+    }
 };
 
 /**
@@ -135,10 +344,72 @@ class wl_pointer : public wl_obj {
         inverted = 1,
     };
 
+    struct motion_sample {
+        wl_uint time;
+        wl_fixed surface_x;
+        wl_fixed surface_y;
+    };
+
+    struct button_event {
+        wl_uint serial;
+        wl_uint time;
+        wl_uint button;
+        button_state state;
+    };
+
+    /** Everything one axis did within a frame. */
+    struct axis_frame {
+        bool changed = false;
+        wl_uint time = 0;
+        /** Sum of all axis values. */
+        wl_fixed value = 0;
+        /** Sum of all discrete steps (before version 8). */
+        wl_int discrete = 0;
+        /** Sum of all high-resolution wheel steps, in 1/120ths. */
+        wl_int value120 = 0;
+        bool stop = false;
+        axis_relative_direction direction = axis_relative_direction::identical;
+    };
+
+    /**
+        @brief All events between two wl_pointer.frame
+        events, folded into one.
+    */
+    struct pointer_frame {
+        /** The pointer entered a surface at (surface_x, surface_y). */
+        bool entered = false;
+        /** The pointer left `left_surface`. Can be set along with `entered`. */
+        bool left = false;
+        wl_uint serial = 0;
+        wl_object surface = NULL_OBJ_ID;
+        wl_object left_surface = NULL_OBJ_ID;
+
+        /** Set if the position changed, by motion or by entering. */
+        bool moved = false;
+        wl_uint time = 0;
+        wl_fixed surface_x = 0;
+        wl_fixed surface_y = 0;
+        /** Number of motion events folded into the position. */
+        wl_uint motion_count = 0;
+
+        /** Every button change, in order, so quick clicks aren't lost. */
+        std::vector<button_event> buttons;
+
+        axis_frame axes[2];
+        std::optional<axis_source> source;
+
+        /** Every motion event, only kept with `keep_motion_samples`. */
+        std::vector<motion_sample> samples;
+
+        const axis_frame& axis(const enum axis axis) const noexcept {
+            return axes[static_cast<wl_uint>(axis) & 1];
+        }
+    };
+
     struct listener {
         void (*enter)(wl_uint serial, wl_object surface, wl_fixed surface_x, wl_fixed surface_y);
         void (*leave)(wl_uint serial, wl_object surface);
-        void (*motion)(wl_uint serial, wl_fixed surface_x, wl_fixed surface_y);
+        void (*motion)(wl_uint time, wl_fixed surface_x, wl_fixed surface_y);
         void (*button)(wl_uint serial, wl_uint time, wl_uint button, enum button_state state);
         void (*axis)(wl_uint time, enum axis axis, wl_fixed value);
         void (*frame)();
@@ -147,14 +418,43 @@ class wl_pointer : public wl_obj {
         void (*axis_discrete)(enum axis axis, wl_int discrete);
         void (*axis_value120)(enum axis axis, wl_int value120);
         void (*axis_relative_direction)(enum axis axis, enum axis_relative_direction direction);
+
+        /**
+            Used instead of all of the above once
+            `set_accumulate(true)` is called.
+        */
+        void (*accumulated_frame)(wl_pointer& pointer, const pointer_frame& frame);
     };
 
     listener* listener = nullptr;
 
+    /**
+        Also gets every enter, leave, motion, button and
+        axis event, for a consumer on another thread.
+    */
+    wl::input_ring* ring = nullptr;
+
     wl_pointer(const wl_new_id id) : id(id) {
 
     }
 
+    /**
+        @brief Switches between one listener call per event
+        and one `accumulated_frame` call per wl_pointer.frame.
+
+        High polling rate mice send a motion event per
+        sample; accumulating keeps the work per frame
+        constant however many arrive.
+    */
+    void set_accumulate(const bool enabled) noexcept {
+        accumulate = enabled;
+    }
+
+    /** @brief Also records each motion event in `pointer_frame::samples`. */
+    void keep_motion_samples(const bool enabled) noexcept {
+        keep_samples = enabled;
+    }
+
     wl_object ID() const noexcept override {
         return id;
     }
@@ -187,6 +487,15 @@ class wl_pointer : public wl_obj {
             throw std::runtime_error("No listener supplied for wl_mouse.");
         }
 
+        if (ring) {
+            record(opcode, reader);
+        }
+
+        if (accumulate) {
+            accumulate_event(opcode, reader);
+            return;
+        }
+
         if (opcode == EV_ENTER_OPCODE) {
             const wl_uint serial = reader.read_uint();
             const wl_object surface = reader.read_object();
@@ -200,11 +509,11 @@ class wl_pointer : public wl_obj {
 
             listener->leave(serial, surface);
         } else if (opcode == EV_MOTION_OPCODE) {
-            const wl_uint serial = reader.read_uint();
+            const wl_uint time = reader.read_uint();
             const wl_fixed surface_x = reader.read_fixed();
             const wl_fixed surface_y = reader.read_fixed();
 
-            listener->motion(serial, surface_x, surface_y);
+            listener->motion(time, surface_x, surface_y);
         } else if (opcode == EV_BUTTON_OPCODE) {
             const wl_uint serial = reader.read_uint();
             const wl_uint time = reader.read_uint();
@@ -241,6 +550,318 @@ class wl_pointer : public wl_obj {
             listener->axis_relative_direction(axis, relative_direction);
         }
     }
+
+    private:
+
+    bool accumulate = false;
+    bool keep_samples = false;
+    pointer_frame current;
+
+    /** Reads its own copy of @p reader, so the listeners still see the whole event. */
+    void record(const uint16_t opcode, wl_message::reader reader) {
+        using type = wl::input_event_type;
+
+        if (opcode == EV_ENTER_OPCODE) {
+            reader.read_uint();
+            reader.read_object();
+            const wl_fixed surface_x = reader.read_fixed();
+            const wl_fixed surface_y = reader.read_fixed();
+
+            ring->push_now(type::pointer_enter, 0, 0, surface_x, surface_y);
+        } else if (opcode == EV_LEAVE_OPCODE) {
+            ring->push_now(type::pointer_leave);
+        } else if (opcode == EV_MOTION_OPCODE) {
+            const wl_uint time = reader.read_uint();
+            const wl_fixed surface_x = reader.read_fixed();
+            const wl_fixed surface_y = reader.read_fixed();
+
+            ring->push(type::pointer_motion, time, 0, 0, surface_x, surface_y);
+        } else if (opcode == EV_BUTTON_OPCODE) {
+            reader.read_uint();
+            const wl_uint time = reader.read_uint();
+            const wl_uint button = reader.read_uint();
+            const wl_uint state = reader.read_uint();
+
+            ring->push(type::pointer_button, time, button, static_cast<uint8_t>(state), 0, 0);
+        } else if (opcode == EV_AXIS_OPCODE) {
+            const wl_uint time = reader.read_uint();
+            const wl_uint axis = reader.read_uint();
+            const wl_fixed value = reader.read_fixed();
+
+            ring->push(type::pointer_axis, time, axis, 0, value, 0);
+        }
+    }
+
+    axis_frame& axis_at(const wl_uint axis) noexcept {
+        return current.axes[axis & 1];
+    }
+
+    void accumulate_event(uint16_t opcode, wl_message::reader& reader) {
+        if (opcode == EV_ENTER_OPCODE) {
+            current.entered = true;
+            current.serial = reader.read_uint();
+            current.surface = reader.read_object();
+            current.surface_x = reader.read_fixed();
+            current.surface_y = reader.read_fixed();
+            current.moved = true;
+        } else if (opcode == EV_LEAVE_OPCODE) {
+            current.left = true;
+            current.serial = reader.read_uint();
+            current.left_surface = reader.read_object();
+        } else if (opcode == EV_MOTION_OPCODE) {
+            current.time = reader.read_uint();
+            current.surface_x = reader.read_fixed();
+            current.surface_y = reader.read_fixed();
+            current.moved = true;
+            current.motion_count++;
+
+            if (keep_samples) {
+                current.samples.push_back({ current.time, current.surface_x, current.surface_y });
+            }
+        } else if (opcode == EV_BUTTON_OPCODE) {
+            button_event button;
+            button.serial = reader.read_uint();
+            button.time = reader.read_uint();
+            button.button = reader.read_uint();
+            button.state = static_cast<button_state>(reader.read_uint());
+
+            current.buttons.push_back(button);
+        } else if (opcode == EV_AXIS_OPCODE) {
+            const wl_uint time = reader.read_uint();
+            axis_frame& axis = axis_at(reader.read_uint());
+
+            axis.changed = true;
+            axis.time = time;
+            axis.value += reader.read_fixed();
+        } else if (opcode == EV_FRAME_OPCODE) {
+            listener->accumulated_frame(*this, current);
+
+            // Cleared rather than replaced, so the vectors keep their capacity.
+            std::vector<button_event> buttons = std::move(current.buttons);
+            std::vector<motion_sample> samples = std::move(current.samples);
+
+            buttons.clear();
+            samples.clear();
+
+            current = {};
+            current.buttons = std::move(buttons);
+            current.samples = std::move(samples);
+        } else if (opcode == EV_AXIS_SOURCE_OPCODE) {
+            current.source = static_cast<axis_source>(reader.read_uint());
+        } else if (opcode == EV_AXIS_STOP_OPCODE) {
+            const wl_uint time = reader.read_uint();
+            axis_frame& axis = axis_at(reader.read_uint());
+
+            axis.changed = true;
+            axis.time = time;
+            axis.stop = true;
+        } else if (opcode == EV_AXIS_DISCRETE_OPCODE) {
+            axis_frame& axis = axis_at(reader.read_uint());
+
+            axis.changed = true;
+            axis.discrete += reader.read_int();
+        } else if (opcode == EV_AXIS_VALUE120_OPCODE) {
+            axis_frame& axis = axis_at(reader.read_uint());
+
+            axis.changed = true;
+            axis.value120 += reader.read_int();
+        } else if (opcode == EV_AXIS_RELATIVE_DIRECTION_OPCODE) {
+            axis_frame& axis = axis_at(reader.read_uint());
+
+            axis.direction = static_cast<axis_relative_direction>(reader.read_uint());
+        }
+    }
+};
+
+/**
+    @brief Touchscreen
+*/
+class wl_touch final : public wl_obj {
+    wl_object id;
+
+    static constexpr wl_uint RELEASE_OPCODE = 0;
+
+    static constexpr wl_uint EV_DOWN_OPCODE = 0;
+    static constexpr wl_uint EV_UP_OPCODE = 1;
+    static constexpr wl_uint EV_MOTION_OPCODE = 2;
+    static constexpr wl_uint EV_FRAME_OPCODE = 3;
+    static constexpr wl_uint EV_CANCEL_OPCODE = 4;
+    static constexpr wl_uint EV_SHAPE_OPCODE = 5;
+    static constexpr wl_uint EV_ORIENTATION_OPCODE = 6;
+
+    public:
+
+    /** First version with `release`. */
+    static constexpr wl_uint RELEASE_VERSION = 3;
+
+    /** Touch points tracked at once; more fingers are ignored. */
+    static constexpr size_t MAX_POINTS = 10;
+
+    /** One finger, as of the end of a frame. */
+    struct touch_point {
+        /** The slot holds a finger that is down, or went up in this frame. */
+        bool active = false;
+        wl_int id = 0;
+        wl_object surface = NULL_OBJ_ID;
+        /** Serial of the down or up event. */
+        wl_uint serial = 0;
+        wl_uint time = 0;
+        wl_fixed x = 0;
+        wl_fixed y = 0;
+
+        /** What happened to the point within the frame. */
+        bool down = false;
+        bool up = false;
+        bool moved = false;
+
+        /** Contact ellipse, once the compositor has sent one. */
+        bool has_shape = false;
+        wl_fixed major = 0;
+        wl_fixed minor = 0;
+
+        /** Angle of the ellipse's major axis, in degrees. */
+        bool has_orientation = false;
+        wl_fixed orientation = 0;
+    };
+
+    /**
+        @brief All points after one wl_touch.frame: the ones
+        that changed, and the ones held still.
+    */
+    struct touch_frame {
+        std::array<touch_point, MAX_POINTS> points;
+        /** Time of the newest event in the frame. */
+        wl_uint time = 0;
+
+        /** Number of active points. */
+        size_t count() const noexcept {
+            return std::count_if(points.begin(), points.end(), [](const touch_point& point) { return point.active; });
+        }
+    };
+
+    struct listener {
+        void (*frame)(wl_touch& touch, const touch_frame& frame);
+        /** The compositor took over the touch sequence; every point is gone. */
+        void (*cancel)(wl_touch& touch);
+    };
+
+    listener* listener = nullptr;
+
+    /** Version of wl_seat the touch was created from. */
+    const wl_uint version;
+
+    wl_touch(const wl_new_id id, const wl_uint version = 1) : id(id), version(version) {
+
+    }
+
+    wl_object ID() const noexcept override {
+        return id;
+    }
+
+    void release() {
+        wl_message client_msg(this->id, RELEASE_OPCODE, 0);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+    }
+
+    void handle_event(uint16_t opcode, wl_message::reader reader) override {
+        if (opcode == EV_DOWN_OPCODE) {
+            const wl_uint serial = reader.read_uint();
+            const wl_uint time = reader.read_uint();
+            const wl_object surface = reader.read_object();
+            const wl_int id = reader.read_int();
+
+            touch_point* point = allocate(id);
+
+            if (!point) {
+                lumber::warn("[Wayland::WARN]: Too many touch points, ignoring one.");
+                return;
+            }
+
+            point->surface = surface;
+            point->serial = serial;
+            point->time = current.time = time;
+            point->x = reader.read_fixed();
+            point->y = reader.read_fixed();
+            point->down = true;
+        } else if (opcode == EV_UP_OPCODE) {
+            const wl_uint serial = reader.read_uint();
+            const wl_uint time = reader.read_uint();
+
+            if (touch_point* point = find(reader.read_int())) {
+                point->serial = serial;
+                point->time = current.time = time;
+                point->up = true;
+            }
+        } else if (opcode == EV_MOTION_OPCODE) {
+            const wl_uint time = reader.read_uint();
+
+            if (touch_point* point = find(reader.read_int())) {
+                point->time = current.time = time;
+                point->x = reader.read_fixed();
+                point->y = reader.read_fixed();
+                point->moved = true;
+            }
+        } else if (opcode == EV_FRAME_OPCODE) {
+            if (listener) {
+                listener->frame(*this, current);
+            }
+
+            // Lifted points free their slot; the rest carry over.
+            for (touch_point& point : current.points) {
+                if (point.up) {
+                    point = {};
+                } else {
+                    point.down = false;
+                    point.moved = false;
+                }
+            }
+        } else if (opcode == EV_CANCEL_OPCODE) {
+            current = {};
+
+            if (listener) {
+                listener->cancel(*this);
+            }
+        } else if (opcode == EV_SHAPE_OPCODE) {
+            if (touch_point* point = find(reader.read_int())) {
+                point->has_shape = true;
+                point->major = reader.read_fixed();
+                point->minor = reader.read_fixed();
+            }
+        } else if (opcode == EV_ORIENTATION_OPCODE) {
+            if (touch_point* point = find(reader.read_int())) {
+                point->has_orientation = true;
+                point->orientation = reader.read_fixed();
+            }
+        } else {
+            lumber::warn("[Wayland::WARN]: Unimplemented event opcode for wl::touch.");
+        }
+    }
+
+    private:
+
+    touch_frame current;
+
+    /** The point of a finger that is still down. */
+    touch_point* find(const wl_int id) noexcept {
+        for (touch_point& point : current.points) {
+            if (point.active && !point.up && point.id == id) { return &point; }
+        }
+
+        return nullptr;
+    }
+
+    touch_point* allocate(const wl_int id) noexcept {
+        for (touch_point& point : current.points) {
+            if (!point.active) {
+                point = {};
+                point.active = true;
+                point.id = id;
+                return &point;
+            }
+        }
+
+        return nullptr;
+    }
 };
 
 /**
@@ -254,15 +875,31 @@ class wl_seat : public wl_obj {
     static constexpr wl_uint GET_TOUCH_OPCODE = 2;
     static constexpr wl_uint RELEASE_OPCODE = 3;
 
+    static constexpr wl_uint EV_CAPABILITIES_OPCODE = 0;
+    static constexpr wl_uint EV_NAME_OPCODE = 1;
+
+    wl_uint capabilities = 0;
+
     public:
 
+    enum class capability : wl_uint {
+        pointer = 1,
+        keyboard = 2,
+        touch = 4,
+    };
+
     struct listener {
-        
+        /** Sent on bind and whenever devices come or go. */
+        void (*capabilities)(wl_seat& seat, wl_uint capabilities);
+        void (*name)(wl_seat& seat, const wl_string& name);
     };
 
     listener* listener = nullptr;
 
-    wl_seat(const wl_new_id id) : id(id) {
+    /** Version the seat was bound at. */
+    const wl_uint version;
+
+    wl_seat(const wl_new_id id, const wl_uint version = 1) : id(id), version(version) {
 
     }
 
@@ -270,9 +907,26 @@ class wl_seat : public wl_obj {
         return id;
     }
 
+    /** Whether the seat has a device of type @p capability, as last announced. */
+    bool has(const capability capability) const noexcept {
+        return (capabilities & static_cast<wl_uint>(capability)) != 0;
+    }
+
     void handle_event(uint16_t opcode, wl_message::reader reader) override {
-        if (!listener) {
-            throw std::runtime_error("No listener supplied for wl_seat.");
+        if (opcode == EV_CAPABILITIES_OPCODE) {
+            capabilities = reader.read_uint();
+
+            if (listener && listener->capabilities) {
+                listener->capabilities(*this, capabilities);
+            }
+        } else if (opcode == EV_NAME_OPCODE) {
+            const wl_string name = reader.read_string();
+
+            if (listener && listener->name) {
+                listener->name(*this, name);
+            }
+        } else {
+            lumber::warn("[Wayland::WARN]: Unimplemented event opcode for wl::seat.");
         }
     }
 
@@ -302,6 +956,19 @@ class wl_seat : public wl_obj {
         return keyboard;
     }
 
+    wl_touch* get_touch() {
+        wl_touch* touch = new wl_touch(wl_id_assigner.request_id(), version);
+
+        wl_message client_msg(id, GET_TOUCH_OPCODE, 1);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+        writer.write(touch->ID());
+
+        wl_id_map.create(*touch);
+
+        return touch;
+    }
+
     void release() {
         
     }
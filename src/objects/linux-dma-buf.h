@@ -1,9 +1,17 @@
 #pragma once
 
 #include "../wl_utils/wl_obj.h"
+#include "../buffers/format_table.h"
+#include "buffer.h"
 #include "surface.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <sys/types.h>
+#include <vector>
 #include <drm/drm_fourcc.h>
 #include <drm/drm_mode.h>
 
@@ -16,6 +24,11 @@ namespace zwp::linux_dmabuf {
     /**
         @brief Parameters for the creation of a dmabuf-
         based wl_buffer.
+
+        Collects one `add` per plane, then creates the
+        buffer with either `create` (answered by `created` or
+        `failed`) or `create_immed`. Each params object can
+        create a single buffer.
     */
     class params : public wl_obj {
 		const wl_uint id;
@@ -30,31 +43,129 @@ namespace zwp::linux_dmabuf {
 
 		public:
 
+		/** Flags for `create` and `create_immed`. */
+		static constexpr wl_uint FLAG_Y_INVERT = 0x1;
+		static constexpr wl_uint FLAG_INTERLACED = 0x2;
+		static constexpr wl_uint FLAG_BOTTOM_FIRST = 0x4;
+
+		struct listener {
+			/** The buffer from `create` was imported. The caller owns it. */
+			void (*created)(params& params, wl_buffer& buffer);
+			/**
+				Importing failed. Also sent for `create_immed`
+				by compositors that don't make it a protocol
+				error; the buffer is then unusable.
+			*/
+			void (*failed)(params& params);
+		};
+
+		listener* listener = nullptr;
+
+		/** Free slot for the listener to find its owner. */
+		void* user_data = nullptr;
+
 		params(const wl_uint id) : id(id) {}
 
 		void handle_event(uint16_t opcode, wl_message::reader reader) override {
-			std::cout << "Params ev\n";
+			if (opcode == EV_CREATED_OPCODE) {
+				// Created by the compositor, so the id is from its range.
+				wl_buffer* buffer = new wl_buffer(reader.read_object());
+				wl_id_map.create(*buffer);
+
+				if (listener) {
+					listener->created(*this, *buffer);
+				}
+			} else if (opcode == EV_FAILED_OPCODE) {
+				if (listener) {
+					listener->failed(*this);
+				} else {
+					lumber::warn("[Wayland::WARN]: Failed to import dmabuf.");
+				}
+			} else {
+				lumber::warn("[Wayland::WARN]: Unimplemented event opcode for zwp::linux_dmabuf::params.");
+			}
 		}
 
 		wl_object ID() const noexcept override {
 			return id;
 		}
 
-		void add(wl_fd_t fd, wl_uint plane_idx, wl_uint offset, wl_uint stride, uint64_t modifiers) {
-			wl_message client_msg(id, ADD_OPCODE, 6);
+		/**
+			@brief Adds a plane.
+
+			@p fd is sent with the request and must stay open
+			until the send queue has been flushed.
+		*/
+		void add(wl_fd_t fd, wl_uint plane_idx, wl_uint offset, wl_uint stride, uint64_t modifier) {
+			wl_message client_msg(id, ADD_OPCODE, 5);
 			wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
 
-			//writer.write(fd);
-			//writer.write(plane_idx);
-			//writer.write(offset);
-			//writer.write(stride);
-			//writer.write((modifiers >> 32) & 0xFFFF);
-			//writer.write((modifiers) & 0xFFFF);
+			send_queue.AddFD(fd);
 
+			writer.write(plane_idx);
+			writer.write(offset);
+			writer.write(stride);
+			writer.write(static_cast<wl_uint>(modifier >> 32));
+			writer.write(static_cast<wl_uint>(modifier & 0xFFFFFFFF));
 		}
 
+		/**
+			@brief Asks the compositor to import the planes
+			as a buffer; answered by `created` or `failed`.
+		*/
+		void create(wl_int width, wl_int height, wl_uint format, wl_uint flags) {
+			wl_message client_msg(id, CREATE_OPCODE, 4);
+			wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+			writer.write(width);
+			writer.write(height);
+			writer.write(format);
+			writer.write(flags);
+		}
+
+		/**
+			@brief Creates the buffer right away, without a
+			round trip. If the import fails, the compositor
+			either sends `failed` or raises a protocol error.
+			The caller owns the buffer.
+		*/
+		wl_buffer& create_immed(wl_int width, wl_int height, wl_uint format, wl_uint flags) {
+			wl_buffer* buffer = new wl_buffer(wl_id_assigner.request_id());
+			wl_id_map.create(*buffer);
+
+			wl_message client_msg(id, CREATE_IMMED_OPCODE, 5);
+			wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+			writer.write(buffer->ID());
+			writer.write(width);
+			writer.write(height);
+			writer.write(format);
+			writer.write(flags);
+
+			return *buffer;
+		}
+
+		/**
+			@brief Destroys the params object. Buffers created
+			from it stay valid.
+		*/
+		void destroy() {
+			wl_message client_msg(id, DESTROY_OPCODE, 0);
+			wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+		}
     };
 
+    /**
+        @brief The compositor's format/modifier preferences,
+        for one surface or as a default.
+
+        Preferences arrive as a batch ending in `done`, and
+        are re-sent whenever they change (e.g. the surface
+        moves to a scanout-capable plane). Each batch is
+        decoded into a pending set and swapped in on `done`.
+        The format table is only re-sent when it changes, so
+        the current mapping is kept otherwise.
+    */
     class feedback : public wl_obj {
 		const wl_uint id;
 
@@ -70,42 +181,177 @@ namespace zwp::linux_dmabuf {
 
 		public:
 
+		/** Buffers in the tranche's formats can be scanned out directly. */
+		static constexpr wl_uint TRANCHE_FLAG_SCANOUT = 0x1;
+
+		/**
+			@brief A set of format/modifier pairs for one
+			target device, as indices into the format table.
+		*/
+		struct tranche {
+			dev_t target_device = 0;
+			wl_uint flags = 0;
+			std::vector<uint16_t> indices;
+
+			bool scanout() const noexcept {
+				return flags & TRANCHE_FLAG_SCANOUT;
+			}
+		};
+
+		/** A format/modifier pair and the tranche it came from. */
+		struct choice {
+			wl_uint format;
+			uint64_t modifier;
+			const tranche* source;
+		};
+
+		struct listener {
+			/** A full set of preferences has been applied. */
+			void (*done)(feedback& feedback);
+		};
+
+		listener* listener = nullptr;
+
 		feedback(const wl_uint id) : id(id) {}
 
-		void handle_event(uint16_t opcode, wl_message::reader reader) override {
-			std::cout << "feedback ev\n";
+		void destroy() {
+			wl_message client_msg(id, DESTROY_OPCODE, 0);
+			wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+		}
 
+		void handle_event(uint16_t opcode, wl_message::reader reader) override {
 			if (opcode == EV_DONE_OPCODE) {
-				//std::cout << "Done\n";
+				apply();
+
+				if (listener) {
+					listener->done(*this);
+				}
 			} else if (opcode == EV_FORMAT_TABLE_OPCODE) {
-				//std::cout << "Format table\n";
+				const wl_fd_t fd = reader.read_fd();
+				const wl_uint size = reader.read_uint();
+
+				try {
+					pending_table = wl::format_table(fd, size);
+				} catch (const std::runtime_error& error) {
+					lumber::warn("[Wayland::WARN]: Failed to map dmabuf format table.");
+				}
 			} else if (opcode == EV_MAIN_DEVICE_OPCODE) {
-				//std::cout << "Tranche main device\n";
+				pending_main_device = read_device(reader);
 			} else if (opcode == EV_TRANCHE_DONE_OPCODE) {
-				//std::cout << "Tranche done\n";
+				pending_tranches.push_back(std::move(pending_tranche));
+				pending_tranche = {};
 			} else if (opcode == EV_TRANCHE_TARGET_DEVICE_OPCODE) {
-				//std::cout << "Tranche target device\n";
+				pending_tranche.target_device = read_device(reader);
 			} else if (opcode == EV_TRANCHE_FORMATS_OPCODE) {
-				//std::cout << "Tranche formats\n";
+				const wl_message::reader::array_view indices = reader.read_array_view();
+				const size_t count = indices.size / sizeof(uint16_t);
+				const size_t offset = pending_tranche.indices.size();
 
-				
+				// May be sent more than once per tranche.
+				pending_tranche.indices.resize(offset + count);
+				memcpy(pending_tranche.indices.data() + offset, indices.data, count * sizeof(uint16_t));
 			} else if (opcode == EV_TRANCHE_FLAGS_OPCODE) {
-				//std::cout << "Tranche flags\n";
+				pending_tranche.flags = reader.read_uint();
 			} else {
-				lumber::warn("[Wayland::WARN]: Unimplemented dmabuf feedback ev");
+				lumber::warn("[Wayland::WARN]: Unimplemented event opcode for zwp::linux_dmabuf::feedback.");
 			}
 		}
 
 		wl_object ID() const noexcept override {
 			return id;
 		}
+
+		const wl::format_table& format_table() const noexcept {
+			return table;
+		}
+
+		/** The device the compositor renders with. */
+		dev_t main_device() const noexcept {
+			return current_main_device;
+		}
+
+		/** Tranches, most preferred first. */
+		const std::vector<tranche>& tranches() const noexcept {
+			return current_tranches;
+		}
+
+		/**
+			@brief Returns the compositor's most preferred
+			pair for which @p accept returns `true`, e.g. the
+			formats and modifiers the caller can write.
+
+			Earlier tranches win, so a pair from a scanout
+			tranche is picked over the same pair elsewhere.
+		*/
+		template<class Accept>
+		std::optional<choice> best_format(Accept&& accept) const {
+			for (const tranche& tranche : current_tranches) {
+				for (const uint16_t index : tranche.indices) {
+					const wl::format_table::entry& entry = table[index];
+
+					if (accept(entry.format, entry.modifier)) {
+						return choice { entry.format, entry.modifier, &tranche };
+					}
+				}
+			}
+
+			return std::nullopt;
+		}
+
+		/** @brief The most preferred modifier for @p format. */
+		std::optional<choice> best_format(const wl_uint format) const {
+			return best_format([format](const wl_uint candidate, uint64_t) { return candidate == format; });
+		}
+
+		/** @brief Whether any tranche lists @p format with @p modifier. */
+		bool supports(const wl_uint format, const uint64_t modifier) const {
+			return best_format([=](const wl_uint candidate, const uint64_t candidate_modifier) {
+				return candidate == format && candidate_modifier == modifier;
+			}).has_value();
+		}
+
+		private:
+
+		wl::format_table table;
+		dev_t current_main_device = 0;
+		std::vector<tranche> current_tranches;
+
+		std::optional<wl::format_table> pending_table;
+		dev_t pending_main_device = 0;
+		std::vector<tranche> pending_tranches;
+		tranche pending_tranche;
+
+		/** dev_t is sent as an array holding its native bytes. */
+		static dev_t read_device(wl_message::reader& reader) {
+			const wl_message::reader::array_view array = reader.read_array_view();
+			dev_t device = 0;
+
+			memcpy(&device, array.data, std::min<size_t>(array.size, sizeof(device)));
+			return device;
+		}
+
+		void apply() {
+			if (pending_table) {
+				table = std::move(*pending_table);
+				pending_table.reset();
+			}
+
+			// Drop indices a misbehaving compositor sent past the table.
+			for (tranche& tranche : pending_tranches) {
+				const size_t size = table.size();
+				const auto past_end = std::remove_if(tranche.indices.begin(), tranche.indices.end(), [size](const uint16_t index) { return index >= size; });
+				tranche.indices.erase(past_end, tranche.indices.end());
+			}
+
+			current_main_device = pending_main_device;
+			current_tranches = std::move(pending_tranches);
+			pending_tranches.clear();
+		}
     };
 
 	/**
         @brief Factory object for creating dmabuf-based
         wl_buffers.
-
-        @note
     */
     class dmabuf : public wl_obj {
 		const wl_uint id;
@@ -115,19 +361,61 @@ namespace zwp::linux_dmabuf {
 		static constexpr wl_uint GET_DEFAULT_FEEDBACK_OPCODE = 2;
 		static constexpr wl_uint GET_SURFACE_FEEDBACK_OPCODE = 3;
 
+		static constexpr wl_uint EV_FORMAT_OPCODE = 0;
+		static constexpr wl_uint EV_MODIFIER_OPCODE = 1;
+
 		public:
 
+		/** First version with `params.create_immed`. */
+		static constexpr wl_uint CREATE_IMMED_VERSION = 2;
+		/** First version with `modifier` events. */
+		static constexpr wl_uint MODIFIER_VERSION = 3;
+		/** First version with feedback objects. */
+		static constexpr wl_uint FEEDBACK_VERSION = 4;
+
+		/**
+			Supported formats, sent right after binding and
+			only before version 4; later versions use
+			feedback objects instead. Version 3 follows each
+			format with its modifiers.
+		*/
+		struct listener {
+			void (*format)(dmabuf& dmabuf, wl_uint format);
+			void (*modifier)(dmabuf& dmabuf, wl_uint format, uint64_t modifier);
+		};
+
+		listener* listener = nullptr;
+
 		dmabuf(const wl_uint id) : id(id) {}
 
 		void handle_event(uint16_t opcode, wl_message::reader reader) override {
-			std::cout << "dmabuf ev\n";
+			if (opcode == EV_FORMAT_OPCODE) {
+				const wl_uint format = reader.read_uint();
+
+				if (listener) {
+					listener->format(*this, format);
+				}
+			} else if (opcode == EV_MODIFIER_OPCODE) {
+				const wl_uint format = reader.read_uint();
+				const uint64_t modifier_hi = reader.read_uint();
+				const uint64_t modifier_lo = reader.read_uint();
+
+				if (listener) {
+					listener->modifier(*this, format, (modifier_hi << 32) | modifier_lo);
+				}
+			} else {
+				lumber::warn("[Wayland::WARN]: Unimplemented event opcode for zwp::linux_dmabuf::dmabuf.");
+			}
 		}
 
 		wl_object ID() const noexcept override {
 			return id;
 		}
 
-		void destroy();
+		void destroy() {
+			wl_message client_msg(id, DESTROY_OPCODE, 0);
+			wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+		}
 
 		params& create_params() {
 			params* params = new class params(wl_id_assigner.request_id());
@@ -142,9 +430,22 @@ namespace zwp::linux_dmabuf {
 			return *params;
 		}
 
-		feedback& get_default_feedback();
+		/**
+			@brief Feedback on the formats that work best when
+			the surface a buffer goes to isn't known.
+		*/
+		feedback& get_default_feedback() {
+			feedback* feedback = new class feedback(wl_id_assigner.request_id());
+
+			wl_message client_msg(id, GET_DEFAULT_FEEDBACK_OPCODE, 1);
+			wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+			writer.write(feedback->ID());
 
-		
+			wl_id_map.create(*feedback);
+
+			return *feedback;
+		}
 
 		feedback& get_surface_feedback(wl_surface& surface) {
 			feedback* feedback = new class feedback(wl_id_assigner.request_id());
@@ -22,21 +22,59 @@ namespace wl {
 
 		public:
 
+		/** Bit set in `mode::flags` for the output's current mode. */
+		static constexpr wl_uint MODE_CURRENT = 0x1;
+		static constexpr wl_uint MODE_PREFERRED = 0x2;
+
+		struct mode {
+			wl_uint flags = 0;
+			wl_int width = 0;
+			wl_int height = 0;
+			/** Vertical refresh rate in mHz, 0 if it doesn't make sense (e.g. virtual outputs). */
+			wl_int refresh = 0;
+		};
+
+		struct listener {
+			/** Called when the current mode changes. */
+			void (*mode)(output& output, const mode& mode);
+		};
+
+		listener* listener = nullptr;
+
+		private:
+
+		mode current;
+
+		public:
+
 		output(const wl_object id) : id(id) {}
 
+		/**
+			@brief The last mode advertised with the
+			`current` flag.
+		*/
+		const mode& current_mode() const noexcept {
+			return current;
+		}
+
 		void handle_event(uint16_t opcode, wl_message::reader reader) override {
 			if (opcode == EV_GEOMETRY_OPCODE) {
 				//std::cout << "Geometry\n";
 			} else if (opcode == EV_MODE_OPCODE) {
-				const wl_uint flags = reader.read_uint();
-				const wl_int width = reader.read_int();
-				const wl_int height = reader.read_int();
-				const wl_int refresh_rate = reader.read_int();
-				/*std::cout << "wl::output mode:\n";
-				std::cout << "\tflags: " << flags << '\n';
-				std::cout << "\twidth: " << width << '\n';
-				std::cout << "\theight: " << height << '\n';
-				std::cout << "\trefresh rate: " << refresh_rate << '\n';*/
+				struct mode mode;
+				mode.flags = reader.read_uint();
+				mode.width = reader.read_int();
+				mode.height = reader.read_int();
+				mode.refresh = reader.read_int();
+
+				// Non-current modes are deprecated and only describe alternatives.
+				if (mode.flags & MODE_CURRENT) {
+					current = mode;
+
+					if (listener) {
+						listener->mode(*this, current);
+					}
+				}
 
 			} else if (opcode == EV_DONE_OPCODE) {
 				//lumber::info("[Wayland::INFO]: wl::output done.");
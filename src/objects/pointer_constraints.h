@@ -0,0 +1,254 @@
+#pragma once
+
+#include "../wl_utils/wl_types.h"
+#include "../wl_utils/wl_state.h"
+#include "../buffers/input_ring.h"
+
+#include "input.h"
+#include "region.h"
+#include "surface.h"
+
+/**
+    @brief Pointer constraints: locking the pointer in place
+    or confining it to a region of a surface. Motion while
+    locked only arrives as relative_pointer events.
+*/
+namespace zwp {
+
+    /**
+        @brief A pointer locked in place on a surface.
+    */
+    class locked_pointer : public wl_obj {
+        const wl_object id;
+
+        static constexpr wl_uint DESTROY_OPCODE = 0;
+        static constexpr wl_uint SET_CURSOR_POSITION_HINT_OPCODE = 1;
+        static constexpr wl_uint SET_REGION_OPCODE = 2;
+
+        static constexpr wl_uint EV_LOCKED_OPCODE = 0;
+        static constexpr wl_uint EV_UNLOCKED_OPCODE = 1;
+
+        static wl_uint to_fixed(const wl_fixed value) noexcept {
+            return static_cast<wl_uint>(static_cast<wl_int>(value * 256.0f));
+        }
+
+        public:
+
+        struct listener {
+            void (*locked)(locked_pointer& pointer);
+            void (*unlocked)(locked_pointer& pointer);
+        };
+
+        listener* listener = nullptr;
+
+        /** Gets the lock and unlock events, in order with the motion they bracket. */
+        wl::input_ring* ring = nullptr;
+
+        bool is_locked = false;
+
+        locked_pointer(const wl_new_id id) : id(id) {}
+
+        wl_object ID() const noexcept override {
+            return id;
+        }
+
+        void destroy() {
+            wl_message client_msg(id, DESTROY_OPCODE, 0);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+        }
+
+        /**
+            @brief Where the cursor should appear when the
+            lock ends, in surface coordinates. Applied on
+            the next surface commit.
+        */
+        void set_cursor_position_hint(const wl_fixed x, const wl_fixed y) {
+            wl_message client_msg(id, SET_CURSOR_POSITION_HINT_OPCODE, 2);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(to_fixed(x));
+            writer.write(to_fixed(y));
+        }
+
+        /** @brief Limits where the lock can start; `nullptr` allows the whole surface. */
+        void set_region(const wl_region* region) {
+            wl_message client_msg(id, SET_REGION_OPCODE, 1);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(region ? region->ID() : NULL_OBJ_ID);
+        }
+
+        void handle_event(uint16_t opcode, wl_message::reader reader) override {
+            if (opcode == EV_LOCKED_OPCODE) {
+                is_locked = true;
+
+                if (ring) {
+                    ring->push_now(wl::input_event_type::pointer_locked);
+                }
+
+                if (listener) {
+                    listener->locked(*this);
+                }
+            } else if (opcode == EV_UNLOCKED_OPCODE) {
+                is_locked = false;
+
+                if (ring) {
+                    ring->push_now(wl::input_event_type::pointer_unlocked);
+                }
+
+                if (listener) {
+                    listener->unlocked(*this);
+                }
+            } else {
+                lumber::warn("[Wayland::WARN]: Unimplemented event opcode for zwp::locked_pointer.");
+            }
+        }
+    };
+
+    /**
+        @brief A pointer confined to a region of a surface.
+    */
+    class confined_pointer : public wl_obj {
+        const wl_object id;
+
+        static constexpr wl_uint DESTROY_OPCODE = 0;
+        static constexpr wl_uint SET_REGION_OPCODE = 1;
+
+        static constexpr wl_uint EV_CONFINED_OPCODE = 0;
+        static constexpr wl_uint EV_UNCONFINED_OPCODE = 1;
+
+        public:
+
+        struct listener {
+            void (*confined)(confined_pointer& pointer);
+            void (*unconfined)(confined_pointer& pointer);
+        };
+
+        listener* listener = nullptr;
+
+        wl::input_ring* ring = nullptr;
+
+        bool is_confined = false;
+
+        confined_pointer(const wl_new_id id) : id(id) {}
+
+        wl_object ID() const noexcept override {
+            return id;
+        }
+
+        void destroy() {
+            wl_message client_msg(id, DESTROY_OPCODE, 0);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+        }
+
+        /** @brief Region to confine to; `nullptr` confines to the whole surface. */
+        void set_region(const wl_region* region) {
+            wl_message client_msg(id, SET_REGION_OPCODE, 1);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(region ? region->ID() : NULL_OBJ_ID);
+        }
+
+        void handle_event(uint16_t opcode, wl_message::reader reader) override {
+            if (opcode == EV_CONFINED_OPCODE) {
+                is_confined = true;
+
+                if (ring) {
+                    ring->push_now(wl::input_event_type::pointer_confined);
+                }
+
+                if (listener) {
+                    listener->confined(*this);
+                }
+            } else if (opcode == EV_UNCONFINED_OPCODE) {
+                is_confined = false;
+
+                if (ring) {
+                    ring->push_now(wl::input_event_type::pointer_unconfined);
+                }
+
+                if (listener) {
+                    listener->unconfined(*this);
+                }
+            } else {
+                lumber::warn("[Wayland::WARN]: Unimplemented event opcode for zwp::confined_pointer.");
+            }
+        }
+    };
+
+    /**
+        @brief Global for locking and confining pointers.
+    */
+    class pointer_constraints : public wl_obj {
+        const wl_object id;
+
+        static constexpr wl_uint DESTROY_OPCODE = 0;
+        static constexpr wl_uint LOCK_POINTER_OPCODE = 1;
+        static constexpr wl_uint CONFINE_POINTER_OPCODE = 2;
+
+        public:
+
+        enum class lifetime : wl_uint {
+            /** The constraint is destroyed once it ends, e.g. on focus loss. */
+            oneshot = 1,
+            /** The constraint comes back whenever the surface regains focus. */
+            persistent = 2,
+        };
+
+        pointer_constraints(const wl_new_id id) : id(id) {}
+
+        wl_object ID() const noexcept override {
+            return id;
+        }
+
+        /**
+            @brief Locks @p pointer in place while it is over
+            @p region of @p surface (`nullptr` for all of it).
+            Only takes effect once `locked` is sent.
+        */
+        locked_pointer& lock_pointer(const wl_surface& surface, const wl_pointer& pointer, const wl_region* region, const lifetime lifetime) {
+            locked_pointer* locked = new locked_pointer(wl_id_assigner.request_id());
+            wl_id_map.create(*locked);
+
+            wl_message client_msg(id, LOCK_POINTER_OPCODE, 5);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(locked->ID());
+            writer.write(surface.ID());
+            writer.write(pointer.ID());
+            writer.write(region ? region->ID() : NULL_OBJ_ID);
+            writer.write(static_cast<wl_uint>(lifetime));
+
+            return *locked;
+        }
+
+        /**
+            @brief Keeps @p pointer within @p region of
+            @p surface (`nullptr` for all of it).
+        */
+        confined_pointer& confine_pointer(const wl_surface& surface, const wl_pointer& pointer, const wl_region* region, const lifetime lifetime) {
+            confined_pointer* confined = new confined_pointer(wl_id_assigner.request_id());
+            wl_id_map.create(*confined);
+
+            wl_message client_msg(id, CONFINE_POINTER_OPCODE, 5);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(confined->ID());
+            writer.write(surface.ID());
+            writer.write(pointer.ID());
+            writer.write(region ? region->ID() : NULL_OBJ_ID);
+            writer.write(static_cast<wl_uint>(lifetime));
+
+            return *confined;
+        }
+
+        void destroy() {
+            wl_message client_msg(id, DESTROY_OPCODE, 0);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+        }
+
+        void handle_event(uint16_t opcode, wl_message::reader reader) override {
+            lumber::warn("[Wayland::WARN]: zwp::pointer_constraints has no events.");
+        }
+    };
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "../wl_utils/wl_types.h"
+#include "../wl_utils/wl_state.h"
+
+#include "surface.h"
+
+#include <cstdint>
+
+/**
+    @brief Presentation time: accurate feedback on when
+    surface content reached the screen.
+*/
+namespace wp {
+
+    /**
+        @brief Presentation feedback for a single commit.
+
+        Fires either `presented` or `discarded` once, after
+        which the compositor destroys the object. The creator
+        owns the client-side object and deletes it once the
+        event has been handled.
+    */
+    class presentation_feedback : public wl_obj {
+        const wl_object id;
+
+        static constexpr wl_uint EV_SYNC_OUTPUT_OPCODE = 0;
+        static constexpr wl_uint EV_PRESENTED_OPCODE = 1;
+        static constexpr wl_uint EV_DISCARDED_OPCODE = 2;
+
+        public:
+
+        /** Presentation was synchronized to the vertical retrace. */
+        static constexpr wl_uint KIND_VSYNC = 0x1;
+        /** The timestamp comes from a hardware clock. */
+        static constexpr wl_uint KIND_HW_CLOCK = 0x2;
+        /** Hardware signalled that the display update started. */
+        static constexpr wl_uint KIND_HW_COMPLETION = 0x4;
+        /** The buffer was scanned out directly, without a copy. */
+        static constexpr wl_uint KIND_ZERO_COPY = 0x8;
+
+        struct presented_info {
+            /** Presentation time in nanoseconds, on the clock from wp::presentation::clock_id(). */
+            int64_t time = 0;
+            /** Nanoseconds until the next expected refresh, 0 if unknown. */
+            wl_uint refresh = 0;
+            /** Vertical retrace counter, 0 if unknown. */
+            uint64_t sequence = 0;
+            /** `KIND_*` bits. */
+            wl_uint flags = 0;
+            /** Output the content was synchronized to, NULL_OBJ_ID if none was reported. */
+            wl_object output = NULL_OBJ_ID;
+        };
+
+        struct listener {
+            void (*presented)(presentation_feedback& feedback, const presented_info& info);
+            /** The content was never shown, e.g. it was superseded by a later commit. */
+            void (*discarded)(presentation_feedback& feedback);
+        };
+
+        listener* listener = nullptr;
+
+        /** Free slot for the listener to find its owner. */
+        void* user_data = nullptr;
+
+        presentation_feedback(const wl_new_id id) : id(id) {}
+
+        wl_object ID() const noexcept override {
+            return id;
+        }
+
+        void handle_event(uint16_t opcode, wl_message::reader reader) override {
+            if (opcode == EV_SYNC_OUTPUT_OPCODE) {
+                output = reader.read_object();
+            } else if (opcode == EV_PRESENTED_OPCODE) {
+                const uint64_t tv_sec_hi = reader.read_uint();
+                const uint64_t tv_sec_lo = reader.read_uint();
+                const wl_uint tv_nsec = reader.read_uint();
+
+                presented_info info;
+                info.time = static_cast<int64_t>((tv_sec_hi << 32) | tv_sec_lo) * 1'000'000'000 + tv_nsec;
+                info.refresh = reader.read_uint();
+
+                const uint64_t seq_hi = reader.read_uint();
+                const uint64_t seq_lo = reader.read_uint();
+                info.sequence = (seq_hi << 32) | seq_lo;
+                info.flags = reader.read_uint();
+                info.output = output;
+
+                if (listener) {
+                    listener->presented(*this, info);
+                }
+            } else if (opcode == EV_DISCARDED_OPCODE) {
+                if (listener) {
+                    listener->discarded(*this);
+                }
+            } else {
+                lumber::warn("[Wayland::WARN]: Unimplemented event opcode for wp::presentation_feedback.");
+            }
+        }
+
+        private:
+
+        wl_object output = NULL_OBJ_ID;
+    };
+
+    /**
+        @brief Global for requesting presentation feedback.
+    */
+    class presentation : public wl_obj {
+        const wl_object id;
+
+        static constexpr wl_uint DESTROY_OPCODE = 0;
+        static constexpr wl_uint FEEDBACK_OPCODE = 1;
+
+        static constexpr wl_uint EV_CLOCK_ID_OPCODE = 0;
+
+        /** CLOCK_MONOTONIC until the compositor says otherwise. */
+        wl_uint clock = 1;
+
+        public:
+
+        presentation(const wl_new_id id) : id(id) {}
+
+        wl_object ID() const noexcept override {
+            return id;
+        }
+
+        /**
+            @brief The clock presentation timestamps are on,
+            as a `clockid_t`.
+        */
+        wl_uint clock_id() const noexcept {
+            return clock;
+        }
+
+        /**
+            @brief Requests presentation feedback for the
+            content of the next commit of @p surface.
+
+            The returned object is owned by the caller.
+        */
+        presentation_feedback& feedback(const wl_surface& surface) {
+            presentation_feedback* feedback = new presentation_feedback(wl_id_assigner.request_id());
+
+            wl_message client_msg(id, FEEDBACK_OPCODE, 2);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(surface.ID());
+            writer.write(feedback->ID());
+
+            wl_id_map.create(*feedback);
+
+            return *feedback;
+        }
+
+        void destroy() {
+            wl_message client_msg(id, DESTROY_OPCODE, 0);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+        }
+
+        void handle_event(uint16_t opcode, wl_message::reader reader) override {
+            if (opcode == EV_CLOCK_ID_OPCODE) {
+                clock = reader.read_uint();
+            } else {
+                lumber::warn("[Wayland::WARN]: Unimplemented event opcode for wp::presentation.");
+            }
+        }
+    };
+}
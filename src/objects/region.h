@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../wl_utils/wl_types.h"
+#include "../wl_utils/wl_state.h"
+
+/**
+    @brief A set of rectangles in surface-local
+    coordinates, built up by adding and subtracting.
+
+    Surfaces copy a region when it is set, so it can be
+    destroyed or reused right after.
+*/
+class wl_region final : public wl_obj {
+    const wl_object id;
+
+    static constexpr wl_uint DESTROY_OPCODE = 0;
+    static constexpr wl_uint ADD_OPCODE = 1;
+    static constexpr wl_uint SUBTRACT_OPCODE = 2;
+
+    public:
+
+    wl_region(const wl_new_id id) : id(id) {}
+
+    wl_object ID() const noexcept override {
+        return id;
+    }
+
+    void add(wl_int x, wl_int y, wl_int width, wl_int height) {
+        wl_message client_msg(id, ADD_OPCODE, 4);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+        writer.write(x);
+        writer.write(y);
+        writer.write(width);
+        writer.write(height);
+    }
+
+    void subtract(wl_int x, wl_int y, wl_int width, wl_int height) {
+        wl_message client_msg(id, SUBTRACT_OPCODE, 4);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+        writer.write(x);
+        writer.write(y);
+        writer.write(width);
+        writer.write(height);
+    }
+
+    void destroy() {
+        wl_message client_msg(id, DESTROY_OPCODE, 0);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+    }
+
+    void handle_event(uint16_t opcode, wl_message::reader reader) override {
+        lumber::warn("[Wayland::WARN]: wl_region has no events.");
+    }
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "../wl_utils/wl_types.h"
+#include "../wl_utils/wl_state.h"
+#include "../buffers/input_ring.h"
+
+#include "input.h"
+
+/**
+    @brief Relative pointer: unclipped, unaccelerated
+    pointer motion, e.g. for games and 3D viewers with a
+    locked pointer.
+*/
+namespace zwp {
+
+    /**
+        @brief Relative motion of one wl_pointer.
+    */
+    class relative_pointer : public wl_obj {
+        const wl_object id;
+
+        static constexpr wl_uint DESTROY_OPCODE = 0;
+
+        static constexpr wl_uint EV_RELATIVE_MOTION_OPCODE = 0;
+
+        public:
+
+        struct listener {
+            /**
+                @p time is in microseconds. The accelerated
+                delta is what the pointer would have moved;
+                the unaccelerated one is straight from the
+                device.
+            */
+            void (*relative_motion)(relative_pointer& pointer, uint64_t time, wl_fixed dx, wl_fixed dy, wl_fixed dx_unaccel, wl_fixed dy_unaccel);
+        };
+
+        listener* listener = nullptr;
+
+        /** Gets the unaccelerated motion, for a consumer on another thread. */
+        wl::input_ring* ring = nullptr;
+
+        relative_pointer(const wl_new_id id) : id(id) {}
+
+        wl_object ID() const noexcept override {
+            return id;
+        }
+
+        void destroy() {
+            wl_message client_msg(id, DESTROY_OPCODE, 0);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+        }
+
+        void handle_event(uint16_t opcode, wl_message::reader reader) override {
+            if (opcode == EV_RELATIVE_MOTION_OPCODE) {
+                const uint64_t time_hi = reader.read_uint();
+                const uint64_t time_lo = reader.read_uint();
+                const uint64_t time = time_hi << 32 | time_lo;
+                const wl_fixed dx = reader.read_fixed();
+                const wl_fixed dy = reader.read_fixed();
+                const wl_fixed dx_unaccel = reader.read_fixed();
+                const wl_fixed dy_unaccel = reader.read_fixed();
+
+                if (ring) {
+                    ring->push({
+                        .time_ns = wl::input_clock::from_us(time),
+                        .type = wl::input_event_type::relative_motion,
+                        .x = dx_unaccel,
+                        .y = dy_unaccel,
+                    });
+                }
+
+                if (listener) {
+                    listener->relative_motion(*this, time, dx, dy, dx_unaccel, dy_unaccel);
+                }
+            } else {
+                lumber::warn("[Wayland::WARN]: Unimplemented event opcode for zwp::relative_pointer.");
+            }
+        }
+    };
+
+    /**
+        @brief Global for creating relative_pointer objects.
+    */
+    class relative_pointer_manager : public wl_obj {
+        const wl_object id;
+
+        static constexpr wl_uint DESTROY_OPCODE = 0;
+        static constexpr wl_uint GET_RELATIVE_POINTER_OPCODE = 1;
+
+        public:
+
+        relative_pointer_manager(const wl_new_id id) : id(id) {}
+
+        wl_object ID() const noexcept override {
+            return id;
+        }
+
+        relative_pointer& get_relative_pointer(const wl_pointer& pointer) {
+            relative_pointer* relative = new relative_pointer(wl_id_assigner.request_id());
+            wl_id_map.create(*relative);
+
+            wl_message client_msg(id, GET_RELATIVE_POINTER_OPCODE, 2);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(relative->ID());
+            writer.write(pointer.ID());
+
+            return *relative;
+        }
+
+        void destroy() {
+            wl_message client_msg(id, DESTROY_OPCODE, 0);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+        }
+
+        void handle_event(uint16_t opcode, wl_message::reader reader) override {
+            lumber::warn("[Wayland::WARN]: zwp::relative_pointer_manager has no events.");
+        }
+    };
+}
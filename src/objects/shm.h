@@ -6,6 +6,9 @@
 
 #include "buffer.h"
 
+#include <algorithm>
+#include <vector>
+
 class wl_shm_pool {
 
     wl_object id;
@@ -82,6 +85,21 @@ class wl_shm : public wl_obj {
 
     listener* listener = nullptr;
 
+    /**
+        @brief Formats advertised by the compositor, in the
+        order they were sent.
+    */
+    const std::vector<Format>& formats() const noexcept {
+        return advertised;
+    }
+
+    /** ARGB8888 and XRGB8888 are always supported, even before they're advertised. */
+    bool supports(const Format format) const {
+        if (format == Format::ARGB8888 || format == Format::XRGB8888) { return true; }
+
+        return std::find(advertised.begin(), advertised.end(), format) != advertised.end();
+    }
+
     wl_shm(const wl_new_id id) : id(id) {
 
     }
@@ -105,12 +123,20 @@ class wl_shm : public wl_obj {
     }
 
     void handle_event(uint16_t opcode, wl_message::reader reader) override {
-        if (!listener) {
-            throw std::runtime_error("No listener supplied for wl_shm.");
-        }
-
         if (opcode == 0) {
-            listener->format(reader.read_uint());
+            const wl_uint format = reader.read_uint();
+
+            if (std::find(advertised.begin(), advertised.end(), static_cast<Format>(format)) == advertised.end()) {
+                advertised.push_back(static_cast<Format>(format));
+            }
+
+            if (listener) {
+                listener->format(format);
+            }
         }
     }
+
+    private:
+
+    std::vector<Format> advertised;
 };
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../wl_utils/wl_types.h"
+#include "../wl_utils/wl_state.h"
+
+#include "buffer.h"
+
+#include <cstdint>
+
+/**
+    @brief Single-pixel buffers: 1x1 buffers of one colour,
+    without any shared memory behind them.
+*/
+namespace wp {
+
+    /**
+        @brief Global for creating single-pixel buffers.
+
+        Combined with a viewport, a single-pixel buffer
+        covers a surface of any size for the cost of one
+        protocol message.
+    */
+    class single_pixel_buffer_manager : public wl_obj {
+        const wl_object id;
+
+        static constexpr wl_uint DESTROY_OPCODE = 0;
+        static constexpr wl_uint CREATE_U32_RGBA_BUFFER_OPCODE = 1;
+
+        public:
+
+        single_pixel_buffer_manager(const wl_new_id id) : id(id) {}
+
+        wl_object ID() const noexcept override {
+            return id;
+        }
+
+        /**
+            @brief Creates a 1x1 buffer of one premultiplied
+            colour. Each channel spans the full 32-bit range,
+            so `0xFFFFFFFF` is full intensity.
+        */
+        wl_buffer& create_u32_rgba_buffer(wl_uint r, wl_uint g, wl_uint b, wl_uint a) {
+            wl_buffer* buffer = new wl_buffer(wl_id_assigner.request_id());
+            wl_id_map.create(*buffer);
+
+            wl_message client_msg(id, CREATE_U32_RGBA_BUFFER_OPCODE, 5);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(buffer->ID());
+            writer.write(r);
+            writer.write(g);
+            writer.write(b);
+            writer.write(a);
+
+            return *buffer;
+        }
+
+        /**
+            @brief Creates a 1x1 buffer from a premultiplied
+            ARGB8888 colour.
+        */
+        wl_buffer& create_buffer(uint32_t argb) {
+            // 0xFF * 0x01010101 = 0xFFFFFFFF, so every 8-bit value maps exactly.
+            const auto widen = [](const uint32_t channel) -> wl_uint {
+                return (channel & 0xFF) * 0x01010101u;
+            };
+
+            return create_u32_rgba_buffer(widen(argb >> 16), widen(argb >> 8), widen(argb), widen(argb >> 24));
+        }
+
+        void destroy() {
+            wl_message client_msg(id, DESTROY_OPCODE, 0);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+        }
+
+        void handle_event(uint16_t opcode, wl_message::reader reader) override {
+            lumber::warn("[Wayland::WARN]: wp::single_pixel_buffer_manager has no events.");
+        }
+    };
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "../wl_utils/wl_types.h"
+#include "../wl_utils/wl_state.h"
+
+#include "surface.h"
+
+/**
+    @brief Role that places a wl_surface inside a parent
+    surface, as a layer with its own buffer.
+
+    Position and stacking are parent state, applied on the
+    parent's next commit. In sync mode (the default) the
+    surface's own commits are also held until the parent
+    commits; in desync mode they apply right away.
+*/
+class wl_subsurface : public wl_obj {
+    const wl_object id;
+
+    static constexpr wl_uint DESTROY_OPCODE = 0;
+    static constexpr wl_uint SET_POSITION_OPCODE = 1;
+    static constexpr wl_uint PLACE_ABOVE_OPCODE = 2;
+    static constexpr wl_uint PLACE_BELOW_OPCODE = 3;
+    static constexpr wl_uint SET_SYNC_OPCODE = 4;
+    static constexpr wl_uint SET_DESYNC_OPCODE = 5;
+
+    public:
+
+    wl_subsurface(const wl_new_id id) : id(id) {}
+
+    wl_object ID() const noexcept override {
+        return id;
+    }
+
+    /**
+        @brief Moves the top-left corner to (@p x, @p y) in
+        the parent's surface coordinates.
+    */
+    void set_position(wl_int x, wl_int y) {
+        wl_message client_msg(id, SET_POSITION_OPCODE, 2);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+        writer.write(x);
+        writer.write(y);
+    }
+
+    /**
+        @brief Stacks the surface right above @p sibling,
+        which is the parent or another of its subsurfaces.
+    */
+    void place_above(const wl_surface& sibling) {
+        wl_message client_msg(id, PLACE_ABOVE_OPCODE, 1);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+        writer.write(sibling.ID());
+    }
+
+    /**
+        @brief Stacks the surface right below @p sibling,
+        which is the parent or another of its subsurfaces.
+    */
+    void place_below(const wl_surface& sibling) {
+        wl_message client_msg(id, PLACE_BELOW_OPCODE, 1);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+        writer.write(sibling.ID());
+    }
+
+    void set_sync() {
+        wl_message client_msg(id, SET_SYNC_OPCODE, 0);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+    }
+
+    void set_desync() {
+        wl_message client_msg(id, SET_DESYNC_OPCODE, 0);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+    }
+
+    void destroy() {
+        wl_message client_msg(id, DESTROY_OPCODE, 0);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+    }
+
+    void handle_event(uint16_t opcode, wl_message::reader reader) override {
+        lumber::warn("[Wayland::WARN]: wl_subsurface has no events.");
+    }
+};
+
+/**
+    @brief Global for giving surfaces the subsurface role.
+*/
+class wl_subcompositor : public wl_obj {
+    const wl_object id;
+
+    static constexpr wl_uint DESTROY_OPCODE = 0;
+    static constexpr wl_uint GET_SUBSURFACE_OPCODE = 1;
+
+    public:
+
+    wl_subcompositor(const wl_new_id id) : id(id) {}
+
+    wl_object ID() const noexcept override {
+        return id;
+    }
+
+    /**
+        @brief Makes @p surface a subsurface of @p parent.
+        It starts out in sync mode, stacked right above the
+        parent.
+    */
+    wl_subsurface& get_subsurface(const wl_surface& surface, const wl_surface& parent) {
+        wl_subsurface* subsurface = new wl_subsurface(wl_id_assigner.request_id());
+        wl_id_map.create(*subsurface);
+
+        wl_message client_msg(id, GET_SUBSURFACE_OPCODE, 3);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+        writer.write(subsurface->ID());
+        writer.write(surface.ID());
+        writer.write(parent.ID());
+
+        return *subsurface;
+    }
+
+    void destroy() {
+        wl_message client_msg(id, DESTROY_OPCODE, 0);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+    }
+
+    void handle_event(uint16_t opcode, wl_message::reader reader) override {
+        lumber::warn("[Wayland::WARN]: wl_subcompositor has no events.");
+    }
+};
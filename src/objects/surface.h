@@ -4,7 +4,30 @@
 #include "../wl_utils/wl_state.h"
 
 #include "buffer.h"
+#include "callback.h"
+#include "region.h"
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+/**
+    @brief A rectangle on the screen that displays content.
+
+    Buffer, offset, damage, scale and transform are
+    double-buffered on the client too: the requests only
+    record pending state, and `commit` sends what differs
+    from the last commit, then the commit itself. A commit
+    that would change nothing is dropped, since each one
+    costs the compositor a full state transaction.
+
+    Requests that create or reference other objects (frame
+    callbacks, regions) are sent right away and make the next
+    commit non-empty. State that lives on other objects
+    (viewports, subsurface positions, presentation feedback,
+    tearing and content type hints) must be flagged with
+    `mark_dirty`.
+*/
 struct wl_surface : public wl_obj {
     const wl_object id;
 
@@ -27,36 +50,398 @@ struct wl_surface : public wl_obj {
 
     public:
 
+    /** First versions with `set_buffer_transform`, `set_buffer_scale` and `damage_buffer`. */
+    static constexpr wl_uint BUFFER_TRANSFORM_VERSION = 2;
+    static constexpr wl_uint BUFFER_SCALE_VERSION = 3;
+    static constexpr wl_uint DAMAGE_BUFFER_VERSION = 4;
+
+    /** First version with `offset`; from then on, attach offsets must be 0. */
+    static constexpr wl_uint OFFSET_VERSION = 5;
+
+    /** Version of wl_compositor the surface was created from. */
+    const wl_uint version;
+
+    /**
+        @brief Rotation and flip of buffer contents, as in
+        wl_output.transform.
+    */
+    enum class transform : wl_uint {
+        normal = 0,
+        rotate_90 = 1,
+        rotate_180 = 2,
+        rotate_270 = 3,
+        flipped = 4,
+        flipped_90 = 5,
+        flipped_180 = 6,
+        flipped_270 = 7,
+    };
+
     struct listener {
-        void (*enter)();
-        void (*leave)();
-        void (*preferred_buffer_scale)();
-        void (*preferred_buffer_transform)();
+        /** The surface entered an output. */
+        void (*enter)(wl_surface& surface, wl_object output);
+        /** The surface left an output. */
+        void (*leave)(wl_surface& surface, wl_object output);
+        /** Integer scale the compositor would like buffers at. */
+        void (*preferred_buffer_scale)(wl_surface& surface, wl_int factor);
+        /** Transform that would let the compositor skip rotating buffers. */
+        void (*preferred_buffer_transform)(wl_surface& surface, transform transform);
     };
 
-    wl_surface(const wl_new_id id) : id(id) {
+    listener* listener = nullptr;
+
+    wl_surface(const wl_new_id id, const wl_uint version = 1) : id(id), version(version) {
 
     }
 
+    /**
+        @brief Shows @p buffer, offset by (@p x, @p y), from
+        the next commit. The offset replaces any pending
+        one; it moves the content relative to where it was
+        last shown.
+
+        From version 5 the offset is sent with a separate
+        `offset` request, since attach has to carry 0.
+
+        Re-attaching the buffer that is already shown is
+        dropped unless it comes with damage or an offset.
+        The buffer is marked busy once the attach is sent.
+    */
     void attach(wl_fd_t socket, wl_buffer& buffer, wl_int x, wl_int y) {
-        wl_message client_msg(id, ATTACH_OPCODE, 3);
+        pending.buffer = buffer.ID();
+        pending_buffer = &buffer;
+        pending_x = x;
+        pending_y = y;
+        attach_pending = true;
+    }
+
+    /**
+        @brief Removes the surface's content on the next
+        commit, hiding it.
+    */
+    void detach(wl_fd_t socket) {
+        pending.buffer = NULL_OBJ_ID;
+        pending_buffer = nullptr;
+        pending_x = 0;
+        pending_y = 0;
+        attach_pending = true;
+    }
+
+    /**
+        @brief Marks a rectangle, in surface coordinates, as
+        changed since the last commit.
+    */
+    void damage(wl_int x, wl_int y, wl_int width, wl_int height) {
+        add_damage({ x, y, width, height, false });
+    }
+
+    /**
+        @brief Marks a rectangle, in buffer coordinates, as
+        changed since the last commit. Only damaged parts are
+        re-uploaded and recomposited.
+
+        Before version 4 the whole surface is damaged
+        instead, since mapping to surface coordinates would
+        need the scale, transform and viewport.
+    */
+    void damage_buffer(wl_int x, wl_int y, wl_int width, wl_int height) {
+        if (version < DAMAGE_BUFFER_VERSION) {
+            if (width > 0 && height > 0) {
+                damage(0, 0, std::numeric_limits<wl_int>::max(), std::numeric_limits<wl_int>::max());
+            }
+
+            return;
+        }
+
+        add_damage({ x, y, width, height, true });
+    }
+
+    /**
+        @brief Requests a notification for when it is a good
+        time to draw a new frame.
+
+        Takes effect on the next commit. The returned
+        callback is owned by the caller and fires `done`
+        once, with the current time in milliseconds.
+    */
+    wl_callback& frame() {
+        wl_callback* callback = new wl_callback(wl_id_assigner.request_id());
+
+        wl_message client_msg(id, FRAME_OPCODE, 1);
         wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
 
-        writer.write(buffer.ID());
-        writer.write(x);
-        writer.write(y);
+        writer.write(callback->ID());
+
+        wl_id_map.create(*callback);
+
+        dirty = true;
+
+        return *callback;
+    }
+
+    /**
+        @brief Marks the parts of the surface whose content
+        is fully opaque, so the compositor can skip drawing
+        and blending what is underneath. `nullptr` clears
+        it. Takes effect on the next commit.
+    */
+    void set_opaque_region(const wl_region* region) {
+        wl_message client_msg(id, SET_OPAQUE_REGION_OPCODE, 1);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+        // Sent now: the caller may destroy the region right after.
+        writer.write(region != nullptr ? region->ID() : wl_object(NULL_OBJ_ID));
+
+        dirty = true;
+    }
+
+    /**
+        @brief Limits where the surface accepts pointer and
+        touch input. `nullptr` makes the whole surface accept
+        input again. Takes effect on the next commit.
+    */
+    void set_input_region(const wl_region* region) {
+        wl_message client_msg(id, SET_INPUT_REGION_OPCODE, 1);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+        writer.write(region != nullptr ? region->ID() : wl_object(NULL_OBJ_ID));
+
+        dirty = true;
+    }
+
+    /**
+        @brief Flags state kept on another object, but
+        applied by this surface's commit, as changed.
+    */
+    void mark_dirty() noexcept {
+        dirty = true;
     }
 
-    void commit(wl_fd_t socket) {
+    /**
+        @brief Sends the pending state that differs from the
+        current state, then commits it.
+
+        Damage is sent with or without a new buffer, except
+        that held-back buffers (see `await_configure`) stay
+        pending along with their damage.
+
+        @returns `false` if nothing changed, in which case
+        no commit is sent.
+    */
+    bool commit(wl_fd_t socket) {
+        const bool send_buffer = attach_pending && configured;
+        const bool buffer_changed = send_buffer && (pending.buffer != current.buffer || pending_x != 0 || pending_y != 0 || !damage_pending.empty());
+        const bool send_damage_rects = !damage_pending.empty() && (send_buffer || !attach_pending);
+
+        if (!dirty && !buffer_changed && !send_damage_rects && pending.scale == current.scale && pending.buffer_transform == current.buffer_transform) {
+            return false;
+        }
+
+        if (buffer_changed) {
+            send_attach();
+
+            if (pending_buffer) {
+                pending_buffer->is_busy = true;
+            }
+        }
+
+        if (send_damage_rects) {
+            for (const damage_rect& rect : damage_pending) {
+                send_damage(rect);
+            }
+
+            damage_pending.clear();
+        }
+
+        if (send_buffer) {
+            current.buffer = pending.buffer;
+            attach_pending = false;
+            pending_x = 0;
+            pending_y = 0;
+        }
+
+        if (pending.scale != current.scale) {
+            wl_message client_msg(id, SET_BUFFER_SCALE_OPCODE, 1);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(pending.scale);
+            current.scale = pending.scale;
+        }
+
+        if (pending.buffer_transform != current.buffer_transform) {
+            wl_message client_msg(id, SET_BUFFER_TRANSFORM_OPCODE, 1);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(static_cast<wl_uint>(pending.buffer_transform));
+            current.buffer_transform = pending.buffer_transform;
+        }
+
         wl_message client_msg(id, COMMIT_OPCODE, 0);
         wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+        dirty = false;
+
+        return true;
+    }
+
+    /**
+        @brief Holds buffers back from commits until
+        `set_configured`.
+
+        xdg-shell forbids attaching a buffer before the first
+        configure is acked, and some compositors (e.g. KDE
+        Plasma) enforce it.
+    */
+    void await_configure() noexcept {
+        configured = false;
+    }
+
+    void set_configured() noexcept {
+        configured = true;
+    }
+
+    /**
+        @brief Declares that buffers are drawn at @p scale
+        times the surface size. Takes effect on the next
+        commit; buffer sizes must be multiples of it.
+        Ignored before version 3, where buffers are always
+        at scale 1.
+    */
+    void set_buffer_scale(wl_int scale) {
+        if (version < BUFFER_SCALE_VERSION) { return; }
+
+        pending.scale = scale;
+    }
+
+    /**
+        @brief Declares that buffer contents are drawn with
+        @p transform applied. Takes effect on the next commit.
+        Ignored before version 2, where buffers are always
+        upright.
+    */
+    void set_buffer_transform(transform transform) {
+        if (version < BUFFER_TRANSFORM_VERSION) { return; }
+
+        pending.buffer_transform = transform;
     }
 
     void handle_event(uint16_t opcode, wl_message::reader reader) override {
+        if (opcode == EV_ENTER_OPCODE) {
+            const wl_object output = reader.read_object();
+
+            if (listener) {
+                listener->enter(*this, output);
+            }
+        } else if (opcode == EV_LEAVE_OPCODE) {
+            const wl_object output = reader.read_object();
 
+            if (listener) {
+                listener->leave(*this, output);
+            }
+        } else if (opcode == EV_PREFERRED_BUFFER_SCALE_OPCODE) {
+            const wl_int factor = reader.read_int();
+
+            if (listener) {
+                listener->preferred_buffer_scale(*this, factor);
+            }
+        } else if (opcode == EV_PREFERRED_BUFFER_TRANSFORM_OPCODE) {
+            const transform transform = static_cast<enum transform>(reader.read_uint());
+
+            if (listener) {
+                listener->preferred_buffer_transform(*this, transform);
+            }
+        } else {
+            lumber::warn("[Wayland::WARN]: Unimplemented event opcode for wl_surface.");
+        }
     }
 
     wl_object ID() const noexcept override {
         return id;
     }
+
+    private:
+
+    /** Damage beyond this many rectangles is merged into their bounds. */
+    static constexpr size_t MAX_DAMAGE_RECTS = 16;
+
+    struct state {
+        wl_object buffer = NULL_OBJ_ID;
+        wl_int scale = 1;
+        transform buffer_transform = transform::normal;
+    };
+
+    struct damage_rect {
+        wl_int x;
+        wl_int y;
+        wl_int width;
+        wl_int height;
+        /** Buffer rather than surface coordinates. */
+        bool buffer;
+    };
+
+    state current;
+    state pending;
+
+    bool attach_pending = false;
+    /** The object behind `pending.buffer`. */
+    wl_buffer* pending_buffer = nullptr;
+    wl_int pending_x = 0;
+    wl_int pending_y = 0;
+    std::vector<damage_rect> damage_pending;
+
+    /** Until the first commit, the compositor's state is unknown. */
+    bool dirty = true;
+    bool configured = true;
+
+    void add_damage(const damage_rect& rect) {
+        if (rect.width <= 0 || rect.height <= 0) { return; }
+
+        if (damage_pending.size() < MAX_DAMAGE_RECTS) {
+            damage_pending.push_back(rect);
+            return;
+        }
+
+        // Too fragmented to be worth sending piecewise; surface damage is kept as is.
+        damage_rect& bounds = damage_pending.back();
+
+        if (!bounds.buffer || !rect.buffer) {
+            damage_pending.push_back(rect);
+            return;
+        }
+
+        const wl_int x1 = std::min(bounds.x, rect.x);
+        const wl_int y1 = std::min(bounds.y, rect.y);
+        const wl_int x2 = std::max(bounds.x + bounds.width, rect.x + rect.width);
+        const wl_int y2 = std::max(bounds.y + bounds.height, rect.y + rect.height);
+
+        bounds = { x1, y1, x2 - x1, y2 - y1, true };
+    }
+
+    void send_attach() {
+        const bool separate_offset = version >= OFFSET_VERSION;
+
+        if (separate_offset && (pending_x != 0 || pending_y != 0)) {
+            wl_message client_msg(id, OFFSET_OPCODE, 2);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(pending_x);
+            writer.write(pending_y);
+        }
+
+        wl_message client_msg(id, ATTACH_OPCODE, 3);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+        writer.write(pending.buffer);
+        writer.write(separate_offset ? 0 : pending_x);
+        writer.write(separate_offset ? 0 : pending_y);
+    }
+
+    void send_damage(const damage_rect& rect) {
+        wl_message client_msg(id, rect.buffer ? DAMAGE_BUFFER_OPCODE : DAMAGE_OPCODE, 4);
+        wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+        writer.write(rect.x);
+        writer.write(rect.y);
+        writer.write(rect.width);
+        writer.write(rect.height);
+    }
 };
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "../wl_utils/wl_types.h"
+#include "../wl_utils/wl_state.h"
+
+#include "surface.h"
+
+/**
+    @brief Tearing control: lets a surface ask for its
+    content to be shown as soon as possible, even if that
+    tears.
+*/
+namespace wp {
+
+    /**
+        @brief Presentation hint of one surface.
+    */
+    class tearing_control : public wl_obj {
+        const wl_object id;
+
+        static constexpr wl_uint SET_PRESENTATION_HINT_OPCODE = 0;
+        static constexpr wl_uint DESTROY_OPCODE = 1;
+
+        public:
+
+        enum class presentation_hint : wl_uint {
+            /** Wait for the vertical retrace; never tear. */
+            vsync = 0,
+            /** Show content right away, tearing if needed. */
+            async = 1,
+        };
+
+        tearing_control(const wl_new_id id) : id(id) {}
+
+        wl_object ID() const noexcept override {
+            return id;
+        }
+
+        /**
+            @brief Sets the hint. Takes effect on the next
+            commit; the compositor may still choose vsync.
+        */
+        void set_presentation_hint(presentation_hint hint) {
+            wl_message client_msg(id, SET_PRESENTATION_HINT_OPCODE, 1);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(static_cast<wl_uint>(hint));
+        }
+
+        void destroy() {
+            wl_message client_msg(id, DESTROY_OPCODE, 0);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+        }
+
+        void handle_event(uint16_t opcode, wl_message::reader reader) override {
+            lumber::warn("[Wayland::WARN]: wp::tearing_control has no events.");
+        }
+    };
+
+    /**
+        @brief Global for creating tearing_control objects.
+    */
+    class tearing_control_manager : public wl_obj {
+        const wl_object id;
+
+        static constexpr wl_uint DESTROY_OPCODE = 0;
+        static constexpr wl_uint GET_TEARING_CONTROL_OPCODE = 1;
+
+        public:
+
+        tearing_control_manager(const wl_new_id id) : id(id) {}
+
+        wl_object ID() const noexcept override {
+            return id;
+        }
+
+        /**
+            @brief Creates the tearing_control object of
+            @p surface. A surface can have at most one.
+        */
+        tearing_control& get_tearing_control(const wl_surface& surface) {
+            tearing_control* control = new tearing_control(wl_id_assigner.request_id());
+            wl_id_map.create(*control);
+
+            wl_message client_msg(id, GET_TEARING_CONTROL_OPCODE, 2);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(control->ID());
+            writer.write(surface.ID());
+
+            return *control;
+        }
+
+        void destroy() {
+            wl_message client_msg(id, DESTROY_OPCODE, 0);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+        }
+
+        void handle_event(uint16_t opcode, wl_message::reader reader) override {
+            lumber::warn("[Wayland::WARN]: wp::tearing_control_manager has no events.");
+        }
+    };
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "../wl_utils/wl_types.h"
+#include "../wl_utils/wl_state.h"
+
+#include "surface.h"
+
+/**
+    @brief Viewporter: cropping and scaling of surface
+    contents by the compositor.
+*/
+namespace wp {
+
+    /**
+        @brief Crop and scale state of one surface.
+
+        Like other surface state, changes take effect on the
+        next wl_surface.commit.
+    */
+    class viewport : public wl_obj {
+        const wl_object id;
+
+        static constexpr wl_uint DESTROY_OPCODE = 0;
+        static constexpr wl_uint SET_SOURCE_OPCODE = 1;
+        static constexpr wl_uint SET_DESTINATION_OPCODE = 2;
+
+        static wl_uint to_fixed(const wl_fixed value) noexcept {
+            return static_cast<wl_uint>(static_cast<wl_int>(value * 256.0f));
+        }
+
+        public:
+
+        viewport(const wl_new_id id) : id(id) {}
+
+        wl_object ID() const noexcept override {
+            return id;
+        }
+
+        /**
+            @brief Crops the buffer to a rectangle, in
+            buffer coordinates after buffer scale and
+            transform are applied.
+        */
+        void set_source(wl_fixed x, wl_fixed y, wl_fixed width, wl_fixed height) {
+            wl_message client_msg(id, SET_SOURCE_OPCODE, 4);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(to_fixed(x));
+            writer.write(to_fixed(y));
+            writer.write(to_fixed(width));
+            writer.write(to_fixed(height));
+        }
+
+        /**
+            @brief Shows the whole buffer again.
+        */
+        void unset_source() {
+            set_source(-1, -1, -1, -1);
+        }
+
+        /**
+            @brief Scales the (cropped) buffer to a surface
+            size, independent of the buffer size.
+        */
+        void set_destination(wl_int width, wl_int height) {
+            wl_message client_msg(id, SET_DESTINATION_OPCODE, 2);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(static_cast<wl_uint>(width));
+            writer.write(static_cast<wl_uint>(height));
+        }
+
+        /**
+            @brief Makes the surface size follow the buffer
+            again.
+        */
+        void unset_destination() {
+            set_destination(-1, -1);
+        }
+
+        void destroy() {
+            wl_message client_msg(id, DESTROY_OPCODE, 0);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+        }
+
+        void handle_event(uint16_t opcode, wl_message::reader reader) override {
+            lumber::warn("[Wayland::WARN]: wp::viewport has no events.");
+        }
+    };
+
+    /**
+        @brief Global for creating viewports.
+    */
+    class viewporter : public wl_obj {
+        const wl_object id;
+
+        static constexpr wl_uint DESTROY_OPCODE = 0;
+        static constexpr wl_uint GET_VIEWPORT_OPCODE = 1;
+
+        public:
+
+        viewporter(const wl_new_id id) : id(id) {}
+
+        wl_object ID() const noexcept override {
+            return id;
+        }
+
+        /**
+            @brief Creates the viewport of @p surface. A
+            surface can have at most one.
+        */
+        viewport& get_viewport(const wl_surface& surface) {
+            viewport* viewport = new wp::viewport(wl_id_assigner.request_id());
+            wl_id_map.create(*viewport);
+
+            wl_message client_msg(id, GET_VIEWPORT_OPCODE, 2);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+
+            writer.write(viewport->ID());
+            writer.write(surface.ID());
+
+            return *viewport;
+        }
+
+        void destroy() {
+            wl_message client_msg(id, DESTROY_OPCODE, 0);
+            wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
+        }
+
+        void handle_event(uint16_t opcode, wl_message::reader reader) override {
+            lumber::warn("[Wayland::WARN]: wp::viewporter has no events.");
+        }
+    };
+}
@@ -5,6 +5,15 @@
 
 #include "surface.h"
 
+#include <optional>
+
+/**
+    @brief Window role of an xdg_surface.
+
+    Configure events only describe the next state; it is
+    applied by the `configure` of the owning xdg_surface.
+    The latest state is kept here until then.
+*/
 class xdg_toplevel : public wl_obj {
 
     wl_object id;
@@ -31,40 +40,94 @@ class xdg_toplevel : public wl_obj {
 
     public:
 
+    enum class state : wl_uint {
+        maximised = 1,
+        fullscreen = 2,
+        resizing = 3,
+        activated = 4,
+        tiled_left = 5,
+        tiled_right = 6,
+        tiled_top = 7,
+        tiled_bottom = 8,
+        suspended = 9,
+    };
+
+    struct size {
+        wl_int width = 0;
+        wl_int height = 0;
+    };
+
+    /**
+        @brief The state asked for by the latest configure
+        event.
+    */
+    struct configure {
+        /** 0 leaves the size to the client. */
+        wl_int width = 0;
+        wl_int height = 0;
+
+        /** One bit per `state`, at `1 << state`. */
+        wl_uint states = 0;
+
+        /** The largest size the window should take, if the compositor sent it. */
+        std::optional<size> bounds;
+
+        bool has(const state state) const noexcept {
+            return states & (1u << static_cast<wl_uint>(state));
+        }
+    };
+
     struct listener {
-        void (*configure)(int width, int height);
         void (*close)();
-        void (*configure_bounds)(int width, int height);
         void (*wm_capabilities)();
     };
 
-    listener* listener;
+    listener* listener = nullptr;
 
     xdg_toplevel(const wl_new_id id) : id(id) {}
 
+    /** The latest configured state, applied or not. */
+    const configure& latest_configure() const noexcept {
+        return latest;
+    }
+
     wl_object ID() const noexcept override {
         return id;
     }
 
     void handle_event(uint16_t opcode, wl_message::reader reader) override {
-        if (!listener) {
-            throw std::runtime_error("No event listener supplied for xdg_toplevel");
-        }
-
         if (opcode == EV_CONFIGURE_OPCODE) {
-            const wl_int width = reader.read_int();
-            const wl_int height = reader.read_int();
+            latest.width = reader.read_int();
+            latest.height = reader.read_int();
+            latest.states = 0;
+
+            const wl_message::reader::array_view states = reader.read_array_view();
 
-            listener->configure(width, height);
+            for (wl_uint offset = 0; offset + WL_UINT_SIZE <= states.size; offset += WL_UINT_SIZE) {
+                const wl_uint state = read_wl_uint(states.data + offset);
+
+                if (state < 32) {
+                    latest.states |= 1u << state;
+                }
+            }
         } else if (opcode == EV_CLOSE_OPCODE) {
-            listener->close();
+            if (listener) {
+                listener->close();
+            }
         } else if (opcode == EV_CONFIGURE_BOUNDS_OPCODE) {
             const wl_int width = reader.read_int();
             const wl_int height = reader.read_int();
 
-            listener->configure_bounds(width, height);
+            // 0x0 means the bounds are unknown.
+            if (width > 0 && height > 0) {
+                latest.bounds = size { width, height };
+            } else {
+                latest.bounds.reset();
+            }
         } else if (opcode == EV_WM_CAPABILITIES_OPCODE) {
-            listener->wm_capabilities();
+            if (listener) {
+                listener->wm_capabilities();
+            }
         }
     }
 
@@ -112,6 +175,10 @@ class xdg_toplevel : public wl_obj {
         wl_message::writer writer = client_msg.new_writer(send_queue_alloc);
         
     }
+
+    private:
+
+    configure latest;
 };
 
 class xdg_positioner : public wl_obj {
@@ -131,21 +198,43 @@ class xdg_positioner : public wl_obj {
     }
 };
 
+/**
+    @brief Desktop-style role of a wl_surface.
+
+    During an interactive resize the compositor can send
+    many configure sequences between two frames. Rather than
+    reacting to each, the latest serial is recorded and
+    `apply_configure` acks only that one, then hands the
+    listener the latest state in one call. Acking a serial
+    also acks every earlier one.
+*/
 class xdg_surface : public wl_obj {
 
     wl_new_id id;
     wl_fd_t socket;
 
+    wl_surface& surface;
+    xdg_toplevel* toplevel = nullptr;
+
+    std::optional<wl_uint> pending_serial;
+    wl_uint pending_count = 0;
+
     public:
     
     struct listener {
-        void (*configure)(xdg_surface& surface, int serial);
+        /**
+            Apply @p configure, which has already been
+            acked, with the next commit. @p coalesced is the
+            number of configure sequences it replaces.
+        */
+        void (*configure)(xdg_surface& surface, const xdg_toplevel::configure& configure, wl_uint coalesced);
     };
 
-    listener* listener;
-
-    xdg_surface(const wl_new_id id) : id(id) {
+    listener* listener = nullptr;
 
+    /** Holds back @p surface's buffers until the first configure is applied. */
+    xdg_surface(const wl_new_id id, wl_surface& surface) : id(id), surface(surface) {
+        surface.await_configure();
     }
 
     wl_object ID() const noexcept override {
@@ -156,7 +245,7 @@ class xdg_surface : public wl_obj {
 
     xdg_toplevel& get_toplevel(const wl_fd_t socket) {
         this->socket = socket;
-        xdg_toplevel* toplevel = new xdg_toplevel(wl_id_assigner.request_id());
+        toplevel = new xdg_toplevel(wl_id_assigner.request_id());
         wl_id_map.create(*toplevel);
 
         wl_message client_msg(id, 1, 1);
@@ -178,13 +267,37 @@ class xdg_surface : public wl_obj {
         writer.write(serial);
     }
 
-    void handle_event(uint16_t opcode, wl_message::reader reader) override {
-        if (!listener) {
-            throw std::runtime_error("No event listener supplied for xdg_surface");
+    /**
+        @brief Acks and applies the latest configure
+        sequence, if one arrived since the last call. Call
+        it once after each batch of events is dispatched.
+
+        @returns `true` if a configure was applied.
+    */
+    bool apply_configure() {
+        if (!pending_serial) { return false; }
+
+        const wl_uint serial = *pending_serial;
+        const wl_uint coalesced = pending_count;
+
+        pending_serial.reset();
+        pending_count = 0;
+
+        ack_configure(serial);
+        surface.set_configured();
+
+        if (listener) {
+            listener->configure(*this, toplevel ? toplevel->latest_configure() : xdg_toplevel::configure {}, coalesced);
         }
-        
+
+        return true;
+    }
+
+    void handle_event(uint16_t opcode, wl_message::reader reader) override {
         if (opcode == 0) {
-            listener->configure(*this, reader.read_uint());
+            // Role events (e.g. xdg_toplevel.configure) come first and were already recorded.
+            pending_serial = reader.read_uint();
+            pending_count++;
         }
     }
 };
@@ -219,7 +332,7 @@ class xdg_wm_base : public wl_obj {
     }
 
     xdg_surface& get_xdg_surface(const wl_fd_t socket, wl_surface& surface) {
-        xdg_surface* x_surface = new xdg_surface(wl_id_assigner.request_id());
+        xdg_surface* x_surface = new xdg_surface(wl_id_assigner.request_id(), surface);
         wl_id_map.create(*x_surface);
 
         wl_message client_msg(id, GET_XDG_SURFACE_OPCODE, 2);
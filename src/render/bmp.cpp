@@ -0,0 +1,242 @@
+#include "bmp.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace render;
+
+namespace {
+
+    constexpr size_t FILE_HEADER_SIZE = 14;
+    constexpr size_t CORE_HEADER_SIZE = 12;
+    constexpr size_t INFO_HEADER_SIZE = 40;
+
+    constexpr uint32_t BI_RGB = 0;
+    constexpr uint32_t BI_BITFIELDS = 3;
+    constexpr uint32_t BI_ALPHABITFIELDS = 6;
+
+    template<class T>
+    T read_le(const uint8_t* data) {
+        T value;
+        memcpy(&value, data, sizeof(T));
+        return value;
+    }
+}
+
+bmp_image bmp_image::load(const std::string& path) {
+    const int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (file < 0) {
+        throw std::runtime_error("Failed to open file");
+    }
+
+    struct stat info;
+
+    if (fstat(file, &info) < 0 || info.st_size < static_cast<off_t>(FILE_HEADER_SIZE + CORE_HEADER_SIZE)) {
+        close(file);
+        throw std::runtime_error("File is too small to be a bitmap");
+    }
+
+    void* map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+
+    if (map == MAP_FAILED) {
+        throw std::runtime_error("Failed to map bitmap file");
+    }
+
+    madvise(map, info.st_size, MADV_SEQUENTIAL);
+
+    bmp_image image;
+    image.map = static_cast<const uint8_t*>(map);
+    image.map_size = info.st_size;
+
+    const uint8_t* data = image.map;
+
+    if (data[0] != 'B' || data[1] != 'M') {
+        throw std::runtime_error("Missing bitmap signature");
+    }
+
+    const uint32_t bitmap_offset = read_le<uint32_t>(data + 10);
+    const uint32_t header_size = read_le<uint32_t>(data + 14);
+
+    int32_t width;
+    int32_t height;
+    uint32_t compression = BI_RGB;
+
+    if (header_size == CORE_HEADER_SIZE) {
+        width = read_le<uint16_t>(data + 18);
+        height = read_le<int16_t>(data + 20);
+        image.bpp = read_le<uint16_t>(data + 24);
+    } else if (header_size >= INFO_HEADER_SIZE && image.map_size >= FILE_HEADER_SIZE + INFO_HEADER_SIZE) {
+        width = read_le<int32_t>(data + 18);
+        height = read_le<int32_t>(data + 22);
+        image.bpp = read_le<uint16_t>(data + 28);
+        compression = read_le<uint32_t>(data + 30);
+    } else {
+        throw std::runtime_error("Unsupported bitmap header");
+    }
+
+    if (width <= 0 || height == 0 || height == INT32_MIN) {
+        throw std::runtime_error("Invalid bitmap dimensions");
+    }
+
+    if (image.bpp != 24 && image.bpp != 32) {
+        throw std::runtime_error("Unsupported bitmap bit depth");
+    }
+
+    if (compression == BI_BITFIELDS || compression == BI_ALPHABITFIELDS) {
+        // Masks follow the info header, and are at the same offset inside V4/V5 headers.
+        const size_t masks_end = FILE_HEADER_SIZE + INFO_HEADER_SIZE + (compression == BI_ALPHABITFIELDS ? 16 : 12);
+
+        if (image.bpp != 32 || image.map_size < masks_end) {
+            throw std::runtime_error("Unsupported bitmap bitfields");
+        }
+
+        const uint8_t* masks = data + FILE_HEADER_SIZE + INFO_HEADER_SIZE;
+
+        if (read_le<uint32_t>(masks) != 0x00FF0000 || read_le<uint32_t>(masks + 4) != 0x0000FF00 || read_le<uint32_t>(masks + 8) != 0x000000FF) {
+            throw std::runtime_error("Unsupported bitmap channel masks");
+        }
+
+        const bool has_alpha_mask = compression == BI_ALPHABITFIELDS || header_size > INFO_HEADER_SIZE;
+        image.has_alpha = has_alpha_mask && read_le<uint32_t>(masks + 12) == 0xFF000000;
+    } else if (compression != BI_RGB) {
+        throw std::runtime_error("Compressed bitmaps are not supported");
+    }
+
+    image.width_n = width;
+    image.height_n = height < 0 ? -height : height;
+    image.top_down = height < 0;
+    image.row_stride = ((static_cast<size_t>(image.width_n) * image.bpp + 31) / 32) * 4;
+
+    if (bitmap_offset > image.map_size || image.row_stride * image.height_n > image.map_size - bitmap_offset) {
+        throw std::runtime_error("Bitmap data is truncated");
+    }
+
+    image.bitmap = data + bitmap_offset;
+
+    return image;
+}
+
+bmp_image::bmp_image(bmp_image&& other) noexcept {
+    *this = std::move(other);
+}
+
+bmp_image& bmp_image::operator=(bmp_image&& other) noexcept {
+    if (this == &other) { return *this; }
+
+    unmap();
+
+    map = std::exchange(other.map, nullptr);
+    map_size = std::exchange(other.map_size, 0);
+    bitmap = std::exchange(other.bitmap, nullptr);
+    row_stride = other.row_stride;
+    width_n = other.width_n;
+    height_n = other.height_n;
+    bpp = other.bpp;
+    top_down = other.top_down;
+    has_alpha = other.has_alpha;
+
+    return *this;
+}
+
+bmp_image::~bmp_image() {
+    unmap();
+}
+
+void bmp_image::unmap() noexcept {
+    if (!map) { return; }
+    munmap(const_cast<uint8_t*>(map), map_size);
+    map = nullptr;
+}
+
+uint32_t bmp_image::width() const noexcept {
+    return width_n;
+}
+
+uint32_t bmp_image::height() const noexcept {
+    return height_n;
+}
+
+uint16_t bmp_image::bits_per_pixel() const noexcept {
+    return bpp;
+}
+
+bool bmp_image::opaque() const noexcept {
+    return !has_alpha;
+}
+
+const uint8_t* bmp_image::row(const uint32_t y) const noexcept {
+    const uint32_t stored_row = top_down ? y : height_n - 1 - y;
+    return bitmap + stored_row * row_stride;
+}
+
+void bmp_image::advise_rows(const uint32_t first, const uint32_t count, const int advice) const {
+    if (count == 0) { return; }
+
+    const uint8_t* top = row(first);
+    const uint8_t* bottom = row(first + count - 1);
+
+    // Only whole pages inside the range can be advised on.
+    const uintptr_t page = sysconf(_SC_PAGESIZE);
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(std::min(top, bottom));
+    const uintptr_t end = reinterpret_cast<uintptr_t>(std::max(top, bottom)) + row_stride;
+    const uintptr_t aligned_begin = advice == MADV_WILLNEED ? begin & ~(page - 1) : (begin + page - 1) & ~(page - 1);
+    const uintptr_t aligned_end = advice == MADV_WILLNEED ? end : end & ~(page - 1);
+
+    if (aligned_end > aligned_begin) {
+        madvise(reinterpret_cast<void*>(aligned_begin), aligned_end - aligned_begin, advice);
+    }
+}
+
+void bmp_image::decode_chunk(const surface_view& dst, const uint32_t x, const uint32_t first, const uint32_t count) const {
+    for (uint32_t y = first; y < first + count; y++) {
+        const uint8_t* src = row(y) + static_cast<size_t>(x) * (bpp / 8);
+        uint32_t* out = dst.row(y - first);
+
+        if (bpp == 24) {
+            convert_row_24(out, src, dst.width, order24::bgr);
+        } else {
+            memcpy(out, src, dst.width * sizeof(uint32_t));
+
+            if (!has_alpha) {
+                for (uint32_t column = 0; column < dst.width; column++) {
+                    out[column] |= 0xFF000000;
+                }
+            }
+        }
+    }
+
+    // BMP alpha is straight; wl_shm ARGB8888 is premultiplied.
+    if (has_alpha) {
+        premultiply(dst.sub(0, 0, dst.width, count));
+    }
+}
+
+void bmp_image::decode(const surface_view& dst) const {
+    const surface_view target = dst.sub(0, 0, width_n, height_n);
+
+    for (uint32_t first = 0; first < target.height; first += CHUNK_ROWS) {
+        const uint32_t count = std::min(CHUNK_ROWS, target.height - first);
+
+        advise_rows(first + count, std::min(CHUNK_ROWS, target.height - first - count), MADV_WILLNEED);
+        decode_chunk(target.sub(0, first, target.width, count), 0, first, count);
+        advise_rows(first, count, MADV_DONTNEED);
+    }
+}
+
+void bmp_image::decode(const surface_view& dst, const rect& area) const {
+    const rect clipped = area.intersect({ .x = 0, .y = 0, .width = static_cast<int32_t>(width_n), .height = static_cast<int32_t>(height_n) });
+    const surface_view target = dst.sub(clipped);
+
+    if (target.width == 0 || target.height == 0) { return; }
+
+    decode_chunk(target, clipped.x, clipped.y, target.height);
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "pixel.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace render {
+
+    /**
+        @brief A memory-mapped BMP file.
+
+        The file is mapped read-only and never copied; rows
+        are converted straight from the mapping into a
+        destination surface, which is normally a slice of a
+        wl_shm buffer.
+
+        Supports uncompressed 24-bit and 32-bit images, both
+        bottom-up and top-down, including row padding.
+    */
+    class bmp_image {
+
+        /**
+            @brief Number of rows converted before the
+            consumed part of the mapping is released.
+        */
+        static constexpr uint32_t CHUNK_ROWS = 64;
+
+        const uint8_t* map = nullptr;
+        size_t map_size = 0;
+
+        const uint8_t* bitmap = nullptr;
+        size_t row_stride = 0;
+
+        uint32_t width_n = 0;
+        uint32_t height_n = 0;
+        uint16_t bpp = 0;
+        bool top_down = false;
+        bool has_alpha = false;
+
+        bmp_image() = default;
+
+        void unmap() noexcept;
+
+        /**
+            @brief Converts the pixels at [x, x + dst.width) of
+            rows [first, first + count) into @p dst, starting
+            at its top row.
+        */
+        void decode_chunk(const surface_view& dst, uint32_t x, uint32_t first, uint32_t count) const;
+
+        /**
+            @brief Hints to the kernel which part of the file
+            is needed next, and drops what has been consumed.
+        */
+        void advise_rows(uint32_t first, uint32_t count, int advice) const;
+
+        public:
+
+        /**
+            @brief Maps and parses the BMP file at @p path.
+
+            @throws std::runtime_error if the file can't be
+            mapped or uses an unsupported encoding.
+        */
+        static bmp_image load(const std::string& path);
+
+        bmp_image(const bmp_image&) = delete;
+        bmp_image& operator=(const bmp_image&) = delete;
+
+        bmp_image(bmp_image&& other) noexcept;
+        bmp_image& operator=(bmp_image&& other) noexcept;
+
+        ~bmp_image();
+
+        uint32_t width() const noexcept;
+
+        uint32_t height() const noexcept;
+
+        uint16_t bits_per_pixel() const noexcept;
+
+        /**
+            @brief Returns `true` if every decoded pixel is
+            fully opaque, i.e. the image has no alpha channel.
+        */
+        bool opaque() const noexcept;
+
+        /**
+            @brief Returns a pointer to row @p y counting from
+            the top of the image, regardless of the order the
+            rows are stored in.
+        */
+        const uint8_t* row(uint32_t y) const noexcept;
+
+        /**
+            @brief Converts the image into @p dst as
+            premultiplied ARGB8888.
+
+            Only the overlap of the image and @p dst is
+            written. Rows are converted in chunks of
+            `CHUNK_ROWS`.
+        */
+        void decode(const surface_view& dst) const;
+
+        /**
+            @brief Converts only the pixels of the image at
+            @p area into the matching pixels of @p dst.
+
+            Unlike the full decode, the mapping is left as it
+            is afterwards, since other parts of the same rows
+            are likely to be decoded next. Safe to call from
+            several threads at once for disjoint areas.
+        */
+        void decode(const surface_view& dst, const rect& area) const;
+    };
+}
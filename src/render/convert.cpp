@@ -0,0 +1,94 @@
+#include "convert.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace render;
+
+namespace {
+
+    /** 4x4 Bayer matrix, in sixteenths. */
+    constexpr uint8_t BAYER[4][4] = {
+        {  0,  8,  2, 10 },
+        { 12,  4, 14,  6 },
+        {  3, 11,  1,  9 },
+        { 15,  7, 13,  5 },
+    };
+
+    /**
+        @brief Reduces an 8-bit channel to @p bits bits,
+        adding @p threshold (in sixteenths of the lost
+        precision) before truncating.
+    */
+    template<int bits>
+    inline uint32_t reduce(const uint32_t channel, const uint32_t threshold) {
+        constexpr int shift = 8 - bits;
+        constexpr uint32_t max = (1u << bits) - 1;
+
+        const uint32_t biased = channel + ((threshold << shift) >> 4);
+        return std::min(biased >> shift, max);
+    }
+
+    template<int r_bits, int g_bits, int b_bits>
+    inline uint32_t pack(const uint32_t pixel, const uint32_t threshold) {
+        const uint32_t r = reduce<r_bits>((pixel >> 16) & 0xFF, threshold);
+        const uint32_t g = reduce<g_bits>((pixel >> 8) & 0xFF, threshold);
+        const uint32_t b = reduce<b_bits>(pixel & 0xFF, threshold);
+
+        return (r << (g_bits + b_bits)) | (g << b_bits) | b;
+    }
+
+    template<class T, int r_bits, int g_bits, int b_bits>
+    void convert_row(T* dst, const uint32_t* src, const size_t count, const uint32_t x, const uint32_t y, const bool dither) {
+        const uint8_t* const thresholds = BAYER[y & 3];
+
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t threshold = dither ? thresholds[(x + i) & 3] : 0;
+            dst[i] = static_cast<T>(pack<r_bits, g_bits, b_bits>(src[i], threshold));
+        }
+    }
+}
+
+bool render::can_convert(const Format format) noexcept {
+    switch (format) {
+        case Format::ARGB8888:
+        case Format::XRGB8888:
+        case Format::RGB565:
+        case Format::XRGB4444:
+        case Format::RGB332:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void render::convert(const surface_view& src, const Format format, uint8_t* dst, const size_t dst_stride, const rect& area, const bool dither) noexcept {
+    const rect clip = area.intersect({ .x = 0, .y = 0, .width = (int32_t)src.width, .height = (int32_t)src.height });
+
+    if (clip.empty()) { return; }
+
+    const size_t count = clip.width;
+
+    for (int32_t y = clip.y; y < clip.y + clip.height; y++) {
+        const uint32_t* const row = src.row(y) + clip.x;
+        uint8_t* const out = dst + static_cast<size_t>(y) * dst_stride;
+
+        switch (format) {
+            case Format::ARGB8888:
+            case Format::XRGB8888:
+                memcpy(out + clip.x * sizeof(uint32_t), row, count * sizeof(uint32_t));
+                break;
+            case Format::RGB565:
+                convert_row<uint16_t, 5, 6, 5>(reinterpret_cast<uint16_t*>(out) + clip.x, row, count, clip.x, y, dither);
+                break;
+            case Format::XRGB4444:
+                convert_row<uint16_t, 4, 4, 4>(reinterpret_cast<uint16_t*>(out) + clip.x, row, count, clip.x, y, dither);
+                break;
+            case Format::RGB332:
+                convert_row<uint8_t, 3, 3, 2>(out + clip.x, row, count, clip.x, y, dither);
+                break;
+            default:
+                return;
+        }
+    }
+}
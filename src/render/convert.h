@@ -0,0 +1,35 @@
+#pragma once
+
+#include "pixel.h"
+#include "../wl_utils/wl_enums.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace render {
+
+    /**
+        @brief Returns `true` if `convert` can write
+        @p format.
+
+        Besides the native ARGB8888 and XRGB8888, these are
+        the compact formats RGB565, XRGB4444 and RGB332,
+        which take a half or a quarter of the memory and
+        upload bandwidth. None of them have alpha.
+    */
+    bool can_convert(Format format) noexcept;
+
+    /**
+        @brief Converts the pixels of @p src inside @p area
+        to @p format, writing them to the same positions in
+        @p dst, which has @p dst_stride bytes per row.
+
+        @p src holds premultiplied ARGB8888, so dropping
+        alpha blends it onto black. With @p dither, compact
+        formats use a 4x4 ordered dither instead of plain
+        truncation. The dither depends only on the pixel
+        position, so converting damage separately gives the
+        same result as converting the whole frame.
+    */
+    void convert(const surface_view& src, Format format, uint8_t* dst, size_t dst_stride, const rect& area = rect::unbounded(), bool dither = true) noexcept;
+}
@@ -0,0 +1,112 @@
+#include "frame_clock.h"
+
+#include <algorithm>
+
+using namespace render;
+
+void frame_clock::set_refresh(const int32_t refresh_mhz) noexcept {
+    if (refresh_mhz <= 0) {
+        mode_interval = {};
+        return;
+    }
+
+    mode_interval = std::chrono::nanoseconds(1'000'000'000'000LL / refresh_mhz);
+}
+
+void frame_clock::vblank(const clock::time_point time) noexcept {
+    if (vblank_known && time > last_vblank) {
+        const std::chrono::nanoseconds delta = time - last_vblank;
+        const std::chrono::nanoseconds reference = measured_interval.count() > 0 ? measured_interval : DEFAULT_INTERVAL;
+
+        // Longer gaps mean refreshes we didn't draw for, not a slower display.
+        if (delta < reference * 3 / 2) {
+            measured_interval = measured_interval.count() > 0 ? (measured_interval * 7 + delta) / 8 : delta;
+        }
+    }
+
+    last_vblank = time;
+    vblank_known = true;
+}
+
+void frame_clock::presented(const clock::time_point time, const std::chrono::nanoseconds refresh) noexcept {
+    vblank(time);
+    vblank_exact = true;
+
+    if (refresh.count() > 0) {
+        presented_interval = refresh;
+    }
+}
+
+void frame_clock::render_time(const std::chrono::nanoseconds duration) noexcept {
+    render_times[render_count % RENDER_HISTORY] = duration;
+    render_count++;
+}
+
+std::chrono::nanoseconds frame_clock::refresh_interval() const noexcept {
+    if (presented_interval.count() > 0) { return presented_interval; }
+    if (vblank_exact && measured_interval.count() > 0) { return measured_interval; }
+    if (mode_interval.count() > 0) { return mode_interval; }
+    if (measured_interval.count() > 0) { return measured_interval; }
+
+    return DEFAULT_INTERVAL;
+}
+
+frame_clock::clock::time_point frame_clock::next_vblank(const clock::time_point now) const noexcept {
+    const std::chrono::nanoseconds interval = refresh_interval();
+
+    if (!vblank_known) {
+        return now + interval;
+    }
+
+    if (now < last_vblank) {
+        return last_vblank;
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_vblank);
+    return last_vblank + interval * (elapsed / interval + 1);
+}
+
+std::chrono::nanoseconds frame_clock::render_estimate() const noexcept {
+    const size_t count = std::min(render_count, RENDER_HISTORY);
+    const auto slowest = std::max_element(render_times.begin(), render_times.begin() + count);
+
+    return (count > 0 ? *slowest : std::chrono::nanoseconds {}) + render_slack;
+}
+
+frame_clock::clock::time_point frame_clock::deadline(const clock::time_point now) const noexcept {
+    const std::chrono::nanoseconds interval = refresh_interval();
+    const std::chrono::nanoseconds estimate = render_estimate();
+
+    clock::time_point vblank = next_vblank(now);
+
+    // Skip refreshes that are too close to draw for.
+    if (vblank - commit_margin - estimate < now) {
+        const auto shortfall = std::chrono::duration_cast<std::chrono::nanoseconds>(now - (vblank - commit_margin - estimate));
+        vblank += interval * (shortfall / interval + 1);
+    }
+
+    return vblank - commit_margin;
+}
+
+frame_clock::clock::time_point frame_clock::wake_time(const clock::time_point now) const noexcept {
+    return std::max(now, deadline(now) - render_estimate());
+}
+
+bool frame_clock::frame_committed(const clock::time_point deadline, const clock::time_point committed) noexcept {
+    frames++;
+
+    if (committed > deadline) {
+        missed++;
+        return true;
+    }
+
+    return false;
+}
+
+uint64_t frame_clock::frames_committed() const noexcept {
+    return frames;
+}
+
+uint64_t frame_clock::missed_deadlines() const noexcept {
+    return missed;
+}
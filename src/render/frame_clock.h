@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace render {
+
+    /**
+        @brief Predicts display refreshes and works out when
+        to start drawing a frame so it is committed just
+        before the next one.
+
+        Refreshes are predicted from the refresh interval,
+        phase-locked to the latest observed refresh time. The
+        interval reported by presentation feedback is used
+        first, then the one measured from presentation
+        timestamps, then the output's refresh rate, and last
+        the one measured from less exact refresh times.
+        Drawing starts as late as the slowest recent render
+        allows, so input is sampled as late as possible.
+
+        Frames committed after their deadline are counted as
+        missed.
+    */
+    class frame_clock {
+        public:
+
+        using clock = std::chrono::steady_clock;
+
+        /** Render times kept to estimate the next one. */
+        static constexpr size_t RENDER_HISTORY = 16;
+
+        /** Interval used until the refresh rate is known or measured. */
+        static constexpr std::chrono::nanoseconds DEFAULT_INTERVAL { 16'666'667 };
+
+        private:
+
+        /** Interval from the output mode, 0 if unknown. */
+        std::chrono::nanoseconds mode_interval {};
+        /** Interval from the latest presentation feedback, 0 if unknown. */
+        std::chrono::nanoseconds presented_interval {};
+        /** Interval measured from observed refreshes, 0 until measured. */
+        std::chrono::nanoseconds measured_interval {};
+
+        clock::time_point last_vblank {};
+        bool vblank_known = false;
+        /** Observed refreshes are presentation timestamps. */
+        bool vblank_exact = false;
+
+        std::array<std::chrono::nanoseconds, RENDER_HISTORY> render_times {};
+        size_t render_count = 0;
+
+        uint64_t frames = 0;
+        uint64_t missed = 0;
+
+        public:
+
+        /**
+            Time the compositor needs between our commit and
+            the refresh it should be shown on.
+        */
+        std::chrono::nanoseconds commit_margin { 2'000'000 };
+
+        /**
+            Extra time added on top of the render estimate, to
+            absorb wakeup latency and jitter.
+        */
+        std::chrono::nanoseconds render_slack { 1'000'000 };
+
+        /**
+            @brief Sets the refresh rate of the output the
+            surface is on, in mHz. 0 means unknown.
+        */
+        void set_refresh(int32_t refresh_mhz) noexcept;
+
+        /**
+            @brief Records the time of an observed refresh,
+            such as a presentation timestamp.
+        */
+        void vblank(clock::time_point time) noexcept;
+
+        /**
+            @brief Records a refresh from presentation
+            feedback, with the interval it reported (0 if
+            unknown). Both take precedence over the output
+            mode, which may be for another output.
+        */
+        void presented(clock::time_point time, std::chrono::nanoseconds refresh) noexcept;
+
+        /**
+            @brief Records how long a frame took to draw.
+        */
+        void render_time(std::chrono::nanoseconds duration) noexcept;
+
+        /**
+            @brief Time between refreshes, best estimate.
+        */
+        std::chrono::nanoseconds refresh_interval() const noexcept;
+
+        /**
+            @brief The first predicted refresh after `now`.
+        */
+        clock::time_point next_vblank(clock::time_point now) const noexcept;
+
+        /**
+            @brief Estimate for the next render time: the
+            slowest recent render plus `render_slack`.
+        */
+        std::chrono::nanoseconds render_estimate() const noexcept;
+
+        /**
+            @brief Latest commit time that still makes the
+            earliest refresh reachable from `now`.
+        */
+        clock::time_point deadline(clock::time_point now) const noexcept;
+
+        /**
+            @brief When to start drawing a frame to meet
+            `deadline(now)`. Never earlier than `now`.
+        */
+        clock::time_point wake_time(clock::time_point now) const noexcept;
+
+        /**
+            @brief Records a frame committed at `committed`
+            against the deadline it was started for.
+
+            @returns `true` if the deadline was missed.
+        */
+        bool frame_committed(clock::time_point deadline, clock::time_point committed) noexcept;
+
+        uint64_t frames_committed() const noexcept;
+        uint64_t missed_deadlines() const noexcept;
+    };
+}
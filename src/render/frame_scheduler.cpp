@@ -0,0 +1,69 @@
+#include "frame_scheduler.h"
+
+using namespace render;
+
+struct wl_callback::listener frame_scheduler::callback_listener {
+    .done = frame_scheduler::on_done,
+};
+
+frame_scheduler::frame_scheduler(wl_surface& surface) : surface(surface) {}
+
+void frame_scheduler::on_done(wl_callback& callback, const wl_uint time) {
+    frame_scheduler& scheduler = *static_cast<frame_scheduler*>(callback.user_data);
+
+    if (scheduler.pending.get() != &callback) { return; }
+
+    frame_timing& timing = scheduler.timing;
+    timing.interval = timing.count > 0 ? time - timing.time : 0;
+    timing.time = time;
+    timing.received = std::chrono::steady_clock::now();
+    timing.count++;
+
+    // Still inside the callback's handle_event, so it can't be deleted yet.
+    scheduler.finished = std::move(scheduler.pending);
+
+    if (scheduler.redraw_requested && scheduler.listener) {
+        scheduler.listener->redraw(scheduler);
+    }
+}
+
+void frame_scheduler::request_redraw() noexcept {
+    redraw_requested = true;
+}
+
+bool frame_scheduler::ready() const noexcept {
+    return redraw_requested && (async || !pending);
+}
+
+void frame_scheduler::set_async(const bool async) noexcept {
+    this->async = async;
+}
+
+bool frame_scheduler::is_async() const noexcept {
+    return async;
+}
+
+bool frame_scheduler::waiting() const noexcept {
+    return pending != nullptr;
+}
+
+void frame_scheduler::begin_frame() noexcept {
+    redraw_requested = false;
+}
+
+void frame_scheduler::arm() {
+    finished.reset();
+
+    // The outstanding callback covers this commit too.
+    if (pending) { return; }
+
+    wl_callback& callback = surface.frame();
+    callback.listener = &callback_listener;
+    callback.user_data = this;
+
+    pending.reset(&callback);
+}
+
+const frame_timing& frame_scheduler::last_frame() const noexcept {
+    return timing;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "../objects/surface.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace render {
+
+    /**
+        @brief Timing of the most recent frame callback.
+    */
+    struct frame_timing {
+        /** Compositor timestamp of the last `done`, in milliseconds. */
+        wl_uint time = 0;
+        /** Milliseconds between the last two `done` events, 0 until there are two. */
+        wl_uint interval = 0;
+        /** Local time the last `done` was received. */
+        std::chrono::steady_clock::time_point received {};
+        /** Number of `done` events received. */
+        uint64_t count = 0;
+    };
+
+    /**
+        @brief Paces redraws of a surface with
+        wl_surface.frame callbacks.
+
+        At most one frame is drawn per `done` event. While a
+        callback is outstanding, redraw requests are only
+        recorded; the `redraw` listener fires once the
+        compositor asks for the next frame. A surface the
+        compositor isn't showing never gets `done`, so it
+        stops drawing.
+
+        In async mode, for surfaces that allow tearing,
+        redraws go ahead as soon as they are requested.
+    */
+    class frame_scheduler {
+        public:
+
+        struct listener {
+            /**
+                Called when a requested redraw can go ahead
+                after a `done` event.
+            */
+            void (*redraw)(frame_scheduler& scheduler);
+        };
+
+        listener* listener = nullptr;
+
+        private:
+
+        wl_surface& surface;
+
+        std::unique_ptr<wl_callback> pending;
+        /** Callbacks that fired, freed outside of their own event handler. */
+        std::unique_ptr<wl_callback> finished;
+
+        bool redraw_requested = false;
+        bool async = false;
+        frame_timing timing;
+
+        static void on_done(wl_callback& callback, wl_uint time);
+
+        static struct wl_callback::listener callback_listener;
+
+        public:
+
+        explicit frame_scheduler(wl_surface& surface);
+
+        frame_scheduler(const frame_scheduler&) = delete;
+        frame_scheduler& operator=(const frame_scheduler&) = delete;
+
+        /**
+            @brief Marks the surface as needing a new frame.
+        */
+        void request_redraw() noexcept;
+
+        /**
+            @brief Returns `true` if a redraw has been
+            requested and no frame callback is outstanding,
+            or in async mode, as soon as one is requested.
+        */
+        bool ready() const noexcept;
+
+        /**
+            @brief Stops waiting for frame callbacks before
+            drawing. Callbacks are still requested, so
+            `last_frame()` keeps being updated.
+        */
+        void set_async(bool async) noexcept;
+
+        bool is_async() const noexcept;
+
+        /**
+            @brief Returns `true` while waiting for `done`.
+        */
+        bool waiting() const noexcept;
+
+        /**
+            @brief Clears the redraw request. Call once a
+            frame answering it has started drawing, so
+            requests made while it draws get a frame of
+            their own.
+        */
+        void begin_frame() noexcept;
+
+        /**
+            @brief Requests the next frame callback. Call
+            right before every commit that shows a buffer,
+            so the request is part of that commit.
+
+            Does nothing if a callback is already
+            outstanding. Redraw requests are left alone,
+            since a commit can re-show an old frame.
+        */
+        void arm();
+
+        const frame_timing& last_frame() const noexcept;
+    };
+}
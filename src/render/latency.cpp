@@ -0,0 +1,183 @@
+#include "latency.h"
+
+#include <algorithm>
+#include <time.h>
+
+using namespace render;
+
+void histogram::record(const std::chrono::nanoseconds latency) noexcept {
+    const int64_t ns = std::max<int64_t>(0, latency.count());
+    const size_t bucket = std::min<uint64_t>(ns / BUCKET_WIDTH.count(), BUCKETS);
+
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    samples.fetch_add(1, std::memory_order_relaxed);
+    total_ns.fetch_add(ns, std::memory_order_relaxed);
+
+    int64_t current = max_ns.load(std::memory_order_relaxed);
+    while (ns > current && !max_ns.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {}
+}
+
+uint64_t histogram::count() const noexcept {
+    return samples.load(std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds histogram::mean() const noexcept {
+    const uint64_t n = count();
+    return std::chrono::nanoseconds(n > 0 ? total_ns.load(std::memory_order_relaxed) / static_cast<int64_t>(n) : 0);
+}
+
+std::chrono::nanoseconds histogram::max() const noexcept {
+    return std::chrono::nanoseconds(max_ns.load(std::memory_order_relaxed));
+}
+
+std::chrono::nanoseconds histogram::percentile(const double p) const noexcept {
+    // Sum the buckets instead of trusting `samples`, which may be ahead of them.
+    uint64_t n = 0;
+    for (const std::atomic<uint64_t>& bucket : buckets) {
+        n += bucket.load(std::memory_order_relaxed);
+    }
+
+    if (n == 0) { return {}; }
+
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::clamp(p, 0.0, 1.0) * n + 0.5));
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < BUCKETS; i++) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+
+        if (seen >= rank) {
+            return BUCKET_WIDTH * (i + 1);
+        }
+    }
+
+    return max();
+}
+
+void histogram::reset() noexcept {
+    for (std::atomic<uint64_t>& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+
+    samples = 0;
+    total_ns = 0;
+    max_ns = 0;
+}
+
+struct wp::presentation_feedback::listener latency_tracker::feedback_listener {
+    .presented = latency_tracker::on_presented,
+    .discarded = latency_tracker::on_discarded,
+};
+
+latency_tracker::latency_tracker(wp::presentation& presentation, wl_surface& surface) : presentation(presentation), surface(surface) {}
+
+void latency_tracker::commit(const std::optional<wl_uint> input_time) {
+    finished.clear();
+
+    wp::presentation_feedback& feedback = presentation.feedback(surface);
+    feedback.listener = &feedback_listener;
+    feedback.user_data = this;
+
+    // So the next commit is sent, and the feedback is for this frame.
+    surface.mark_dirty();
+
+    pending.push_back(frame {
+        .feedback = std::unique_ptr<wp::presentation_feedback>(&feedback),
+        .commit_time = now(),
+        .input_time = input_time,
+    });
+}
+
+int64_t latency_tracker::now() const noexcept {
+    timespec time;
+    clock_gettime(static_cast<clockid_t>(presentation.clock_id()), &time);
+
+    return static_cast<int64_t>(time.tv_sec) * 1'000'000'000 + time.tv_nsec;
+}
+
+std::optional<latency_tracker::frame> latency_tracker::take(wp::presentation_feedback& feedback) {
+    const auto it = std::find_if(pending.begin(), pending.end(), [&](const frame& entry) {
+        return entry.feedback.get() == &feedback;
+    });
+
+    if (it == pending.end()) { return std::nullopt; }
+
+    frame entry = std::move(*it);
+    pending.erase(it);
+
+    // Still inside the feedback's handle_event, so it can't be deleted yet.
+    finished.push_back(std::move(entry.feedback));
+
+    return entry;
+}
+
+void latency_tracker::on_presented(wp::presentation_feedback& feedback, const wp::presentation_feedback::presented_info& info) {
+    latency_tracker& tracker = *static_cast<latency_tracker*>(feedback.user_data);
+    const std::optional<frame> entry = tracker.take(feedback);
+
+    if (!entry) { return; }
+
+    tracker.presented_count.fetch_add(1, std::memory_order_relaxed);
+    if (info.flags & wp::presentation_feedback::KIND_VSYNC) { tracker.vsync_count.fetch_add(1, std::memory_order_relaxed); }
+    if (info.flags & wp::presentation_feedback::KIND_ZERO_COPY) { tracker.zero_copy_count.fetch_add(1, std::memory_order_relaxed); }
+
+    tracker.commit_latency.record(std::chrono::nanoseconds(info.time - entry->commit_time));
+
+    if (entry->input_time) {
+        // Input timestamps are 32-bit milliseconds, usually on the same clock.
+        const wl_uint present_ms = static_cast<wl_uint>(info.time / 1'000'000);
+        const wl_uint elapsed_ms = present_ms - *entry->input_time;
+
+        // Anything this large means the clocks don't match.
+        if (elapsed_ms < 1000) {
+            tracker.input_latency.record(std::chrono::milliseconds(elapsed_ms));
+        }
+    }
+
+    if (tracker.listener) {
+        tracker.listener->presented(tracker, info);
+    }
+}
+
+void latency_tracker::on_discarded(wp::presentation_feedback& feedback) {
+    latency_tracker& tracker = *static_cast<latency_tracker*>(feedback.user_data);
+
+    if (tracker.take(feedback)) {
+        tracker.discarded_count.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+const histogram& latency_tracker::commit_to_present() const noexcept {
+    return commit_latency;
+}
+
+const histogram& latency_tracker::input_to_present() const noexcept {
+    return input_latency;
+}
+
+uint64_t latency_tracker::presented() const noexcept {
+    return presented_count.load(std::memory_order_relaxed);
+}
+
+uint64_t latency_tracker::discarded() const noexcept {
+    return discarded_count.load(std::memory_order_relaxed);
+}
+
+void latency_tracker::report(std::ostream& out) const {
+    const auto ms = [](const std::chrono::nanoseconds time) {
+        return std::chrono::duration<double, std::milli>(time).count();
+    };
+
+    const auto summary = [&](const char* name, const histogram& histogram) {
+        out << name << ": " << histogram.count() << " samples"
+            << ", mean " << ms(histogram.mean()) << " ms"
+            << ", p50 " << ms(histogram.percentile(0.50)) << " ms"
+            << ", p99 " << ms(histogram.percentile(0.99)) << " ms"
+            << ", max " << ms(histogram.max()) << " ms\n";
+    };
+
+    out << "Presented: " << presented() << " (vsync " << vsync_count.load(std::memory_order_relaxed)
+        << ", zero-copy " << zero_copy_count.load(std::memory_order_relaxed) << "), discarded: " << discarded() << '\n';
+
+    summary("Commit to present", commit_latency);
+    summary("Input to present", input_latency);
+}
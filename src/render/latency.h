@@ -0,0 +1,137 @@
+#pragma once
+
+#include "../objects/presentation.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+namespace render {
+
+    /**
+        @brief Fixed-bucket latency histogram.
+
+        Buckets are `BUCKET_WIDTH` wide, with a final bucket
+        for everything past the range. Recording and reading
+        are lock-free, so any thread can query it while the
+        protocol thread records.
+    */
+    class histogram {
+        public:
+
+        static constexpr std::chrono::nanoseconds BUCKET_WIDTH { 250'000 };
+        static constexpr size_t BUCKETS = 256;
+
+        private:
+
+        std::array<std::atomic<uint64_t>, BUCKETS + 1> buckets {};
+        std::atomic<uint64_t> samples = 0;
+        std::atomic<int64_t> total_ns = 0;
+        std::atomic<int64_t> max_ns = 0;
+
+        public:
+
+        void record(std::chrono::nanoseconds latency) noexcept;
+
+        uint64_t count() const noexcept;
+        std::chrono::nanoseconds mean() const noexcept;
+        std::chrono::nanoseconds max() const noexcept;
+
+        /**
+            @brief Upper bound of the bucket holding the
+            @p p th percentile, with `p` in [0, 1]. Samples
+            past the range report `max()`.
+        */
+        std::chrono::nanoseconds percentile(double p) const noexcept;
+
+        void reset() noexcept;
+    };
+
+    /**
+        @brief Tracks when a surface's commits reach the
+        screen, using presentation feedback.
+
+        Call `commit()` right before each commit. Records the
+        commit-to-present latency of every presented frame,
+        and the input-to-present latency of frames drawn
+        after an input event.
+    */
+    class latency_tracker {
+        public:
+
+        struct listener {
+            /** Called for every presented frame, e.g. to feed a frame_clock. */
+            void (*presented)(latency_tracker& tracker, const wp::presentation_feedback::presented_info& info);
+        };
+
+        listener* listener = nullptr;
+
+        private:
+
+        struct frame {
+            std::unique_ptr<wp::presentation_feedback> feedback;
+            int64_t commit_time;
+            std::optional<wl_uint> input_time;
+        };
+
+        wp::presentation& presentation;
+        wl_surface& surface;
+
+        std::vector<frame> pending;
+        /** Feedback that fired, freed outside of its own event handler. */
+        std::vector<std::unique_ptr<wp::presentation_feedback>> finished;
+
+        histogram commit_latency;
+        histogram input_latency;
+
+        std::atomic<uint64_t> presented_count = 0;
+        std::atomic<uint64_t> discarded_count = 0;
+        std::atomic<uint64_t> vsync_count = 0;
+        std::atomic<uint64_t> zero_copy_count = 0;
+
+        static void on_presented(wp::presentation_feedback& feedback, const wp::presentation_feedback::presented_info& info);
+        static void on_discarded(wp::presentation_feedback& feedback);
+
+        static struct wp::presentation_feedback::listener feedback_listener;
+
+        std::optional<frame> take(wp::presentation_feedback& feedback);
+
+        public:
+
+        latency_tracker(wp::presentation& presentation, wl_surface& surface);
+
+        latency_tracker(const latency_tracker&) = delete;
+        latency_tracker& operator=(const latency_tracker&) = delete;
+
+        /**
+            @brief Requests feedback for the next commit.
+
+            @param input_time Timestamp of the newest input
+            event the frame reflects, in milliseconds, as
+            sent by the compositor.
+        */
+        void commit(std::optional<wl_uint> input_time = std::nullopt);
+
+        /**
+            @brief Current time on the presentation clock, in
+            nanoseconds.
+        */
+        int64_t now() const noexcept;
+
+        const histogram& commit_to_present() const noexcept;
+        const histogram& input_to_present() const noexcept;
+
+        uint64_t presented() const noexcept;
+        uint64_t discarded() const noexcept;
+
+        /**
+            @brief Writes a summary of both histograms.
+        */
+        void report(std::ostream& out) const;
+    };
+}
@@ -0,0 +1,105 @@
+#include "pipeline.h"
+
+#include <stdexcept>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace render;
+
+namespace {
+
+    void signal_fd(const int fd) {
+        const uint64_t one = 1;
+        write(fd, &one, sizeof(one));
+    }
+
+    void drain_fd(const int fd) {
+        uint64_t count;
+        read(fd, &count, sizeof(count));
+    }
+}
+
+pipeline::pipeline(render_fn render, wake_fn on_wake) : render(std::move(render)), on_wake(std::move(on_wake)) {
+    request_fd = eventfd(0, EFD_CLOEXEC);
+    result_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    if (request_fd < 0 || result_fd < 0) {
+        throw std::runtime_error("Failed to create render pipeline eventfds");
+    }
+
+    thread = std::thread(&pipeline::thread_main, this);
+}
+
+pipeline::~pipeline() {
+    stopping = true;
+    signal_fd(request_fd);
+    thread.join();
+
+    close(request_fd);
+    close(result_fd);
+}
+
+void pipeline::thread_main() {
+    while (true) {
+        // Blocks until the protocol thread submits something.
+        drain_fd(request_fd);
+
+        if (stopping) { return; }
+
+        if (on_wake) {
+            on_wake();
+        }
+
+        frame_request request;
+
+        while (requests.pop(request)) {
+            const auto start = std::chrono::steady_clock::now();
+            render(request);
+
+            const frame_result result {
+                .serial = request.serial,
+                .damage = request.damage,
+                .render_time = std::chrono::steady_clock::now() - start,
+            };
+
+            // Can't fill: submit() keeps at most QUEUE_DEPTH frames in flight.
+            results.push(result);
+            signal_fd(result_fd);
+        }
+    }
+}
+
+bool pipeline::submit(const frame_request& request) {
+    if (in_flight == QUEUE_DEPTH || !requests.push(request)) {
+        return false;
+    }
+
+    in_flight++;
+    signal_fd(request_fd);
+    return true;
+}
+
+void pipeline::wake() {
+    signal_fd(request_fd);
+}
+
+std::optional<frame_result> pipeline::poll() {
+    frame_result result;
+
+    if (!results.pop(result)) {
+        drain_fd(result_fd);
+
+        // A result may have landed between the pop and the drain.
+        if (!results.pop(result)) {
+            return std::nullopt;
+        }
+    }
+
+    in_flight--;
+    return result;
+}
+
+int pipeline::fd() const noexcept {
+    return result_fd;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "pixel.h"
+#include "../buffers/ring.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <thread>
+
+namespace render {
+
+    /**
+        @brief Snapshot of the input state a frame should be
+        drawn with.
+    */
+    struct input_state {
+        float pointer_x = 0;
+        float pointer_y = 0;
+        uint32_t buttons = 0;
+        bool pointer_inside = false;
+    };
+
+    /**
+        @brief A frame for the render thread to draw.
+
+        `target` must stay mapped until the matching
+        frame_result has been received.
+    */
+    struct frame_request {
+        uint64_t serial = 0;
+        surface_view target;
+        rect damage;
+        input_state input;
+    };
+
+    /**
+        @brief A finished frame, ready to be attached and
+        committed by the protocol thread.
+    */
+    struct frame_result {
+        uint64_t serial = 0;
+        rect damage;
+        std::chrono::nanoseconds render_time {};
+    };
+
+    /**
+        @brief Runs rendering on a dedicated thread, pipelined
+        with the thread that services the Wayland socket.
+
+        The protocol thread submits frame requests and polls
+        for results. Both directions go through lock-free
+        rings, and each side is woken with an eventfd, so the
+        protocol thread can wait on `fd()` next to the
+        display socket and never blocks on a frame being
+        drawn.
+
+        The render function runs only on the render thread
+        and must not touch any Wayland object. Neither does
+        the optional wake function, which runs each time the
+        render thread wakes, before any frame is drawn, so
+        other work (like draining input) can be handed over
+        without asking for a frame.
+    */
+    class pipeline {
+        public:
+
+        using render_fn = std::function<void(const frame_request& request)>;
+        using wake_fn = std::function<void()>;
+
+        private:
+
+        static constexpr size_t QUEUE_DEPTH = 8;
+
+        render_fn render;
+        wake_fn on_wake;
+
+        wl::spsc_ring<frame_request, QUEUE_DEPTH> requests;
+        wl::spsc_ring<frame_result, QUEUE_DEPTH> results;
+
+        int request_fd = -1;
+        int result_fd = -1;
+
+        /** Frames submitted but not yet polled. Bounds both rings. */
+        size_t in_flight = 0;
+
+        std::atomic<bool> stopping = false;
+        std::thread thread;
+
+        void thread_main();
+
+        public:
+
+        explicit pipeline(render_fn render, wake_fn on_wake = nullptr);
+
+        pipeline(const pipeline&) = delete;
+        pipeline& operator=(const pipeline&) = delete;
+
+        ~pipeline();
+
+        /**
+            @brief Queues a frame for the render thread.
+            Protocol thread only.
+
+            @returns `false` if `QUEUE_DEPTH` frames are
+            already in flight.
+        */
+        bool submit(const frame_request& request);
+
+        /**
+            @brief Wakes the render thread to run the wake
+            function, without a frame. Protocol thread only.
+        */
+        void wake();
+
+        /**
+            @brief Returns the next finished frame, if any.
+            Protocol thread only; never blocks.
+        */
+        std::optional<frame_result> poll();
+
+        /**
+            @brief File descriptor that becomes readable when
+            finished frames are waiting to be polled.
+        */
+        int fd() const noexcept;
+    };
+}
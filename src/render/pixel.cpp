@@ -0,0 +1,486 @@
+#include "pixel.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RENDER_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace render;
+
+namespace {
+
+    /**
+        @brief Per-channel state of a gradient row in 16.16
+        fixed point, in memory order (b, g, r, a).
+    */
+    struct gradient_row_state {
+        int32_t start[4];
+        int32_t step[4];
+    };
+
+    using convert_row_fn = void (*)(uint32_t* dst, const uint8_t* src, size_t count);
+
+    struct kernel_table {
+        isa level;
+        void (*fill_row)(uint32_t* dst, size_t count, uint32_t colour);
+        void (*gradient_row)(uint32_t* dst, size_t count, const gradient_row_state& state);
+        convert_row_fn convert_row_bgr;
+        convert_row_fn convert_row_rgb;
+        void (*premultiply_row)(uint32_t* px, size_t count);
+    };
+
+    /** SCALAR */
+
+    inline uint32_t div255(const uint32_t x) {
+        const uint32_t t = x + 128;
+        return (t + (t >> 8)) >> 8;
+    }
+
+    inline uint32_t premultiply_pixel(const uint32_t p) {
+        const uint32_t a = p >> 24;
+        const uint32_t r = div255(((p >> 16) & 0xFF) * a);
+        const uint32_t g = div255(((p >> 8) & 0xFF) * a);
+        const uint32_t b = div255((p & 0xFF) * a);
+        return (a << 24) | (r << 16) | (g << 8) | b;
+    }
+
+    void fill_row_scalar(uint32_t* dst, const size_t count, const uint32_t colour) {
+        for (size_t i = 0; i < count; i++) {
+            dst[i] = colour;
+        }
+    }
+
+    /**
+        @brief Scalar gradient starting at column @p first of
+        the row described by @p state. Used directly and for
+        the tails of the SIMD variants.
+    */
+    void gradient_row_from(uint32_t* dst, const size_t count, const gradient_row_state& state, const size_t first) {
+        for (size_t i = 0; i < count; i++) {
+            const int32_t x = static_cast<int32_t>(first + i);
+            uint32_t pixel = 0;
+
+            for (int c = 0; c < 4; c++) {
+                const int32_t value = (state.start[c] + x * state.step[c]) >> 16;
+                pixel |= static_cast<uint32_t>(std::clamp(value, 0, 255)) << (c * 8);
+            }
+
+            dst[i] = pixel;
+        }
+    }
+
+    void gradient_row_scalar(uint32_t* dst, const size_t count, const gradient_row_state& state) {
+        gradient_row_from(dst, count, state, 0);
+    }
+
+    void convert_row_bgr_scalar(uint32_t* dst, const uint8_t* src, const size_t count) {
+        for (size_t i = 0; i < count; i++, src += 3) {
+            dst[i] = argb(0xFF, src[2], src[1], src[0]);
+        }
+    }
+
+    void convert_row_rgb_scalar(uint32_t* dst, const uint8_t* src, const size_t count) {
+        for (size_t i = 0; i < count; i++, src += 3) {
+            dst[i] = argb(0xFF, src[0], src[1], src[2]);
+        }
+    }
+
+    void premultiply_row_scalar(uint32_t* px, const size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            px[i] = premultiply_pixel(px[i]);
+        }
+    }
+
+#ifdef RENDER_X86
+
+    /** SSE2 */
+
+    __attribute__((target("sse2")))
+    void fill_row_sse2(uint32_t* dst, const size_t count, const uint32_t colour) {
+        const __m128i v = _mm_set1_epi32(static_cast<int>(colour));
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+        }
+
+        fill_row_scalar(dst + i, count - i, colour);
+    }
+
+    __attribute__((target("sse2")))
+    void gradient_row_sse2(uint32_t* dst, const size_t count, const gradient_row_state& state) {
+        const __m128i step = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state.step));
+        const __m128i step4 = _mm_slli_epi32(step, 2);
+
+        __m128i acc0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state.start));
+        __m128i acc1 = _mm_add_epi32(acc0, step);
+        __m128i acc2 = _mm_add_epi32(acc1, step);
+        __m128i acc3 = _mm_add_epi32(acc2, step);
+
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4) {
+            const __m128i lo = _mm_packs_epi32(_mm_srai_epi32(acc0, 16), _mm_srai_epi32(acc1, 16));
+            const __m128i hi = _mm_packs_epi32(_mm_srai_epi32(acc2, 16), _mm_srai_epi32(acc3, 16));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+
+            acc0 = _mm_add_epi32(acc0, step4);
+            acc1 = _mm_add_epi32(acc1, step4);
+            acc2 = _mm_add_epi32(acc2, step4);
+            acc3 = _mm_add_epi32(acc3, step4);
+        }
+
+        gradient_row_from(dst + i, count - i, state, i);
+    }
+
+    /**
+        @brief Premultiplies two pixels held as 16-bit
+        channels. The alpha lanes are multiplied by 255 so
+        they come out unchanged.
+    */
+    __attribute__((target("sse2")))
+    inline __m128i premultiply_epi16_sse2(const __m128i px) {
+        const __m128i alpha_lanes = _mm_set_epi16(0xFF, 0, 0, 0, 0xFF, 0, 0, 0);
+        const __m128i colour_lanes = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+
+        __m128i alpha = _mm_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3));
+        alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+        alpha = _mm_or_si128(_mm_and_si128(alpha, colour_lanes), alpha_lanes);
+
+        __m128i x = _mm_add_epi16(_mm_mullo_epi16(px, alpha), _mm_set1_epi16(128));
+        x = _mm_add_epi16(x, _mm_srli_epi16(x, 8));
+        return _mm_srli_epi16(x, 8);
+    }
+
+    __attribute__((target("sse2")))
+    void premultiply_row_sse2(uint32_t* px, const size_t count) {
+        const __m128i zero = _mm_setzero_si128();
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(px + i));
+            const __m128i lo = premultiply_epi16_sse2(_mm_unpacklo_epi8(v, zero));
+            const __m128i hi = premultiply_epi16_sse2(_mm_unpackhi_epi8(v, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(px + i), _mm_packus_epi16(lo, hi));
+        }
+
+        premultiply_row_scalar(px + i, count - i);
+    }
+
+    /** SSSE3 */
+
+    /**
+        @brief Expands 24-bit pixels with a byte shuffle. Four
+        pixels are produced from each 16 byte load, of which
+        only the first 12 bytes are used, so the loop stops
+        while at least 16 bytes of source remain.
+    */
+    __attribute__((target("ssse3")))
+    inline void convert_row_24_ssse3(uint32_t* dst, const uint8_t* src, const size_t count, const __m128i shuffle, convert_row_fn tail) {
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+        size_t i = 0;
+
+        for (; i + 6 <= count; i += 4) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_shuffle_epi8(v, shuffle), alpha));
+        }
+
+        tail(dst + i, src + i * 3, count - i);
+    }
+
+    __attribute__((target("ssse3")))
+    void convert_row_bgr_ssse3(uint32_t* dst, const uint8_t* src, const size_t count) {
+        convert_row_24_ssse3(dst, src, count, _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1), convert_row_bgr_scalar);
+    }
+
+    __attribute__((target("ssse3")))
+    void convert_row_rgb_ssse3(uint32_t* dst, const uint8_t* src, const size_t count) {
+        convert_row_24_ssse3(dst, src, count, _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1), convert_row_rgb_scalar);
+    }
+
+    /** AVX2 */
+
+    __attribute__((target("avx2")))
+    void fill_row_avx2(uint32_t* dst, const size_t count, const uint32_t colour) {
+        const __m256i v = _mm256_set1_epi32(static_cast<int>(colour));
+        size_t i = 0;
+
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+        }
+
+        fill_row_sse2(dst + i, count - i, colour);
+    }
+
+    /**
+        @brief AVX2 version of convert_row_24_ssse3. Each
+        128-bit lane is loaded separately since the byte
+        shuffle cannot cross lanes.
+    */
+    __attribute__((target("avx2")))
+    inline void convert_row_24_avx2(uint32_t* dst, const uint8_t* src, const size_t count, const __m128i shuffle, convert_row_fn tail) {
+        const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+        const __m256i mask = _mm256_broadcastsi128_si256(shuffle);
+        size_t i = 0;
+
+        for (; i + 10 <= count; i += 8) {
+            const uint8_t* p = src + i * 3;
+            const __m256i v = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)), 1
+            );
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_or_si256(_mm256_shuffle_epi8(v, mask), alpha));
+        }
+
+        convert_row_24_ssse3(dst + i, src + i * 3, count - i, shuffle, tail);
+    }
+
+    __attribute__((target("avx2")))
+    void convert_row_bgr_avx2(uint32_t* dst, const uint8_t* src, const size_t count) {
+        convert_row_24_avx2(dst, src, count, _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1), convert_row_bgr_scalar);
+    }
+
+    __attribute__((target("avx2")))
+    void convert_row_rgb_avx2(uint32_t* dst, const uint8_t* src, const size_t count) {
+        convert_row_24_avx2(dst, src, count, _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1), convert_row_rgb_scalar);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i premultiply_epi16_avx2(const __m256i px) {
+        const __m256i alpha_lanes = _mm256_set_epi16(0xFF, 0, 0, 0, 0xFF, 0, 0, 0, 0xFF, 0, 0, 0, 0xFF, 0, 0, 0);
+        const __m256i colour_lanes = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+
+        __m256i alpha = _mm256_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3));
+        alpha = _mm256_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+        alpha = _mm256_or_si256(_mm256_and_si256(alpha, colour_lanes), alpha_lanes);
+
+        __m256i x = _mm256_add_epi16(_mm256_mullo_epi16(px, alpha), _mm256_set1_epi16(128));
+        x = _mm256_add_epi16(x, _mm256_srli_epi16(x, 8));
+        return _mm256_srli_epi16(x, 8);
+    }
+
+    __attribute__((target("avx2")))
+    void premultiply_row_avx2(uint32_t* px, const size_t count) {
+        const __m256i zero = _mm256_setzero_si256();
+        size_t i = 0;
+
+        for (; i + 8 <= count; i += 8) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(px + i));
+            const __m256i lo = premultiply_epi16_avx2(_mm256_unpacklo_epi8(v, zero));
+            const __m256i hi = premultiply_epi16_avx2(_mm256_unpackhi_epi8(v, zero));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(px + i), _mm256_packus_epi16(lo, hi));
+        }
+
+        premultiply_row_sse2(px + i, count - i);
+    }
+
+#endif
+
+    isa detect_isa() {
+#ifdef RENDER_X86
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx2")) { return isa::avx2; }
+        if (__builtin_cpu_supports("ssse3")) { return isa::ssse3; }
+        if (__builtin_cpu_supports("sse2")) { return isa::sse2; }
+#endif
+        return isa::scalar;
+    }
+
+    kernel_table table_for(const isa level) {
+        kernel_table table {
+            .level = isa::scalar,
+            .fill_row = fill_row_scalar,
+            .gradient_row = gradient_row_scalar,
+            .convert_row_bgr = convert_row_bgr_scalar,
+            .convert_row_rgb = convert_row_rgb_scalar,
+            .premultiply_row = premultiply_row_scalar,
+        };
+
+#ifdef RENDER_X86
+        if (level >= isa::sse2) {
+            table.level = isa::sse2;
+            table.fill_row = fill_row_sse2;
+            table.gradient_row = gradient_row_sse2;
+            table.premultiply_row = premultiply_row_sse2;
+        }
+
+        if (level >= isa::ssse3) {
+            table.level = isa::ssse3;
+            table.convert_row_bgr = convert_row_bgr_ssse3;
+            table.convert_row_rgb = convert_row_rgb_ssse3;
+        }
+
+        if (level >= isa::avx2) {
+            table.level = isa::avx2;
+            table.fill_row = fill_row_avx2;
+            table.convert_row_bgr = convert_row_bgr_avx2;
+            table.convert_row_rgb = convert_row_rgb_avx2;
+            table.premultiply_row = premultiply_row_avx2;
+        }
+#endif
+
+        return table;
+    }
+
+    /**
+        @brief The active kernel table. Built on first use so
+        that kernels are safe to call from static initialisers.
+    */
+    kernel_table& kernels() {
+        static kernel_table table = table_for(detect_isa());
+        return table;
+    }
+
+    inline int32_t channel(const uint32_t colour, const int c) {
+        return static_cast<int32_t>((colour >> (c * 8)) & 0xFF);
+    }
+}
+
+surface_view surface_view::sub(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const noexcept {
+    x = std::min(x, width);
+    y = std::min(y, height);
+    w = std::min(w, width - x);
+    h = std::min(h, height - y);
+
+    return {
+        .pixels = pixels + static_cast<size_t>(y) * stride + x,
+        .width = w,
+        .height = h,
+        .stride = stride,
+    };
+}
+
+surface_view surface_view::sub(const rect& area) const noexcept {
+    const rect clipped = area.intersect({ .x = 0, .y = 0, .width = static_cast<int32_t>(width), .height = static_cast<int32_t>(height) });
+
+    if (clipped.empty()) {
+        return sub(0, 0, 0, 0);
+    }
+
+    return sub(clipped.x, clipped.y, clipped.width, clipped.height);
+}
+
+rect rect::intersect(const rect& other) const noexcept {
+    const int64_t left = std::max(x, other.x);
+    const int64_t top = std::max(y, other.y);
+    const int64_t right = std::min(int64_t(x) + width, int64_t(other.x) + other.width);
+    const int64_t bottom = std::min(int64_t(y) + height, int64_t(other.y) + other.height);
+
+    if (right <= left || bottom <= top) {
+        return {};
+    }
+
+    return { .x = int32_t(left), .y = int32_t(top), .width = int32_t(right - left), .height = int32_t(bottom - top) };
+}
+
+rect rect::unite(const rect& other) const noexcept {
+    if (empty()) { return other; }
+    if (other.empty()) { return *this; }
+
+    const int64_t left = std::min(x, other.x);
+    const int64_t top = std::min(y, other.y);
+    const int64_t right = std::max(int64_t(x) + width, int64_t(other.x) + other.width);
+    const int64_t bottom = std::max(int64_t(y) + height, int64_t(other.y) + other.height);
+
+    return {
+        .x = int32_t(left),
+        .y = int32_t(top),
+        .width = int32_t(std::min<int64_t>(right - left, INT32_MAX)),
+        .height = int32_t(std::min<int64_t>(bottom - top, INT32_MAX)),
+    };
+}
+
+const char* render::isa_to_str(const isa level) {
+    switch (level) {
+        case isa::scalar: return "scalar";
+        case isa::sse2: return "SSE2";
+        case isa::ssse3: return "SSSE3";
+        case isa::avx2: return "AVX2";
+        default: return "Unknown ISA";
+    }
+}
+
+isa render::active_isa() noexcept {
+    return kernels().level;
+}
+
+isa render::force_isa(const isa level) noexcept {
+    kernels() = table_for(std::min(level, detect_isa()));
+    return kernels().level;
+}
+
+void render::fill_solid(const surface_view& dst, const uint32_t colour) {
+    const kernel_table& k = kernels();
+
+    for (uint32_t y = 0; y < dst.height; y++) {
+        k.fill_row(dst.row(y), dst.width, colour);
+    }
+}
+
+void render::fill_gradient(const surface_view& dst, const uint32_t top_left, const uint32_t top_right, const uint32_t bottom_left) {
+    const rect area { .x = 0, .y = 0, .width = static_cast<int32_t>(dst.width), .height = static_cast<int32_t>(dst.height) };
+    fill_gradient(dst, area, dst.width, dst.height, top_left, top_right, bottom_left);
+}
+
+void render::fill_gradient(const surface_view& dst, const rect& area, const uint32_t full_width, const uint32_t full_height, const uint32_t top_left, const uint32_t top_right, const uint32_t bottom_left) {
+    if (dst.width == 0 || dst.height == 0 || full_width == 0 || full_height == 0) { return; }
+
+    const kernel_table& k = kernels();
+
+    gradient_row_state state;
+    int32_t step_y[4];
+
+    for (int c = 0; c < 4; c++) {
+        state.step[c] = ((channel(top_right, c) - channel(top_left, c)) << 16) / static_cast<int32_t>(full_width);
+        step_y[c] = ((channel(bottom_left, c) - channel(top_left, c)) << 16) / static_cast<int32_t>(full_height);
+        state.start[c] = (channel(top_left, c) << 16) + area.x * state.step[c] + area.y * step_y[c];
+    }
+
+    const uint32_t width = std::min<uint32_t>(dst.width, std::max(area.width, 0));
+    const uint32_t height = std::min<uint32_t>(dst.height, std::max(area.height, 0));
+
+    for (uint32_t y = 0; y < height; y++) {
+        k.gradient_row(dst.row(y), width, state);
+
+        for (int c = 0; c < 4; c++) {
+            state.start[c] += step_y[c];
+        }
+    }
+}
+
+void render::copy_rect(const surface_view& dst, const surface_view& src) {
+    const uint32_t width = std::min(dst.width, src.width);
+    const uint32_t height = std::min(dst.height, src.height);
+
+    for (uint32_t y = 0; y < height; y++) {
+        memcpy(dst.row(y), src.row(y), width * sizeof(uint32_t));
+    }
+}
+
+void render::convert_row_24(uint32_t* dst, const uint8_t* src, const size_t count, const order24 order) {
+    const kernel_table& k = kernels();
+
+    if (order == order24::bgr) {
+        k.convert_row_bgr(dst, src, count);
+    } else {
+        k.convert_row_rgb(dst, src, count);
+    }
+}
+
+void render::convert_rect_24(const surface_view& dst, const uint8_t* src, const size_t src_stride, const order24 order) {
+    for (uint32_t y = 0; y < dst.height; y++) {
+        convert_row_24(dst.row(y), src + y * src_stride, dst.width, order);
+    }
+}
+
+void render::premultiply(const surface_view& dst) {
+    const kernel_table& k = kernels();
+
+    for (uint32_t y = 0; y < dst.height; y++) {
+        k.premultiply_row(dst.row(y), dst.width);
+    }
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+    @brief Software pixel kernels for 32-bit ARGB8888 and
+    XRGB8888 surfaces.
+
+    All kernels walk memory row by row. On x86 the SIMD
+    variants are picked once at start-up from the features
+    reported by the CPU, with a scalar fallback everywhere
+    else.
+*/
+namespace render {
+
+    /**
+        @brief An axis-aligned rectangle in surface-local
+        coordinates, using Wayland's signed integers.
+    */
+    struct rect {
+        int32_t x = 0;
+        int32_t y = 0;
+        int32_t width = 0;
+        int32_t height = 0;
+
+        /**
+            @brief Returns a rectangle that contains every
+            other rectangle.
+        */
+        static constexpr rect unbounded() noexcept {
+            return { .x = 0, .y = 0, .width = INT32_MAX, .height = INT32_MAX };
+        }
+
+        bool empty() const noexcept {
+            return width <= 0 || height <= 0;
+        }
+
+        /**
+            @brief Returns the overlap of both rectangles,
+            which is empty if they don't touch.
+        */
+        rect intersect(const rect& other) const noexcept;
+
+        /**
+            @brief Returns the smallest rectangle containing
+            both rectangles. Empty rectangles are ignored.
+        */
+        rect unite(const rect& other) const noexcept;
+
+        bool operator==(const rect& other) const noexcept {
+            return x == other.x && y == other.y && width == other.width && height == other.height;
+        }
+
+        bool operator!=(const rect& other) const noexcept {
+            return !(*this == other);
+        }
+    };
+
+    /**
+        @brief Non-owning view over a block of 32-bit pixels.
+
+        `stride` is measured in pixels, not bytes, so that a
+        sub-rectangle of a larger buffer can be described
+        without copying.
+    */
+    struct surface_view {
+        uint32_t* pixels = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t stride = 0;
+
+        uint32_t* row(const uint32_t y) const noexcept {
+            return pixels + static_cast<size_t>(y) * stride;
+        }
+
+        /**
+            @brief Returns a view over the rectangle
+            [x, x + w) x [y, y + h), clipped to this view.
+        */
+        surface_view sub(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const noexcept;
+
+        surface_view sub(const rect& area) const noexcept;
+    };
+
+    /**
+        @brief Byte order of packed 24-bit source pixels.
+    */
+    enum class order24 {
+        bgr,
+        rgb,
+    };
+
+    /**
+        @brief Instruction set used by the active kernel table.
+    */
+    enum class isa {
+        scalar,
+        sse2,
+        ssse3,
+        avx2,
+    };
+
+    const char* isa_to_str(isa level);
+
+    /**
+        @brief Returns the instruction set the kernels were
+        dispatched to.
+    */
+    isa active_isa() noexcept;
+
+    /**
+        @brief Forces the kernels down to at most @p level.
+        Used to compare variants against each other.
+
+        @returns The level actually selected, which may be
+        lower than @p level if the CPU lacks support.
+    */
+    isa force_isa(isa level) noexcept;
+
+    /**
+        @brief Packs 8-bit channels into a 32-bit ARGB value.
+    */
+    constexpr uint32_t argb(uint8_t a, uint8_t r, uint8_t g, uint8_t b) noexcept {
+        return (uint32_t(a) << 24) | (uint32_t(r) << 16) | (uint32_t(g) << 8) | uint32_t(b);
+    }
+
+    /**
+        @brief Fills every pixel of @p dst with @p colour.
+    */
+    void fill_solid(const surface_view& dst, uint32_t colour);
+
+    /**
+        @brief Fills @p dst with an affine gradient.
+
+        Each channel is interpolated independently: moving
+        right goes from @p top_left towards @p top_right,
+        moving down goes from @p top_left towards
+        @p bottom_left.
+    */
+    void fill_gradient(const surface_view& dst, uint32_t top_left, uint32_t top_right, uint32_t bottom_left);
+
+    /**
+        @brief Fills @p dst with the part of a gradient at
+        @p area, where the whole gradient spans `full_width`
+        x `full_height` pixels.
+
+        Used to draw one tile of a larger gradient. The
+        result matches the same pixels of a full fill
+        exactly.
+    */
+    void fill_gradient(const surface_view& dst, const rect& area, uint32_t full_width, uint32_t full_height, uint32_t top_left, uint32_t top_right, uint32_t bottom_left);
+
+    /**
+        @brief Copies @p src into @p dst. The copied area
+        is the overlap of both views' sizes.
+
+        The views must not overlap in memory.
+    */
+    void copy_rect(const surface_view& dst, const surface_view& src);
+
+    /**
+        @brief Expands @p count packed 24-bit pixels into
+        opaque 32-bit pixels.
+
+        The output is valid for both ARGB8888 and XRGB8888
+        since the alpha byte is always set to 0xFF.
+    */
+    void convert_row_24(uint32_t* dst, const uint8_t* src, size_t count, order24 order);
+
+    /**
+        @brief Converts a block of packed 24-bit rows into
+        @p dst. @p src_stride is in bytes and may include
+        row padding.
+    */
+    void convert_rect_24(const surface_view& dst, const uint8_t* src, size_t src_stride, order24 order);
+
+    /**
+        @brief Converts straight alpha to premultiplied
+        alpha in place.
+    */
+    void premultiply(const surface_view& dst);
+}
@@ -0,0 +1,65 @@
+#include "region.h"
+
+using namespace render;
+
+region& region::add(const rect& area) {
+    if (!area.empty()) {
+        operations.push_back({ .area = area, .add = true });
+    }
+
+    return *this;
+}
+
+region& region::subtract(const rect& area) {
+    if (!area.empty() && !operations.empty()) {
+        operations.push_back({ .area = area, .add = false });
+    }
+
+    return *this;
+}
+
+bool region::empty() const noexcept {
+    return operations.empty();
+}
+
+void region::apply(wl_region& target) const {
+    for (const operation& operation : operations) {
+        const rect& area = operation.area;
+
+        if (operation.add) {
+            target.add(area.x, area.y, area.width, area.height);
+        } else {
+            target.subtract(area.x, area.y, area.width, area.height);
+        }
+    }
+}
+
+bool region::operator==(const region& other) const noexcept {
+    return operations == other.operations;
+}
+
+bool region::operator!=(const region& other) const noexcept {
+    return !(*this == other);
+}
+
+opaque_region_sync::opaque_region_sync(const wl_fd_t socket, wl_compositor& compositor, wl_surface& surface) : socket(socket), compositor(compositor), surface(surface) {}
+
+bool opaque_region_sync::update(const region& opaque) {
+    if (sent && opaque == current) { return false; }
+
+    if (opaque.empty()) {
+        surface.set_opaque_region(nullptr);
+    } else {
+        // The surface keeps a copy, so the region can go right away.
+        wl_region* target = compositor.create_region(socket);
+        opaque.apply(*target);
+        surface.set_opaque_region(target);
+        target->destroy();
+        delete target;
+    }
+
+    current = opaque;
+    sent = true;
+
+    return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "pixel.h"
+#include "../objects/compositor.h"
+
+#include <vector>
+
+namespace render {
+
+    /**
+        @brief Rectangles added and subtracted in order,
+        the same way a wl_region is built.
+    */
+    class region {
+        struct operation {
+            rect area;
+            bool add;
+
+            bool operator==(const operation& other) const noexcept {
+                return area == other.area && add == other.add;
+            }
+        };
+
+        std::vector<operation> operations;
+
+        public:
+
+        region& add(const rect& area);
+        region& subtract(const rect& area);
+
+        bool empty() const noexcept;
+
+        /**
+            @brief Replays the operations onto @p target.
+        */
+        void apply(wl_region& target) const;
+
+        bool operator==(const region& other) const noexcept;
+        bool operator!=(const region& other) const noexcept;
+    };
+
+    /**
+        @brief Keeps a surface's opaque region in sync with
+        the parts the renderer draws fully opaque.
+
+        A new wl_region is only sent when the region
+        changes, so steady frames cost nothing extra.
+    */
+    class opaque_region_sync {
+        wl_fd_t socket;
+        wl_compositor& compositor;
+        wl_surface& surface;
+
+        region current;
+        bool sent = false;
+
+        public:
+
+        opaque_region_sync(wl_fd_t socket, wl_compositor& compositor, wl_surface& surface);
+
+        /**
+            @brief Sets @p opaque, in surface coordinates, as
+            the opaque region if it changed. Call before the
+            commit it applies to.
+
+            @returns `true` if a request was sent.
+        */
+        bool update(const region& opaque);
+    };
+}
@@ -0,0 +1,428 @@
+#include "scale.h"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RENDER_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace render;
+
+namespace {
+
+    /**
+        @brief Maps destination columns (or rows)
+        [offset, offset + count) onto the source for bilinear
+        filtering, in 8-bit sub-pixel precision.
+
+        Indices are relative to `origin`, the first source
+        pixel used, so scratch rows only need to cover the
+        span the range actually reads.
+    */
+    struct bilinear_map {
+        std::vector<int32_t> first;
+        std::vector<int32_t> second;
+        std::vector<uint32_t> weight;
+        int32_t origin = 0;
+        int32_t span = 0;
+
+        bilinear_map(const uint32_t src_size, const uint32_t dst_size, const uint32_t offset, const uint32_t count) : first(count), second(count), weight(count) {
+            for (uint32_t i = 0; i < count; i++) {
+                // Centre-aligned: (i + 0.5) * src / dst - 0.5, in 24.8 fixed point.
+                const int64_t pos = ((2 * int64_t(offset + i) + 1) * src_size * 256) / (2 * int64_t(dst_size)) - 128;
+                const int32_t clamped = static_cast<int32_t>(std::max<int64_t>(pos, 0));
+                const int32_t index = std::min<int32_t>(clamped >> 8, src_size - 1);
+
+                first[i] = index;
+                second[i] = std::min<int32_t>(index + 1, src_size - 1);
+
+                // Both 16-bit halves hold the weight, ready to be unpacked into channel lanes.
+                const uint32_t w = clamped & 0xFF;
+                weight[i] = w | (w << 16);
+            }
+
+            if (count == 0) { return; }
+
+            origin = first.front();
+            span = second.back() - origin + 1;
+
+            for (uint32_t i = 0; i < count; i++) {
+                first[i] -= origin;
+                second[i] -= origin;
+            }
+        }
+    };
+
+    /**
+        @brief Maps destination columns (or rows)
+        [offset, offset + count) onto the span of source
+        pixels they cover, [begin, end).
+    */
+    struct box_map {
+        std::vector<uint32_t> begin;
+        std::vector<uint32_t> end;
+
+        box_map(const uint32_t src_size, const uint32_t dst_size, const uint32_t offset, const uint32_t count) : begin(count), end(count) {
+            for (uint32_t i = 0; i < count; i++) {
+                const uint64_t at = offset + i;
+                const uint32_t b = std::min<uint64_t>(at * src_size / dst_size, src_size - 1);
+                const uint32_t e = (at + 1) * src_size / dst_size;
+                begin[i] = b;
+                end[i] = std::max(e, b + 1);
+            }
+        }
+    };
+
+    inline uint32_t lerp_pixel(const uint32_t a, const uint32_t b, const uint32_t w) {
+        uint32_t out = 0;
+
+        for (int c = 0; c < 32; c += 8) {
+            const uint32_t ca = (a >> c) & 0xFF;
+            const uint32_t cb = (b >> c) & 0xFF;
+            out |= ((ca * (256 - w) + cb * w) >> 8) << c;
+        }
+
+        return out;
+    }
+
+    inline uint32_t nearest_index(const uint32_t i, const uint32_t src_size, const uint32_t dst_size) {
+        return std::min<uint64_t>((2 * uint64_t(i) + 1) * src_size / (2 * uint64_t(dst_size)), src_size - 1);
+    }
+
+    /** SCALAR */
+
+    void nearest_row_scalar(uint32_t* dst, const uint32_t* src, const int32_t* x_map, const uint32_t count) {
+        for (uint32_t x = 0; x < count; x++) {
+            dst[x] = src[x_map[x]];
+        }
+    }
+
+    void lerp_rows_scalar(uint32_t* dst, const uint32_t* a, const uint32_t* b, const uint32_t w, const uint32_t count) {
+        for (uint32_t x = 0; x < count; x++) {
+            dst[x] = lerp_pixel(a[x], b[x], w);
+        }
+    }
+
+    void bilinear_row_scalar(uint32_t* dst, const uint32_t* src, const bilinear_map& map, const uint32_t first, const uint32_t count) {
+        for (uint32_t x = first; x < count; x++) {
+            dst[x] = lerp_pixel(src[map.first[x]], src[map.second[x]], map.weight[x] & 0xFF);
+        }
+    }
+
+    void accumulate_row_scalar(uint32_t* acc, const uint32_t* src, const uint32_t count) {
+        for (uint32_t x = 0; x < count; x++) {
+            for (int c = 0; c < 4; c++) {
+                acc[x * 4 + c] += (src[x] >> (c * 8)) & 0xFF;
+            }
+        }
+    }
+
+#ifdef RENDER_X86
+
+    /** SSE2 */
+
+    __attribute__((target("sse2")))
+    inline __m128i lerp_epi16_sse2(const __m128i a, const __m128i b, const __m128i w) {
+        const __m128i iw = _mm_sub_epi16(_mm_set1_epi16(256), w);
+        return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(a, iw), _mm_mullo_epi16(b, w)), 8);
+    }
+
+    __attribute__((target("sse2")))
+    void lerp_rows_sse2(uint32_t* dst, const uint32_t* a, const uint32_t* b, const uint32_t w, const uint32_t count) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i weight = _mm_set1_epi16(static_cast<short>(w));
+        uint32_t x = 0;
+
+        for (; x + 4 <= count; x += 4) {
+            const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x));
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x));
+            const __m128i lo = lerp_epi16_sse2(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero), weight);
+            const __m128i hi = lerp_epi16_sse2(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero), weight);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(lo, hi));
+        }
+
+        lerp_rows_scalar(dst + x, a + x, b + x, w, count - x);
+    }
+
+    __attribute__((target("sse2")))
+    void bilinear_row_sse2(uint32_t* dst, const uint32_t* src, const bilinear_map& map, const uint32_t count) {
+        const __m128i zero = _mm_setzero_si128();
+        uint32_t x = 0;
+
+        for (; x + 4 <= count; x += 4) {
+            const int32_t* f = map.first.data() + x;
+            const int32_t* s = map.second.data() + x;
+
+            const __m128i p0 = _mm_setr_epi32(src[f[0]], src[f[1]], src[f[2]], src[f[3]]);
+            const __m128i p1 = _mm_setr_epi32(src[s[0]], src[s[1]], src[s[2]], src[s[3]]);
+            const __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(map.weight.data() + x));
+
+            const __m128i lo = lerp_epi16_sse2(_mm_unpacklo_epi8(p0, zero), _mm_unpacklo_epi8(p1, zero), _mm_unpacklo_epi32(w, w));
+            const __m128i hi = lerp_epi16_sse2(_mm_unpackhi_epi8(p0, zero), _mm_unpackhi_epi8(p1, zero), _mm_unpackhi_epi32(w, w));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(lo, hi));
+        }
+
+        bilinear_row_scalar(dst, src, map, x, count);
+    }
+
+    __attribute__((target("sse2")))
+    void accumulate_row_sse2(uint32_t* acc, const uint32_t* src, const uint32_t count) {
+        const __m128i zero = _mm_setzero_si128();
+        uint32_t x = 0;
+
+        for (; x + 4 <= count; x += 4) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+            const __m128i lo = _mm_unpacklo_epi8(v, zero);
+            const __m128i hi = _mm_unpackhi_epi8(v, zero);
+            const __m128i parts[4] = {
+                _mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+                _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero),
+            };
+
+            for (int p = 0; p < 4; p++) {
+                __m128i* slot = reinterpret_cast<__m128i*>(acc + (x + p) * 4);
+                _mm_storeu_si128(slot, _mm_add_epi32(_mm_loadu_si128(slot), parts[p]));
+            }
+        }
+
+        accumulate_row_scalar(acc + x * 4, src + x, count - x);
+    }
+
+    /** AVX2 */
+
+    __attribute__((target("avx2")))
+    void nearest_row_avx2(uint32_t* dst, const uint32_t* src, const int32_t* x_map, const uint32_t count) {
+        uint32_t x = 0;
+
+        for (; x + 8 <= count; x += 8) {
+            const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x_map + x));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_i32gather_epi32(reinterpret_cast<const int*>(src), index, 4));
+        }
+
+        nearest_row_scalar(dst + x, src, x_map + x, count - x);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i lerp_epi16_avx2(const __m256i a, const __m256i b, const __m256i w) {
+        const __m256i iw = _mm256_sub_epi16(_mm256_set1_epi16(256), w);
+        return _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(a, iw), _mm256_mullo_epi16(b, w)), 8);
+    }
+
+    __attribute__((target("avx2")))
+    void lerp_rows_avx2(uint32_t* dst, const uint32_t* a, const uint32_t* b, const uint32_t w, const uint32_t count) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i weight = _mm256_set1_epi16(static_cast<short>(w));
+        uint32_t x = 0;
+
+        for (; x + 8 <= count; x += 8) {
+            const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + x));
+            const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + x));
+            const __m256i lo = lerp_epi16_avx2(_mm256_unpacklo_epi8(va, zero), _mm256_unpacklo_epi8(vb, zero), weight);
+            const __m256i hi = lerp_epi16_avx2(_mm256_unpackhi_epi8(va, zero), _mm256_unpackhi_epi8(vb, zero), weight);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_packus_epi16(lo, hi));
+        }
+
+        lerp_rows_sse2(dst + x, a + x, b + x, w, count - x);
+    }
+
+    /**
+        @brief Unpacking within 128-bit lanes puts pixels
+        (0, 1, 4, 5) in the low half and (2, 3, 6, 7) in the
+        high half. Unpacking the weights the same way keeps
+        them lined up with their pixels.
+    */
+    __attribute__((target("avx2")))
+    void bilinear_row_avx2(uint32_t* dst, const uint32_t* src, const bilinear_map& map, const uint32_t count) {
+        const __m256i zero = _mm256_setzero_si256();
+        const int* base = reinterpret_cast<const int*>(src);
+        uint32_t x = 0;
+
+        for (; x + 8 <= count; x += 8) {
+            const __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(map.first.data() + x));
+            const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(map.second.data() + x));
+            const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(map.weight.data() + x));
+
+            const __m256i p0 = _mm256_i32gather_epi32(base, f, 4);
+            const __m256i p1 = _mm256_i32gather_epi32(base, s, 4);
+
+            const __m256i lo = lerp_epi16_avx2(_mm256_unpacklo_epi8(p0, zero), _mm256_unpacklo_epi8(p1, zero), _mm256_unpacklo_epi32(w, w));
+            const __m256i hi = lerp_epi16_avx2(_mm256_unpackhi_epi8(p0, zero), _mm256_unpackhi_epi8(p1, zero), _mm256_unpackhi_epi32(w, w));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_packus_epi16(lo, hi));
+        }
+
+        bilinear_row_scalar(dst, src, map, x, count);
+    }
+
+    __attribute__((target("avx2")))
+    void accumulate_row_avx2(uint32_t* acc, const uint32_t* src, const uint32_t count) {
+        uint32_t x = 0;
+
+        for (; x + 2 <= count; x += 2) {
+            const __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + x)));
+            __m256i* slot = reinterpret_cast<__m256i*>(acc + x * 4);
+            _mm256_storeu_si256(slot, _mm256_add_epi32(_mm256_loadu_si256(slot), v));
+        }
+
+        accumulate_row_scalar(acc + x * 4, src + x, count - x);
+    }
+
+#endif
+
+    void nearest_row(uint32_t* dst, const uint32_t* src, const int32_t* x_map, const uint32_t count) {
+#ifdef RENDER_X86
+        if (active_isa() >= isa::avx2) { return nearest_row_avx2(dst, src, x_map, count); }
+#endif
+        nearest_row_scalar(dst, src, x_map, count);
+    }
+
+    void lerp_rows(uint32_t* dst, const uint32_t* a, const uint32_t* b, const uint32_t w, const uint32_t count) {
+#ifdef RENDER_X86
+        if (active_isa() >= isa::avx2) { return lerp_rows_avx2(dst, a, b, w, count); }
+        if (active_isa() >= isa::sse2) { return lerp_rows_sse2(dst, a, b, w, count); }
+#endif
+        lerp_rows_scalar(dst, a, b, w, count);
+    }
+
+    void bilinear_row(uint32_t* dst, const uint32_t* src, const bilinear_map& map, const uint32_t count) {
+#ifdef RENDER_X86
+        if (active_isa() >= isa::avx2) { return bilinear_row_avx2(dst, src, map, count); }
+        if (active_isa() >= isa::sse2) { return bilinear_row_sse2(dst, src, map, count); }
+#endif
+        bilinear_row_scalar(dst, src, map, 0, count);
+    }
+
+    void accumulate_row(uint32_t* acc, const uint32_t* src, const uint32_t count) {
+#ifdef RENDER_X86
+        if (active_isa() >= isa::avx2) { return accumulate_row_avx2(acc, src, count); }
+        if (active_isa() >= isa::sse2) { return accumulate_row_sse2(acc, src, count); }
+#endif
+        accumulate_row_scalar(acc, src, count);
+    }
+
+    /**
+        @brief Scales into the part of @p dst at @p clip,
+        which must lie inside @p dst. Every function below
+        only reads the source pixels that part needs.
+    */
+    void scale_nearest(const surface_view& dst, const surface_view& src, const rect& clip) {
+        std::vector<int32_t> x_map(clip.width);
+
+        for (int32_t x = 0; x < clip.width; x++) {
+            x_map[x] = nearest_index(clip.x + x, src.width, dst.width);
+        }
+
+        for (int32_t y = clip.y; y < clip.y + clip.height; y++) {
+            nearest_row(dst.row(y) + clip.x, src.row(nearest_index(y, src.height, dst.height)), x_map.data(), clip.width);
+        }
+    }
+
+    /**
+        @brief Blends vertically into a scratch row, then
+        horizontally into the destination.
+    */
+    void scale_bilinear(const surface_view& dst, const surface_view& src, const rect& clip) {
+        const bilinear_map x_map(src.width, dst.width, clip.x, clip.width);
+        const bilinear_map y_map(src.height, dst.height, clip.y, clip.height);
+        std::vector<uint32_t> blended(x_map.span);
+
+        for (int32_t y = 0; y < clip.height; y++) {
+            const uint32_t* top = src.row(y_map.origin + y_map.first[y]) + x_map.origin;
+            const uint32_t* bottom = src.row(y_map.origin + y_map.second[y]) + x_map.origin;
+
+            lerp_rows(blended.data(), top, bottom, y_map.weight[y] & 0xFF, x_map.span);
+            bilinear_row(dst.row(clip.y + y) + clip.x, blended.data(), x_map, clip.width);
+        }
+    }
+
+    /**
+        @brief Sums the covered source rows per channel,
+        then averages the covered columns of that sum.
+    */
+    void scale_box(const surface_view& dst, const surface_view& src, const rect& clip) {
+        const box_map x_map(src.width, dst.width, clip.x, clip.width);
+        const box_map y_map(src.height, dst.height, clip.y, clip.height);
+
+        const uint32_t origin = x_map.begin.front();
+        const uint32_t span = x_map.end.back() - origin;
+        std::vector<uint32_t> acc(span * 4);
+
+        for (int32_t y = 0; y < clip.height; y++) {
+            std::fill(acc.begin(), acc.end(), 0);
+
+            for (uint32_t sy = y_map.begin[y]; sy < y_map.end[y]; sy++) {
+                accumulate_row(acc.data(), src.row(sy) + origin, span);
+            }
+
+            uint32_t* out = dst.row(clip.y + y) + clip.x;
+            const uint32_t rows = y_map.end[y] - y_map.begin[y];
+
+            for (int32_t x = 0; x < clip.width; x++) {
+                uint32_t sum[4] = {};
+
+                for (uint32_t sx = x_map.begin[x] - origin; sx < x_map.end[x] - origin; sx++) {
+                    for (int c = 0; c < 4; c++) {
+                        sum[c] += acc[sx * 4 + c];
+                    }
+                }
+
+                const uint32_t area = rows * (x_map.end[x] - x_map.begin[x]);
+                uint32_t pixel = 0;
+
+                for (int c = 0; c < 4; c++) {
+                    pixel |= ((sum[c] + area / 2) / area) << (c * 8);
+                }
+
+                out[x] = pixel;
+            }
+        }
+    }
+}
+
+filter render::pick_filter(const uint32_t src_width, const uint32_t src_height, const uint32_t dst_width, const uint32_t dst_height) noexcept {
+    if (src_width == dst_width && src_height == dst_height) {
+        return filter::nearest;
+    }
+
+    if (dst_width < src_width && dst_height < src_height) {
+        return filter::box;
+    }
+
+    return filter::bilinear;
+}
+
+void render::scale(const surface_view& dst, const surface_view& src, const filter filter, const rect& clip) {
+    if (src.width == 0 || src.height == 0) { return; }
+
+    const rect area = clip.intersect({ .x = 0, .y = 0, .width = static_cast<int32_t>(dst.width), .height = static_cast<int32_t>(dst.height) });
+
+    if (area.empty()) { return; }
+
+    switch (filter) {
+        case filter::nearest: return scale_nearest(dst, src, area);
+        case filter::bilinear: return scale_bilinear(dst, src, area);
+        case filter::box: return scale_box(dst, src, area);
+    }
+}
+
+rect render::fit(const uint32_t dst_width, const uint32_t dst_height, const uint32_t src_width, const uint32_t src_height) noexcept {
+    if (src_width == 0 || src_height == 0) {
+        return {};
+    }
+
+    uint32_t width = dst_width;
+    uint32_t height = static_cast<uint64_t>(dst_width) * src_height / src_width;
+
+    if (height > dst_height) {
+        height = dst_height;
+        width = static_cast<uint64_t>(dst_height) * src_width / src_height;
+    }
+
+    return {
+        .x = static_cast<int32_t>((dst_width - width) / 2),
+        .y = static_cast<int32_t>((dst_height - height) / 2),
+        .width = static_cast<int32_t>(width),
+        .height = static_cast<int32_t>(height),
+    };
+}
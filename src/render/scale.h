@@ -0,0 +1,41 @@
+#pragma once
+
+#include "pixel.h"
+
+#include <cstdint>
+
+namespace render {
+
+    enum class filter {
+        /** Picks the source pixel under each destination pixel centre. */
+        nearest,
+        /** Blends the four nearest source pixels. Best for upscaling. */
+        bilinear,
+        /** Averages every source pixel covered by a destination pixel. Best for downscaling. */
+        box,
+    };
+
+    /**
+        @brief Returns the filter that gives the best result
+        for scaling @p src_size pixels to @p dst_size pixels.
+    */
+    filter pick_filter(uint32_t src_width, uint32_t src_height, uint32_t dst_width, uint32_t dst_height) noexcept;
+
+    /**
+        @brief Scales all of @p src to fill all of @p dst.
+
+        Both views may be sub-rectangles of larger surfaces.
+        Only the pixels of @p dst inside @p clip are written,
+        and every pixel is computed independently of the
+        others, so disjoint row bands or tiles can be scaled
+        on separate threads.
+    */
+    void scale(const surface_view& dst, const surface_view& src, filter filter, const rect& clip = rect::unbounded());
+
+    /**
+        @brief Returns the largest rectangle with the aspect
+        ratio of @p src_width x @p src_height that fits
+        centred in a @p dst_width x @p dst_height surface.
+    */
+    rect fit(uint32_t dst_width, uint32_t dst_height, uint32_t src_width, uint32_t src_height) noexcept;
+}
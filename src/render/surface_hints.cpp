@@ -0,0 +1,38 @@
+#include "surface_hints.h"
+
+using namespace render;
+
+surface_hints::surface_hints(wl_surface& surface, wp::tearing_control_manager* const tearing_manager, wp::content_type_manager* const content_type_manager) : surface(surface) {
+    if (tearing_manager) {
+        tearing = &tearing_manager->get_tearing_control(surface);
+    }
+
+    if (content_type_manager) {
+        type = &content_type_manager->get_surface_content_type(surface);
+    }
+}
+
+bool surface_hints::set_async(const bool async) {
+    if (!tearing) { return false; }
+
+    if (async != this->async) {
+        using hint = wp::tearing_control::presentation_hint;
+        tearing->set_presentation_hint(async ? hint::async : hint::vsync);
+        surface.mark_dirty();
+        this->async = async;
+    }
+
+    return true;
+}
+
+bool surface_hints::allows_tearing() const noexcept {
+    return async;
+}
+
+bool surface_hints::set_content_type(const wp::content_type::type type) {
+    if (!this->type) { return false; }
+
+    this->type->set_content_type(type);
+    surface.mark_dirty();
+    return true;
+}
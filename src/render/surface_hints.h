@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../objects/content_type.h"
+#include "../objects/tearing_control.h"
+
+namespace render {
+
+    /**
+        @brief Presentation hints of one surface: tearing
+        and content type.
+
+        Hints take effect on the surface's next commit,
+        which they flag with `mark_dirty`. Either manager
+        may be missing, in which case its hints are ignored
+        and the setters return `false`.
+    */
+    class surface_hints {
+        wl_surface& surface;
+
+        wp::tearing_control* tearing = nullptr;
+        wp::content_type* type = nullptr;
+
+        bool async = false;
+
+        public:
+
+        surface_hints(wl_surface& surface, wp::tearing_control_manager* tearing_manager, wp::content_type_manager* content_type_manager);
+
+        surface_hints(const surface_hints&) = delete;
+        surface_hints& operator=(const surface_hints&) = delete;
+
+        /**
+            @brief Asks for content to be shown as soon as it
+            is committed, even if that tears.
+
+            @returns `false` if tearing control isn't
+            supported.
+        */
+        bool set_async(bool async);
+
+        /**
+            @brief Returns `true` if async presentation was
+            requested and can be honoured.
+        */
+        bool allows_tearing() const noexcept;
+
+        /**
+            @returns `false` if content types aren't
+            supported.
+        */
+        bool set_content_type(wp::content_type::type type);
+    };
+}
@@ -0,0 +1,107 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+using namespace render;
+
+thread_pool::thread_pool(unsigned threads) {
+    threads = std::max(threads, 1u);
+
+    // Queue 0 belongs to the thread calling wait().
+    for (unsigned i = 0; i < threads; i++) {
+        queues.push_back(std::make_unique<job_queue>());
+    }
+
+    for (unsigned i = 1; i < threads; i++) {
+        workers.emplace_back(&thread_pool::worker_main, this, i);
+    }
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard lock(sleep_mutex);
+        stopping = true;
+    }
+
+    work_available.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+unsigned thread_pool::size() const noexcept {
+    return queues.size();
+}
+
+void thread_pool::submit(job job) {
+    job_queue& queue = *queues[next_queue];
+    next_queue = (next_queue + 1) % queues.size();
+
+    pending++;
+
+    {
+        std::lock_guard lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+        queued++;
+    }
+
+    // Sleeping workers check `queued` under this lock, so taking it stops the wakeup being lost.
+    { std::lock_guard lock(sleep_mutex); }
+
+    work_available.notify_one();
+}
+
+bool thread_pool::run_one(const size_t home) {
+    job job;
+
+    for (size_t i = 0; i < queues.size() && !job; i++) {
+        job_queue& queue = *queues[(home + i) % queues.size()];
+        std::lock_guard lock(queue.mutex);
+
+        if (queue.jobs.empty()) { continue; }
+
+        if (i == 0) {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        } else {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        }
+
+        queued--;
+    }
+
+    if (!job) {
+        return false;
+    }
+
+    job();
+
+    if (--pending == 0) {
+        std::lock_guard lock(sleep_mutex);
+        work_done.notify_all();
+    }
+
+    return true;
+}
+
+void thread_pool::worker_main(const size_t home) {
+    while (true) {
+        if (run_one(home)) { continue; }
+
+        std::unique_lock lock(sleep_mutex);
+        work_available.wait(lock, [this]() { return stopping || queued > 0; });
+
+        if (stopping) { return; }
+    }
+}
+
+void thread_pool::wait() {
+    while (pending > 0) {
+        if (run_one(0)) { continue; }
+
+        std::unique_lock lock(sleep_mutex);
+        work_done.wait(lock, [this]() { return pending == 0 || queued > 0; });
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace render {
+
+    /**
+        @brief A work-stealing pool of render threads.
+
+        Every worker owns a queue. Jobs are spread across
+        the queues as they are submitted; a worker takes jobs
+        from the front of its own queue and, once that is
+        empty, steals from the back of the others.
+
+        The thread calling `wait` takes part in the work, so
+        a pool of size N runs N - 1 background threads.
+    */
+    class thread_pool {
+        public:
+
+        using job = std::function<void()>;
+
+        private:
+
+        struct job_queue {
+            std::mutex mutex;
+            std::deque<job> jobs;
+        };
+
+        std::vector<std::unique_ptr<job_queue>> queues;
+        std::vector<std::thread> workers;
+
+        /** Jobs in the queues. Changed under the owning queue's lock. */
+        std::atomic<size_t> queued = 0;
+        /** Jobs submitted but not yet finished. */
+        std::atomic<size_t> pending = 0;
+        size_t next_queue = 0;
+
+        std::mutex sleep_mutex;
+        std::condition_variable work_available;
+        std::condition_variable work_done;
+        bool stopping = false;
+
+        /**
+            @brief Runs one job, preferring queue @p home.
+
+            @returns `false` if every queue was empty.
+        */
+        bool run_one(size_t home);
+
+        void worker_main(size_t home);
+
+        public:
+
+        /**
+            @param threads Total number of threads doing work,
+            including the one that calls `wait`. Defaults to
+            the number of hardware threads.
+        */
+        explicit thread_pool(unsigned threads = std::thread::hardware_concurrency());
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        ~thread_pool();
+
+        /**
+            @brief Returns the number of threads doing work,
+            including the caller of `wait`.
+        */
+        unsigned size() const noexcept;
+
+        /**
+            @brief Queues @p job to be run by any thread.
+
+            Must only be called from one thread at a time.
+        */
+        void submit(job job);
+
+        /**
+            @brief Runs queued jobs on the calling thread until
+            every submitted job has finished.
+        */
+        void wait();
+    };
+}
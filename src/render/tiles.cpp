@@ -0,0 +1,86 @@
+#include "tiles.h"
+
+#include <algorithm>
+
+using namespace render;
+
+tile_renderer::tile_renderer(thread_pool& pool) : pool(pool) {}
+
+void tile_renderer::resize(const uint32_t width, const uint32_t height) {
+    if (width == this->width && height == this->height) { return; }
+
+    this->width = width;
+    this->height = height;
+    columns = (width + TILE_SIZE - 1) / TILE_SIZE;
+    rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+    dirty.assign(static_cast<size_t>(columns) * rows, 1);
+}
+
+void tile_renderer::damage(const rect& area) {
+    const rect clipped = area.intersect({ .x = 0, .y = 0, .width = static_cast<int32_t>(width), .height = static_cast<int32_t>(height) });
+
+    if (clipped.empty()) { return; }
+
+    const uint32_t first_column = clipped.x / TILE_SIZE;
+    const uint32_t last_column = (clipped.x + clipped.width - 1) / TILE_SIZE;
+    const uint32_t first_row = clipped.y / TILE_SIZE;
+    const uint32_t last_row = (clipped.y + clipped.height - 1) / TILE_SIZE;
+
+    for (uint32_t row = first_row; row <= last_row; row++) {
+        std::fill(dirty.begin() + row * columns + first_column, dirty.begin() + row * columns + last_column + 1, 1);
+    }
+}
+
+void tile_renderer::damage_all() {
+    std::fill(dirty.begin(), dirty.end(), 1);
+}
+
+rect tile_renderer::damage_bounds() const noexcept {
+    rect bounds;
+
+    for (uint32_t row = 0; row < rows; row++) {
+        for (uint32_t column = 0; column < columns; column++) {
+            if (!dirty[row * columns + column]) { continue; }
+
+            bounds = bounds.unite({
+                .x = static_cast<int32_t>(column * TILE_SIZE),
+                .y = static_cast<int32_t>(row * TILE_SIZE),
+                .width = static_cast<int32_t>(std::min(TILE_SIZE, width - column * TILE_SIZE)),
+                .height = static_cast<int32_t>(std::min(TILE_SIZE, height - row * TILE_SIZE)),
+            });
+        }
+    }
+
+    return bounds;
+}
+
+uint32_t tile_renderer::render(const surface_view& target, const draw_fn& draw) {
+    uint32_t drawn = 0;
+
+    for (uint32_t row = 0; row < rows; row++) {
+        for (uint32_t column = 0; column < columns; column++) {
+            uint8_t& tile_dirty = dirty[row * columns + column];
+
+            if (!tile_dirty) { continue; }
+
+            tile_dirty = 0;
+            drawn++;
+
+            const rect area {
+                .x = static_cast<int32_t>(column * TILE_SIZE),
+                .y = static_cast<int32_t>(row * TILE_SIZE),
+                .width = static_cast<int32_t>(std::min(TILE_SIZE, width - column * TILE_SIZE)),
+                .height = static_cast<int32_t>(std::min(TILE_SIZE, height - row * TILE_SIZE)),
+            };
+
+            pool.submit([&target, &draw, area]() {
+                draw(target.sub(area), area);
+            });
+        }
+    }
+
+    pool.wait();
+
+    return drawn;
+}
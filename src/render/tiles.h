@@ -0,0 +1,79 @@
+#pragma once
+
+#include "pixel.h"
+#include "thread_pool.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace render {
+
+    /**
+        @brief Splits a surface into square tiles and renders
+        the damaged ones in parallel.
+
+        A 64x64 tile of ARGB8888 is 16KiB, so a tile and
+        the source data it reads stay within a core's L2
+        cache while it is drawn.
+    */
+    class tile_renderer {
+        public:
+
+        static constexpr uint32_t TILE_SIZE = 64;
+
+        /**
+            @brief Draws one tile. @p tile views the tile's
+            pixels and @p area is where the tile sits in the
+            whole surface.
+        */
+        using draw_fn = std::function<void(const surface_view& tile, const rect& area)>;
+
+        private:
+
+        thread_pool& pool;
+
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t columns = 0;
+        uint32_t rows = 0;
+
+        std::vector<uint8_t> dirty;
+
+        public:
+
+        explicit tile_renderer(thread_pool& pool);
+
+        /**
+            @brief Sets the surface size. Every tile is
+            damaged afterwards, unless the size is unchanged,
+            in which case this does nothing.
+        */
+        void resize(uint32_t width, uint32_t height);
+
+        /**
+            @brief Marks every tile touching @p area as
+            needing a redraw.
+        */
+        void damage(const rect& area);
+
+        void damage_all();
+
+        /**
+            @brief Returns the bounding box of all damaged
+            tiles, which is empty if nothing is damaged.
+        */
+        rect damage_bounds() const noexcept;
+
+        /**
+            @brief Draws every damaged tile of @p target on
+            the pool, then clears the damage.
+
+            Returns once every tile has been drawn, so the
+            buffer is safe to attach and commit afterwards.
+
+            @returns The number of tiles drawn.
+        */
+        uint32_t render(const surface_view& target, const draw_fn& draw);
+    };
+}
@@ -1,23 +1,257 @@
 #pragma once
 
-enum class Format {
+#include <cstddef>
+#include <cstdint>
+
+/**
+    @brief Builds a DRM fourcc code from its four
+    characters, as in drm_fourcc.h.
+*/
+constexpr uint32_t fourcc(const char a, const char b, const char c, const char d) {
+    return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+}
+
+/**
+    @brief wl_shm pixel formats.
+
+    Apart from ARGB8888 and XRGB8888, which wl_shm gives
+    the codes 0 and 1, every value is the DRM fourcc code
+    of the format. Channels are listed from the most to the
+    least significant bits of a little-endian pixel.
+*/
+enum class Format : uint32_t {
     ARGB8888 = 0,
     XRGB8888 = 1,
-    C8 = 0x20203843,
-    RGB332 = 0x38424752,
-    BGR233 = 0x38524742,
-    XRGB4444 = 0x32315258,
-    XBGR4444 = 0x32314258,
+
+    C8 = fourcc('C', '8', ' ', ' '),
+    R8 = fourcc('R', '8', ' ', ' '),
+    R16 = fourcc('R', '1', '6', ' '),
+    RG88 = fourcc('R', 'G', '8', '8'),
+    GR88 = fourcc('G', 'R', '8', '8'),
+    RG1616 = fourcc('R', 'G', '3', '2'),
+    GR1616 = fourcc('G', 'R', '3', '2'),
+
+    RGB332 = fourcc('R', 'G', 'B', '8'),
+    BGR233 = fourcc('B', 'G', 'R', '8'),
+
+    XRGB4444 = fourcc('X', 'R', '1', '2'),
+    XBGR4444 = fourcc('X', 'B', '1', '2'),
+    RGBX4444 = fourcc('R', 'X', '1', '2'),
+    BGRX4444 = fourcc('B', 'X', '1', '2'),
+    ARGB4444 = fourcc('A', 'R', '1', '2'),
+    ABGR4444 = fourcc('A', 'B', '1', '2'),
+    RGBA4444 = fourcc('R', 'A', '1', '2'),
+    BGRA4444 = fourcc('B', 'A', '1', '2'),
+
+    XRGB1555 = fourcc('X', 'R', '1', '5'),
+    XBGR1555 = fourcc('X', 'B', '1', '5'),
+    RGBX5551 = fourcc('R', 'X', '1', '5'),
+    BGRX5551 = fourcc('B', 'X', '1', '5'),
+    ARGB1555 = fourcc('A', 'R', '1', '5'),
+    ABGR1555 = fourcc('A', 'B', '1', '5'),
+    RGBA5551 = fourcc('R', 'A', '1', '5'),
+    BGRA5551 = fourcc('B', 'A', '1', '5'),
+
+    RGB565 = fourcc('R', 'G', '1', '6'),
+    BGR565 = fourcc('B', 'G', '1', '6'),
+
+    RGB888 = fourcc('R', 'G', '2', '4'),
+    BGR888 = fourcc('B', 'G', '2', '4'),
+
+    XBGR8888 = fourcc('X', 'B', '2', '4'),
+    RGBX8888 = fourcc('R', 'X', '2', '4'),
+    BGRX8888 = fourcc('B', 'X', '2', '4'),
+    ABGR8888 = fourcc('A', 'B', '2', '4'),
+    RGBA8888 = fourcc('R', 'A', '2', '4'),
+    BGRA8888 = fourcc('B', 'A', '2', '4'),
+
+    XRGB2101010 = fourcc('X', 'R', '3', '0'),
+    XBGR2101010 = fourcc('X', 'B', '3', '0'),
+    RGBX1010102 = fourcc('R', 'X', '3', '0'),
+    BGRX1010102 = fourcc('B', 'X', '3', '0'),
+    ARGB2101010 = fourcc('A', 'R', '3', '0'),
+    ABGR2101010 = fourcc('A', 'B', '3', '0'),
+    RGBA1010102 = fourcc('R', 'A', '3', '0'),
+    BGRA1010102 = fourcc('B', 'A', '3', '0'),
+
+    XRGB16161616 = fourcc('X', 'R', '4', '8'),
+    XBGR16161616 = fourcc('X', 'B', '4', '8'),
+    ARGB16161616 = fourcc('A', 'R', '4', '8'),
+    ABGR16161616 = fourcc('A', 'B', '4', '8'),
+    XRGB16161616F = fourcc('X', 'R', '4', 'H'),
+    XBGR16161616F = fourcc('X', 'B', '4', 'H'),
+    ARGB16161616F = fourcc('A', 'R', '4', 'H'),
+    ABGR16161616F = fourcc('A', 'B', '4', 'H'),
+
+    YUYV = fourcc('Y', 'U', 'Y', 'V'),
+    YVYU = fourcc('Y', 'V', 'Y', 'U'),
+    UYVY = fourcc('U', 'Y', 'V', 'Y'),
+    VYUY = fourcc('V', 'Y', 'U', 'Y'),
+    AYUV = fourcc('A', 'Y', 'U', 'V'),
+    XYUV8888 = fourcc('X', 'Y', 'U', 'V'),
+    VUY888 = fourcc('V', 'U', '2', '4'),
+
+    NV12 = fourcc('N', 'V', '1', '2'),
+    NV21 = fourcc('N', 'V', '2', '1'),
+    NV16 = fourcc('N', 'V', '1', '6'),
+    NV61 = fourcc('N', 'V', '6', '1'),
+    NV24 = fourcc('N', 'V', '2', '4'),
+    NV42 = fourcc('N', 'V', '4', '2'),
+    P010 = fourcc('P', '0', '1', '0'),
+    P012 = fourcc('P', '0', '1', '2'),
+    P016 = fourcc('P', '0', '1', '6'),
+
+    YUV410 = fourcc('Y', 'U', 'V', '9'),
+    YVU410 = fourcc('Y', 'V', 'U', '9'),
+    YUV411 = fourcc('Y', 'U', '1', '1'),
+    YVU411 = fourcc('Y', 'V', '1', '1'),
+    YUV420 = fourcc('Y', 'U', '1', '2'),
+    YVU420 = fourcc('Y', 'V', '1', '2'),
+    YUV422 = fourcc('Y', 'U', '1', '6'),
+    YVU422 = fourcc('Y', 'V', '1', '6'),
+    YUV444 = fourcc('Y', 'U', '2', '4'),
+    YVU444 = fourcc('Y', 'V', '2', '4'),
 };
 
-inline const char* format_to_str(const Format format) {
-    switch (format) {
-        case Format::ARGB8888: return "ARGB8888";
-        case Format::XRGB8888: return "XRGB8888";
-        case Format::C8: return "C8";
-        case Format::RGB332: return "RGB332";
-        case Format::BGR233: return "BGR233";
-        case Format::XRGB4444: return "XRGB4444";
-        default: return "Unknown format";
+/**
+    @brief Static description of a pixel format.
+*/
+struct format_info {
+    Format format;
+    const char* name;
+
+    /**
+        Bits per pixel, averaged over all planes for
+        subsampled formats (e.g. 12 for NV12).
+    */
+    uint8_t bpp;
+
+    uint8_t planes;
+    bool alpha;
+};
+
+inline constexpr format_info FORMAT_INFO[] = {
+    { Format::ARGB8888, "ARGB8888", 32, 1, true },
+    { Format::XRGB8888, "XRGB8888", 32, 1, false },
+
+    { Format::C8, "C8", 8, 1, false },
+    { Format::R8, "R8", 8, 1, false },
+    { Format::R16, "R16", 16, 1, false },
+    { Format::RG88, "RG88", 16, 1, false },
+    { Format::GR88, "GR88", 16, 1, false },
+    { Format::RG1616, "RG1616", 32, 1, false },
+    { Format::GR1616, "GR1616", 32, 1, false },
+
+    { Format::RGB332, "RGB332", 8, 1, false },
+    { Format::BGR233, "BGR233", 8, 1, false },
+
+    { Format::XRGB4444, "XRGB4444", 16, 1, false },
+    { Format::XBGR4444, "XBGR4444", 16, 1, false },
+    { Format::RGBX4444, "RGBX4444", 16, 1, false },
+    { Format::BGRX4444, "BGRX4444", 16, 1, false },
+    { Format::ARGB4444, "ARGB4444", 16, 1, true },
+    { Format::ABGR4444, "ABGR4444", 16, 1, true },
+    { Format::RGBA4444, "RGBA4444", 16, 1, true },
+    { Format::BGRA4444, "BGRA4444", 16, 1, true },
+
+    { Format::XRGB1555, "XRGB1555", 16, 1, false },
+    { Format::XBGR1555, "XBGR1555", 16, 1, false },
+    { Format::RGBX5551, "RGBX5551", 16, 1, false },
+    { Format::BGRX5551, "BGRX5551", 16, 1, false },
+    { Format::ARGB1555, "ARGB1555", 16, 1, true },
+    { Format::ABGR1555, "ABGR1555", 16, 1, true },
+    { Format::RGBA5551, "RGBA5551", 16, 1, true },
+    { Format::BGRA5551, "BGRA5551", 16, 1, true },
+
+    { Format::RGB565, "RGB565", 16, 1, false },
+    { Format::BGR565, "BGR565", 16, 1, false },
+
+    { Format::RGB888, "RGB888", 24, 1, false },
+    { Format::BGR888, "BGR888", 24, 1, false },
+
+    { Format::XBGR8888, "XBGR8888", 32, 1, false },
+    { Format::RGBX8888, "RGBX8888", 32, 1, false },
+    { Format::BGRX8888, "BGRX8888", 32, 1, false },
+    { Format::ABGR8888, "ABGR8888", 32, 1, true },
+    { Format::RGBA8888, "RGBA8888", 32, 1, true },
+    { Format::BGRA8888, "BGRA8888", 32, 1, true },
+
+    { Format::XRGB2101010, "XRGB2101010", 32, 1, false },
+    { Format::XBGR2101010, "XBGR2101010", 32, 1, false },
+    { Format::RGBX1010102, "RGBX1010102", 32, 1, false },
+    { Format::BGRX1010102, "BGRX1010102", 32, 1, false },
+    { Format::ARGB2101010, "ARGB2101010", 32, 1, true },
+    { Format::ABGR2101010, "ABGR2101010", 32, 1, true },
+    { Format::RGBA1010102, "RGBA1010102", 32, 1, true },
+    { Format::BGRA1010102, "BGRA1010102", 32, 1, true },
+
+    { Format::XRGB16161616, "XRGB16161616", 64, 1, false },
+    { Format::XBGR16161616, "XBGR16161616", 64, 1, false },
+    { Format::ARGB16161616, "ARGB16161616", 64, 1, true },
+    { Format::ABGR16161616, "ABGR16161616", 64, 1, true },
+    { Format::XRGB16161616F, "XRGB16161616F", 64, 1, false },
+    { Format::XBGR16161616F, "XBGR16161616F", 64, 1, false },
+    { Format::ARGB16161616F, "ARGB16161616F", 64, 1, true },
+    { Format::ABGR16161616F, "ABGR16161616F", 64, 1, true },
+
+    { Format::YUYV, "YUYV", 16, 1, false },
+    { Format::YVYU, "YVYU", 16, 1, false },
+    { Format::UYVY, "UYVY", 16, 1, false },
+    { Format::VYUY, "VYUY", 16, 1, false },
+    { Format::AYUV, "AYUV", 32, 1, true },
+    { Format::XYUV8888, "XYUV8888", 32, 1, false },
+    { Format::VUY888, "VUY888", 24, 1, false },
+
+    { Format::NV12, "NV12", 12, 2, false },
+    { Format::NV21, "NV21", 12, 2, false },
+    { Format::NV16, "NV16", 16, 2, false },
+    { Format::NV61, "NV61", 16, 2, false },
+    { Format::NV24, "NV24", 24, 2, false },
+    { Format::NV42, "NV42", 24, 2, false },
+    { Format::P010, "P010", 24, 2, false },
+    { Format::P012, "P012", 24, 2, false },
+    { Format::P016, "P016", 24, 2, false },
+
+    { Format::YUV410, "YUV410", 9, 3, false },
+    { Format::YVU410, "YVU410", 9, 3, false },
+    { Format::YUV411, "YUV411", 12, 3, false },
+    { Format::YVU411, "YVU411", 12, 3, false },
+    { Format::YUV420, "YUV420", 12, 3, false },
+    { Format::YVU420, "YVU420", 12, 3, false },
+    { Format::YUV422, "YUV422", 16, 3, false },
+    { Format::YVU422, "YVU422", 16, 3, false },
+    { Format::YUV444, "YUV444", 24, 3, false },
+    { Format::YVU444, "YVU444", 24, 3, false },
+};
+
+/**
+    @brief Looks up @p format in `FORMAT_INFO`.
+
+    @returns `nullptr` for formats not in the table.
+*/
+inline const format_info* find_format_info(const Format format) {
+    for (const format_info& info : FORMAT_INFO) {
+        if (info.format == format) {
+            return &info;
+        }
     }
-}
\ No newline at end of file
+
+    return nullptr;
+}
+
+/**
+    @brief Bytes per row of a single-plane format, or 0
+    for multi-planar and unknown formats.
+*/
+inline size_t format_stride(const Format format, const uint32_t width) {
+    const format_info* info = find_format_info(format);
+
+    if (!info || info->planes != 1) { return 0; }
+
+    return static_cast<size_t>(width) * info->bpp / 8;
+}
+
+inline const char* format_to_str(const Format format) {
+    const format_info* info = find_format_info(format);
+    return info ? info->name : "Unknown format";
+}
@@ -1,4 +1,5 @@
 #include "wl_event.h"
+#include "wl_state.h"
 
 
 wl_message::wl_message(
@@ -55,6 +56,18 @@ wl_string wl_message::reader::read_string() {
     return value;
 }
 
+wl_fd_t wl_message::reader::read_fd() {
+    // Sent out of band, so it takes up no space in the payload.
+    return recv_queue.TakeFD();
+}
+
+wl_message::reader::array_view wl_message::reader::read_array_view() {
+    const wl_uint array_size = read_wl_uint(cursor);
+    const array_view value { .data = cursor + WL_UINT_SIZE, .size = array_size };
+    advance_cursor(WL_UINT_SIZE + wl_align(array_size));
+    return value;
+}
+
 void wl_message::writer::advance_cursor(const wl_uint bytes) {
     cursor += bytes;
     if (cursor - data > size) {
@@ -51,6 +51,15 @@ class wl_message::reader {
 
     public:
 
+    /**
+        @brief A wl_array argument, read in place. Only
+        valid as long as the message it was read from.
+    */
+    struct array_view {
+        const char* data = nullptr;
+        wl_uint size = 0;
+    };
+
     reader(const value_ptr data, const size_type payload_size);
 
     wl_uint read_uint();
@@ -63,6 +72,14 @@ class wl_message::reader {
 
     wl_string read_string();
 
+    /**
+        @brief Takes the file descriptor sent with the
+        message. The caller owns it.
+    */
+    wl_fd_t read_fd();
+
+    array_view read_array_view();
+
 	template<class T>
 	wl_array<T> read_array();
 
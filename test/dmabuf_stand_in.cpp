@@ -0,0 +1,312 @@
+#include "objects/linux-dma-buf.h"
+#include "buffers/memfd.h"
+#include "buffers/udmabuf.h"
+
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+    @brief Drives the linux-dmabuf client objects against a
+    stand-in compositor on the other end of a socketpair.
+
+    The stand-in decodes what the client sends (requests,
+    arguments and SCM_RIGHTS fds) and answers with the
+    events a compositor would: pre-v4 format and modifier
+    events, `created` and `failed` for `create`, and
+    wl_buffer.release. Pixel memory comes from /dev/udmabuf
+    when it opens, and from a plain memfd otherwise, which
+    is enough to check that the stand-in maps the same
+    memory the client wrote.
+
+    Built and run with `make test`.
+*/
+
+namespace {
+    int failures = 0;
+
+    void check(const bool condition, const char* what) {
+        std::printf("%s %s\n", condition ? "ok  " : "FAIL", what);
+
+        if (!condition) {
+            failures++;
+        }
+    }
+
+    /** A decoded request, as the compositor sees it. */
+    struct request {
+        wl_object object;
+        wl_uint opcode;
+        std::vector<wl_uint> args;
+    };
+
+    /**
+        The compositor end. Only understands the requests
+        this test sends, which all carry plain words.
+    */
+    class stand_in {
+        const int socket;
+
+        std::vector<char> outgoing;
+
+        public:
+
+        /** Fds received with the last `receive`, in order. */
+        std::vector<int> fds;
+
+        explicit stand_in(const int socket) : socket(socket) {}
+
+        ~stand_in() {
+            for (const int fd : fds) {
+                close(fd);
+            }
+        }
+
+        std::vector<request> receive() {
+            char data[4096];
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 28)];
+
+            iovec vec { .iov_base = data, .iov_len = sizeof(data) };
+            msghdr msg {
+                .msg_iov = &vec,
+                .msg_iovlen = 1,
+                .msg_control = control,
+                .msg_controllen = sizeof(control),
+            };
+
+            const ssize_t size = recvmsg(socket, &msg, MSG_CMSG_CLOEXEC);
+
+            for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+                const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                const int* received = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+                fds.insert(fds.end(), received, received + count);
+            }
+
+            std::vector<request> requests;
+
+            for (ssize_t offset = 0; offset + 8 <= size;) {
+                wl_uint header[2];
+                memcpy(header, data + offset, sizeof(header));
+
+                const wl_uint length = header[1] >> 16;
+                request& decoded = requests.emplace_back(request { header[0], header[1] & 0xFFFF, {} });
+                decoded.args.resize((length - 8) / 4);
+                memcpy(decoded.args.data(), data + offset + 8, length - 8);
+
+                offset += length;
+            }
+
+            return requests;
+        }
+
+        void event(const wl_object object, const wl_uint opcode, const std::vector<wl_uint>& args) {
+            const wl_uint header[2] = { object, wl_uint((8 + args.size() * 4) << 16) | opcode };
+
+            outgoing.insert(outgoing.end(), reinterpret_cast<const char*>(header), reinterpret_cast<const char*>(header + 2));
+            outgoing.insert(outgoing.end(), reinterpret_cast<const char*>(args.data()), reinterpret_cast<const char*>(args.data() + args.size()));
+        }
+
+        void flush() {
+            if (write(socket, outgoing.data(), outgoing.size()) != ssize_t(outgoing.size())) {
+                std::perror("stand-in write");
+            }
+
+            outgoing.clear();
+        }
+    };
+
+    /** What display.read_queues does, minus the wl_display. */
+    void dispatch(const int socket) {
+        recv_queue.Recv(socket);
+
+        for (const wl_message msg : recv_queue) {
+            std::shared_ptr<wl_obj*> object = wl_id_map.get(msg.object_id);
+
+            if (!object) {
+                std::printf("     event for unknown object %u\n", msg.object_id);
+                continue;
+            }
+
+            (*object)->handle_event(msg.opcode, wl_message::reader(msg.payload, msg.size - WL_EVENT_HEADER_SIZE));
+        }
+    }
+
+    /** Pixel memory to share, as a dmabuf where possible. */
+    struct pixels {
+        std::optional<wl::udmabuf> dma;
+        std::optional<wl::memfd> memory;
+
+        explicit pixels(const size_t size) {
+            if (wl::udmabuf::available()) {
+                dma = wl::udmabuf::create(size);
+            } else {
+                memory = wl::memfd::create(size);
+            }
+        }
+
+        int fd() const noexcept {
+            return dma ? dma->fd() : memory->fd();
+        }
+
+        uint8_t* data() const noexcept {
+            return dma ? dma->data() : memory->data();
+        }
+    };
+
+    constexpr wl_int WIDTH = 64;
+    constexpr wl_int HEIGHT = 32;
+    constexpr wl_uint STRIDE = WIDTH * 4;
+
+    /** Intel X-tiled, so both halves of the modifier are set. */
+    constexpr uint64_t TILED_MODIFIER = 0x0100000000000001;
+
+    std::vector<std::pair<wl_uint, uint64_t>> advertised;
+    wl_buffer* created_buffer = nullptr;
+    bool failed = false;
+
+    struct zwp::linux_dmabuf::dmabuf::listener dmabuf_listener {
+        .format = [](zwp::linux_dmabuf::dmabuf& dmabuf, const wl_uint format) {},
+        .modifier = [](zwp::linux_dmabuf::dmabuf& dmabuf, const wl_uint format, const uint64_t modifier) {
+            advertised.emplace_back(format, modifier);
+        },
+    };
+
+    struct zwp::linux_dmabuf::params::listener params_listener {
+        .created = [](zwp::linux_dmabuf::params& params, wl_buffer& buffer) {
+            created_buffer = &buffer;
+        },
+        .failed = [](zwp::linux_dmabuf::params& params) {
+            failed = true;
+        },
+    };
+}
+
+int main() {
+    int sockets[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) < 0) {
+        std::perror("socketpair");
+        return 1;
+    }
+
+    const int client = sockets[0];
+    stand_in compositor(sockets[1]);
+
+    std::printf("pixels from %s\n", wl::udmabuf::available() ? "/dev/udmabuf" : "memfd");
+
+    // As if bound from the registry at version 3.
+    zwp::linux_dmabuf::dmabuf dmabuf(wl_id_assigner.request_id());
+    dmabuf.listener = &dmabuf_listener;
+    wl_id_map.create(dmabuf);
+
+    compositor.event(dmabuf.ID(), 0, { DRM_FORMAT_ARGB8888 });
+    compositor.event(dmabuf.ID(), 1, { DRM_FORMAT_ARGB8888, 0, 0 });
+    compositor.event(dmabuf.ID(), 1, { DRM_FORMAT_XRGB8888, wl_uint(TILED_MODIFIER >> 32), wl_uint(TILED_MODIFIER & 0xFFFFFFFF) });
+    compositor.flush();
+    dispatch(client);
+
+    check(advertised.size() == 2, "modifier events reach the listener");
+    check(advertised.size() == 2 && advertised[0] == std::pair<wl_uint, uint64_t>(DRM_FORMAT_ARGB8888, DRM_FORMAT_MOD_LINEAR), "linear ARGB8888 decoded");
+    check(advertised.size() == 2 && advertised[1] == std::pair<wl_uint, uint64_t>(DRM_FORMAT_XRGB8888, TILED_MODIFIER), "modifier hi and lo words joined");
+
+    pixels frame(size_t(STRIDE) * HEIGHT);
+
+    if (frame.dma) {
+        frame.dma->begin_cpu_access();
+    }
+
+    for (size_t i = 0; i < size_t(STRIDE) * HEIGHT; i++) {
+        frame.data()[i] = uint8_t(i * 7);
+    }
+
+    if (frame.dma) {
+        frame.dma->end_cpu_access();
+    }
+
+    // create_immed: the buffer exists without a round trip.
+    zwp::linux_dmabuf::params& immed_params = dmabuf.create_params();
+    immed_params.add(frame.fd(), 0, 0, STRIDE, DRM_FORMAT_MOD_LINEAR);
+    wl_buffer& immed = immed_params.create_immed(WIDTH, HEIGHT, DRM_FORMAT_ARGB8888, 0);
+    immed_params.destroy();
+    send_queue.Send(client);
+
+    const std::vector<request> requests = compositor.receive();
+
+    check(requests.size() == 4, "create_params, add, create_immed and destroy arrive");
+
+    if (requests.size() == 4) {
+        check(requests[0].object == dmabuf.ID() && requests[0].opcode == 1 && requests[0].args == std::vector<wl_uint> { immed_params.ID() }, "create_params carries the new id");
+        check(requests[1].object == immed_params.ID() && requests[1].opcode == 1 && requests[1].args == std::vector<wl_uint> { 0, 0, STRIDE, 0, 0 }, "add carries plane, offset, stride and modifier");
+        check(requests[2].opcode == 3 && requests[2].args == std::vector<wl_uint> { immed.ID(), WIDTH, HEIGHT, DRM_FORMAT_ARGB8888, 0 }, "create_immed carries id, size, format and flags");
+        check(requests[3].opcode == 0 && requests[3].args.empty(), "destroy has no arguments");
+    }
+
+    check(compositor.fds.size() == 1, "one fd per plane over SCM_RIGHTS");
+
+    if (compositor.fds.size() == 1) {
+        struct stat info {};
+        fstat(compositor.fds[0], &info);
+        check(size_t(info.st_size) >= size_t(STRIDE) * HEIGHT, "the fd covers the frame");
+
+        void* mapped = mmap(nullptr, size_t(STRIDE) * HEIGHT, PROT_READ, MAP_SHARED, compositor.fds[0], 0);
+        check(mapped != MAP_FAILED && memcmp(mapped, frame.data(), size_t(STRIDE) * HEIGHT) == 0, "the compositor sees the client's pixels");
+
+        if (mapped != MAP_FAILED) {
+            munmap(mapped, size_t(STRIDE) * HEIGHT);
+        }
+    }
+
+    // Release clears the busy flag a commit would have set.
+    immed.is_busy = true;
+    compositor.event(immed.ID(), 0, {});
+    compositor.flush();
+    dispatch(client);
+
+    check(!immed.is_busy, "release clears busy");
+
+    // create: answered by created, with a buffer id from the compositor's range.
+    zwp::linux_dmabuf::params& async_params = dmabuf.create_params();
+    async_params.listener = &params_listener;
+    async_params.add(frame.fd(), 0, 0, STRIDE, DRM_FORMAT_MOD_LINEAR);
+    async_params.create(WIDTH, HEIGHT, DRM_FORMAT_ARGB8888, 0);
+    send_queue.Send(client);
+
+    const std::vector<request> create_requests = compositor.receive();
+    check(create_requests.size() == 3 && create_requests[2].opcode == 2 && create_requests[2].args == std::vector<wl_uint> { WIDTH, HEIGHT, DRM_FORMAT_ARGB8888, 0 }, "create carries size, format and flags");
+
+    constexpr wl_object SERVER_ID = 0xFF000000;
+    compositor.event(async_params.ID(), 0, { SERVER_ID });
+    compositor.flush();
+    dispatch(client);
+
+    check(created_buffer && created_buffer->ID() == SERVER_ID, "created hands over the compositor's buffer");
+    check(wl_id_map.get(SERVER_ID) != nullptr, "the created buffer is registered");
+
+    // create: answered by failed.
+    zwp::linux_dmabuf::params& rejected_params = dmabuf.create_params();
+    rejected_params.listener = &params_listener;
+    rejected_params.add(frame.fd(), 0, 0, STRIDE, TILED_MODIFIER);
+    rejected_params.create(WIDTH, HEIGHT, DRM_FORMAT_XRGB8888, 0);
+    send_queue.Send(client);
+
+    const std::vector<request> rejected_requests = compositor.receive();
+    check(rejected_requests.size() == 3 && rejected_requests[1].args == std::vector<wl_uint> { 0, 0, STRIDE, wl_uint(TILED_MODIFIER >> 32), wl_uint(TILED_MODIFIER & 0xFFFFFFFF) }, "add splits the modifier into hi and lo");
+
+    compositor.event(rejected_params.ID(), 1, {});
+    compositor.flush();
+    dispatch(client);
+
+    check(failed, "failed reaches the listener");
+
+    close(client);
+
+    std::printf("\n%s\n", failures == 0 ? "all passed" : "FAILED");
+
+    return failures == 0 ? 0 : 1;
+}